@@ -71,6 +71,7 @@ typedef uint8_t arch_atomic_t;
  * handling code */
 typedef uint16_t arch_ticks_t;
 #define ARCH_TICKS_MAX ((arch_ticks_t)UINT16_MAX)
+#define ARCH_TICKS_WIDTH 16
 
 typedef uint8_t arch_criticalstate_t; /* size of AVR status register */
 
@@ -477,6 +478,7 @@ uint_fast8_t arch_bitmask_fls(arch_bitmask_t bitfield);
 #endif
 
 /** Interrupt leave code. This function has to:
+ * - run pending softirqs in case of most outer ISR (os_softirq_isrexit)
  * - disable IE (in case the architecture allows for nesting)
  * - decrement the isr_nesting
  * - if isr_nesting = 0 then
@@ -487,6 +489,8 @@ uint_fast8_t arch_bitmask_fls(arch_bitmask_t bitfield);
  */
 #ifndef __AVR_3_BYTE_PC__
 #define arch_contextrestore_i(_isrName) \
+   do { \
+   os_softirq_isrexit(); \
    __asm__ __volatile__ ( \
       /* disable interrupts in case we add nesting interrupt support */ \
       "cli                           \n\t" \
@@ -567,7 +571,8 @@ uint_fast8_t arch_bitmask_fls(arch_bitmask_t bitfield);
        * after reti and we can use ISR's to implement OS single stepping \
        * debugger */ \
       "reti                         \n\t" \
-      :: )
+      :: ); \
+   } while (0)
 #else
 # error CPUs with extended memory registers are not supported yet
 /*      "pop r0                       \n\t" \
@@ -32,6 +32,7 @@
 #include "os_private.h"
 
 #include <sched.h> /* sched_yield used only here */
+#include <time.h> /* POSIX timers for hrtimer emulation */
 
 /* this port is compatible only with 64bit Linux */
 OS_STATIC_ASSERT(sizeof(unsigned long) == sizeof(uint64_t));
@@ -40,6 +41,9 @@ OS_STATIC_ASSERT(sizeof(unsigned long) == sizeof(uint64_t));
  *  to set/unset the signal mask in fast way */
 sigset_t arch_crit_signals;
 
+/** Nesting level of zero-latency interrupts */
+volatile sig_atomic_t arch_zerolat_nesting = 0;
+
 /** This function is x86 port specific.
  *  To make atomic signal masking and task switch we must use the signal
  *  service, for that we use SIGUSR1 */
@@ -76,11 +80,14 @@ void arch_os_init(void)
 
    /* prepare the global set for signals masked during critical sections
     * we cannot be interrupted by any signal, beside SIGUSR1 used as a helper
-    * for context switching */
+    * for context switching and zero-latency signal which is above the OS
+    * interrupt threshold */
    ret = sigfillset(&arch_crit_signals);
    OS_SELFCHECK_ASSERT(0 == ret);
    ret = sigdelset(&arch_crit_signals, SIGUSR1);
    OS_SELFCHECK_ASSERT(0 == ret);
+   ret = sigdelset(&arch_crit_signals, ARCH_ZEROLAT_SIGNAL);
+   OS_SELFCHECK_ASSERT(0 == ret);
    /* now we have the signal mask which we would like to use for critical
     * sections, but not all of signals can be masked out (SIGKILL or SIGSTOP
     * cannot be masked out). So to get the set which could be used for compare
@@ -216,3 +223,63 @@ bool arch_is_dint(void)
    return !memcmp(&current_mask, &arch_crit_signals, sizeof(sigset_t));
 }
 
+
+#ifdef OS_CONFIG_HRTIMER
+/** POSIX timer which emulates the one-shot hardware timer */
+static timer_t arch_hrtimer;
+
+/** Signal handler for ARCH_HRTIMER_SIGNAL, works as timer compare ISR */
+static void OS_ISR arch_sig_hrtimer(
+   int OS_UNUSED(signum),
+   siginfo_t *OS_UNUSED(siginfo),
+   void *ucontext)
+{
+   arch_contextstore_i(arch_sig_hrtimer);
+   os_hrtimer_isr();
+   arch_contextrestore_i(arch_sig_hrtimer);
+}
+
+void arch_hrtimer_init(void)
+{
+   int ret;
+   struct sigevent sev = {
+      .sigev_notify  = SIGEV_SIGNAL,
+      .sigev_signo   = ARCH_HRTIMER_SIGNAL,
+   };
+   struct sigaction hrtimer_sigaction = {
+      .sa_sigaction  = arch_sig_hrtimer,
+      .sa_mask       = arch_crit_signals, /* same as for other kernel-aware
+                                           * interrupts */
+      .sa_flags      = SA_SIGINFO,
+   };
+
+   ret = sigaction(ARCH_HRTIMER_SIGNAL, &hrtimer_sigaction, NULL);
+   OS_SELFCHECK_ASSERT(0 == ret);
+   ret = timer_create(CLOCK_MONOTONIC, &sev, &arch_hrtimer);
+   OS_SELFCHECK_ASSERT(0 == ret);
+}
+
+uint64_t arch_hrtimer_now(void)
+{
+   struct timespec ts;
+
+   (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+void arch_hrtimer_arm(uint64_t deadline_ns)
+{
+   int ret;
+   struct itimerspec its = {
+      .it_interval   = { .tv_sec = 0, .tv_nsec = 0 },
+      .it_value      = {
+         .tv_sec     = (time_t)(deadline_ns / 1000000000ULL),
+         .tv_nsec    = (long)(deadline_ns % 1000000000ULL),
+      }
+   };
+
+   /* absolute deadline from the past expires immediately */
+   ret = timer_settime(arch_hrtimer, TIMER_ABSTIME, &its, NULL);
+   OS_SELFCHECK_ASSERT(0 == ret);
+}
+#endif
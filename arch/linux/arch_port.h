@@ -63,11 +63,12 @@ typedef struct {
 typedef sig_atomic_t arch_atomic_t;
 #define ARCH_ATOMIC_MAX SIG_ATOMIC_MAX
 
-/** Architecture dependent tick type definition, uint16 is enough but to make
- * it convenient for 32-bit and 64-bit CPUs, we use uint_fast16_t (so it will be
- * the smallest and fastest type for particular CPU */
-typedef uint_fast16_t arch_ticks_t;
-#define ARCH_TICKS_MAX ((arch_ticks_t)UINT16_MAX)
+/** Architecture dependent tick type definition. This port supports only 64bit
+ * CPUs, so 64bit ticks can be read atomically and they never overflow in
+ * practice */
+typedef uint64_t arch_ticks_t;
+#define ARCH_TICKS_MAX ((arch_ticks_t)UINT64_MAX)
+#define ARCH_TICKS_WIDTH 64
 
 typedef sigset_t arch_criticalstate_t;
 /** signal set used to mask Linux port sensitive signals
@@ -75,6 +76,20 @@ typedef sigset_t arch_criticalstate_t;
  */
 extern sigset_t arch_crit_signals;
 
+/** Zero-latency interrupt signal. Linux port models the OS interrupt priority
+ * threshold (like BASEPRI on ARM Cortex-M) by two signal sets. Signals from
+ * arch_crit_signals are kernel-aware interrupts which are masked by
+ * arch_critical_enter(). ARCH_ZEROLAT_SIGNAL is above the threshold, it is
+ * never masked by OS, so it preempts even the OS critical sections. Because of
+ * this its handler cannot call any OS function, handler has to mark its scope
+ * by arch_zerolat_enter() and arch_zerolat_exit() so such calls are caught by
+ * arch_critical_enter(). Handler should be installed with arch_crit_signals as
+ * sa_mask, so kernel-aware interrupts cannot preempt it */
+#define ARCH_ZEROLAT_SIGNAL SIGUSR2
+
+/** nesting level of zero-latency interrupts, see ARCH_ZEROLAT_SIGNAL */
+extern volatile sig_atomic_t arch_zerolat_nesting;
+
 /* since linux support only arch with > 32 bits we could use uint32_t.
  * but since we did not use more than 8 prios we stick to uint8_t */
 typedef uint8_t arch_bitmask_t;
@@ -164,6 +179,10 @@ static inline uint_fast8_t arch_bitmask_fls(arch_bitmask_t bitfield)
 
 #define arch_critical_enter(_critical_state) \
    do { \
+      /* zero-latency handlers cannot enter OS critical section, since they \
+       * preempt OS in any point */ \
+      if (OS_UNLIKELY(0 != arch_zerolat_nesting)) \
+         os_halt(); \
       /* previous signal mask will be stored under _critical_state */ \
       sigprocmask(SIG_BLOCK, &arch_crit_signals, &(_critical_state)); \
    } while (0)
@@ -183,10 +202,37 @@ static inline uint_fast8_t arch_bitmask_fls(arch_bitmask_t bitfield)
       (void)sigprocmask(SIG_UNBLOCK, &arch_crit_signals, NULL); \
    } while (0)
 
+#define arch_zerolat_enter() \
+   do { \
+      ++arch_zerolat_nesting; \
+   } while (0)
+
+#define arch_zerolat_exit() \
+   do { \
+      --arch_zerolat_nesting; \
+   } while (0)
+
 /* that's quite heavy function in this arch, since we need to call several
  * functions. Decided not to make it inline */
 bool arch_is_dint(void);
 
+/** This port provides the one-shot high resolution timer used by os_hrtimer.
+ * It is emulated by POSIX timer on CLOCK_MONOTONIC which generates
+ * ARCH_HRTIMER_SIGNAL (kernel-aware interrupt) at the absolute deadline */
+#define ARCH_HAS_HRTIMER
+#define ARCH_HRTIMER_SIGNAL SIGVTALRM
+
+/** Creates the host timer and installs the ISR which calls os_hrtimer_isr() */
+void arch_hrtimer_init(void);
+
+/** Returns the current time of CLOCK_MONOTONIC in nanoseconds */
+uint64_t arch_hrtimer_now(void);
+
+/** Arms the one-shot host timer at absolute time deadline_ns (in
+ * arch_hrtimer_now() domain). Deadline in the past fires immediately, 0
+ * disarms the timer */
+void arch_hrtimer_arm(uint64_t deadline_ns);
+
 /* This function has to:
  *  - if necessary, disable interrupts to block the nesting
  *  - store all registers (power control bits do not have to be necessarily
@@ -239,6 +285,7 @@ bool arch_is_dint(void);
    } while (0)
 
 /* This function has to:
+ * - run pending softirqs in case of most outer ISR (os_softirq_isrexit)
  * - disable IE (in case the architecture allows for nesting)
  * - decrement the isr_nesting
  * - if isr_nesting = 0 then
@@ -259,6 +306,7 @@ bool arch_is_dint(void);
  *    enter nested ISR) */
 #define arch_contextrestore_i(_isrName) \
    do { \
+      os_softirq_isrexit(); \
       arch_dint(); \
       if (0 == (--isr_nesting)) { \
          memcpy(&(((ucontext_t*)ucontext)->uc_stack), \
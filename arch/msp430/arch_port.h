@@ -74,6 +74,7 @@ typedef uint16_t arch_atomic_t;
 
 typedef uint16_t arch_ticks_t;         /* exactly 16 bits */
 #define ARCH_TICKS_MAX ((arch_ticks_t)UINT16_MAX)
+#define ARCH_TICKS_WIDTH 16
 typedef uint16_t arch_criticalstate_t; /* size of CPU status register */
 
 /* msp430 does not support cpu op for ffs */
@@ -396,6 +397,7 @@ uint_fast8_t arch_bitmask_fls(arch_bitmask_t bitfield);
 
 /**
  * This function have to:
+ *  - run pending softirqs in case of most outer ISR (os_softirq_isrexit)
  *  - disable IE (in case we architecture allows for nesting)
  *  - decrement the isr_nesting
  *  - if isr_nesting = 0 then
@@ -414,6 +416,8 @@ uint_fast8_t arch_bitmask_fls(arch_bitmask_t bitfield);
  *  - in case of nested the was also for sure enabled (from the same reason, we
  *    enter nested ISR) */
 #define arch_contextrestore_i(_isrName) \
+   do { \
+   os_softirq_isrexit(); \
    __asm__ __volatile__ ( \
       /* disable interrupts in case some ISR will implement nesting interrupt \
        * handling */ \
@@ -436,7 +440,8 @@ uint_fast8_t arch_bitmask_fls(arch_bitmask_t bitfield);
       ::  [ctx] "m" (task_current), \
       [isr_nesting] "m" (isr_nesting), \
       [iebits] "i" (GIE), \
-      [powerbits] "i" (SCG1 + SCG0 + OSCOFF + CPUOFF))
+      [powerbits] "i" (SCG1 + SCG0 + OSCOFF + CPUOFF)); \
+   } while (0)
 
 #endif /* __OS_PORT_ */
 
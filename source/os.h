@@ -37,10 +37,25 @@
 #include "os_config.h"
 #include "os_protected.h"
 #include "os_timer.h"
+#include "os_hrtimer.h"
 #include "os_sched.h"
+#include "os_partition.h"
+#include "os_cyclic.h"
 #include "os_sem.h"
 #include "os_mtx.h"
+#include "os_rwlock.h"
 #include "os_waitqueue.h"
+#include "os_waitany.h"
+#include "os_futex.h"
+#include "os_notify.h"
+#include "os_evflags.h"
+#include "os_pool.h"
+#include "os_heap.h"
+#include "os_buf.h"
+#include "os_mbox.h"
+#include "os_stream.h"
+#include "os_softirq.h"
+#include "os_isrpost.h"
 
 /* needs to be visible to user because of arch_contextstore_i macros */
 extern os_task_t *task_current;
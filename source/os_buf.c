@@ -0,0 +1,189 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_BUF
+
+/* --- private functions --- */
+
+/**
+ * Function initializes the buffer taken from pool
+ */
+static os_buf_t *os_buf_init(
+   os_pool_t *pool,
+   os_buf_t *buf,
+   size_t headroom)
+{
+   if (buf) {
+      buf->next = NULL;
+      buf->pool = pool;
+      buf->size = pool->block_size - sizeof(os_buf_t);
+      OS_ASSERT(headroom <= buf->size);
+      buf->offset = headroom;
+      buf->len = 0;
+      buf->refcnt = 1;
+   }
+
+   return buf;
+}
+
+/* --- public functions --- */
+/* all public functions are documented in os_buf.h file */
+
+os_buf_t *os_buf_alloc(
+   os_pool_t *pool,
+   size_t headroom)
+{
+   OS_ASSERT(pool->block_size > sizeof(os_buf_t));
+
+   return os_buf_init(pool, (os_buf_t*)os_pool_alloc(pool), headroom);
+}
+
+os_buf_t *os_buf_alloc_wait(
+   os_pool_t *pool,
+   size_t headroom,
+   os_ticks_t timeout_ticks)
+{
+   OS_ASSERT(pool->block_size > sizeof(os_buf_t));
+
+   return os_buf_init(
+      pool, (os_buf_t*)os_pool_alloc_wait(pool, timeout_ticks), headroom);
+}
+
+void os_buf_unref(os_buf_t *buf)
+{
+   os_buf_t *next;
+
+   /* each buffer holds the reference to the next one, so we continue along
+    * the chain only while we release the last reference */
+   while (buf) {
+      OS_ASSERT(buf->refcnt > 0);
+      if (0 != os_atomic_dec_load(&(buf->refcnt)))
+         break;
+
+      next = buf->next;
+      os_pool_free(buf->pool, buf);
+      buf = next;
+   }
+}
+
+void os_buf_chain(
+   os_buf_t *buf,
+   os_buf_t *next)
+{
+   while (buf->next)
+      buf = buf->next;
+   buf->next = next;
+}
+
+size_t os_buf_chain_len(os_buf_t *buf)
+{
+   size_t len = 0;
+
+   for (; buf; buf = buf->next)
+      len += buf->len;
+
+   return len;
+}
+
+size_t os_buf_copyout(
+   os_buf_t *buf,
+   size_t offset,
+   void *dst,
+   size_t len)
+{
+   uint8_t *p = (uint8_t*)dst;
+   size_t chunk;
+
+   for (; buf && (len > 0); buf = buf->next) {
+      if (offset >= buf->len) {
+         offset -= buf->len;
+         continue;
+      }
+      chunk = buf->len - offset;
+      if (chunk > len)
+         chunk = len;
+      memcpy(p, os_buf_data(buf) + offset, chunk);
+      p += chunk;
+      len -= chunk;
+      offset = 0;
+   }
+
+   return p - (uint8_t*)dst;
+}
+
+uint8_t *os_buf_push(
+   os_buf_t *buf,
+   size_t len)
+{
+   OS_ASSERT(len <= buf->offset);
+
+   buf->offset -= len;
+   buf->len += len;
+
+   return os_buf_data(buf);
+}
+
+uint8_t *os_buf_pull(
+   os_buf_t *buf,
+   size_t len)
+{
+   OS_ASSERT(len <= buf->len);
+
+   buf->offset += len;
+   buf->len -= len;
+
+   return os_buf_data(buf);
+}
+
+uint8_t *os_buf_put(
+   os_buf_t *buf,
+   size_t len)
+{
+   uint8_t *tail = os_buf_data(buf) + buf->len;
+
+   OS_ASSERT(len <= os_buf_tailroom(buf));
+   buf->len += len;
+
+   return tail;
+}
+
+void os_buf_trim(
+   os_buf_t *buf,
+   size_t len)
+{
+   OS_ASSERT(len <= buf->len);
+
+   buf->len = len;
+}
+
+#endif
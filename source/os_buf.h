@@ -0,0 +1,246 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_BUF_
+#define __OS_BUF_
+
+#ifdef OS_CONFIG_BUF
+
+/**
+ * Buffers allow to pass the data between ISRs and tasks without copying. They
+ * have following characteristics:
+ * - buffers are allocated from os_pool_t, so allocation and release are
+ *   constant time and can be done from ISR. Pool block contains os_buf_t
+ *   header followed by payload, use OS_BUF_BLOCKSIZE() to calculate the block
+ *   size of the pool
+ * - each buffer has atomic reference counter. Buffer is returned to the pool
+ *   at last os_buf_unref(), which can be called from ISR. Buffer which is
+ *   referenced more than once should be treated as read only.
+ * - data inside of payload is described by offset and length. Free space in
+ *   front of data (headroom) allows to prepend headers by os_buf_push() without
+ *   moving the data, os_buf_pull() strips the headers, os_buf_put() appends
+ *   data at the end and os_buf_trim() cuts the tail
+ * - buffers can be linked into chains (scatter/gather lists) by
+ *   os_buf_chain(). Each buffer holds the reference to the next buffer in
+ *   chain, so releasing the head of chain releases also all buffers which are
+ *   not referenced from elsewhere
+ * - buffer is passed through queues by pointer, ownership of the reference is
+ *   passed together with the pointer
+ */
+
+/** Definition of buffer structure, it is placed at beginning of pool block */
+typedef struct os_buf_tag {
+   /** next buffer in chain, NULL for last one */
+   struct os_buf_tag *next;
+
+   /** pool from which the buffer was allocated */
+   os_pool_t *pool;
+
+   /** size of payload memory */
+   size_t size;
+
+   /** offset of data from beginning of payload (headroom) */
+   size_t offset;
+
+   /** length of data */
+   size_t len;
+
+   /** reference counter */
+   arch_atomic_t refcnt;
+
+   /** payload memory */
+   uint8_t payload[] __attribute__ ((aligned(sizeof(void*))));
+} os_buf_t;
+
+/**
+ * Calculates the block size of os_pool_t for buffers with given payload size
+ */
+#define OS_BUF_BLOCKSIZE(_payload) \
+   ((sizeof(os_buf_t) + (_payload) + sizeof(void*) - 1) & \
+    ~(sizeof(void*) - 1))
+
+/**
+ * Function allocates the buffer from pool
+ *
+ * @param pool pointer to pool with block size given by OS_BUF_BLOCKSIZE()
+ * @param headroom number of bytes reserved in front of data for headers
+ *
+ * @pre this function CAN be called from ISR
+ *
+ * @return pointer to buffer with reference counter set to 1 and empty data,
+ *         NULL in case there was no free block in pool
+ */
+os_buf_t *os_buf_alloc(
+   os_pool_t *pool,
+   size_t headroom);
+
+/**
+ * Function allocates the buffer from pool, in case there is no free block
+ * function will suspend calling task (see os_pool_alloc_wait())
+ *
+ * @param pool pointer to pool with block size given by OS_BUF_BLOCKSIZE()
+ * @param headroom number of bytes reserved in front of data for headers
+ * @param timeout_ticks the same meaning as for os_pool_alloc_wait()
+ *
+ * @pre this function cannot be used from ISR nor idle task
+ *
+ * @return pointer to buffer or NULL in case of timeout
+ */
+os_buf_t *os_buf_alloc_wait(
+   os_pool_t *pool,
+   size_t headroom,
+   os_ticks_t timeout_ticks);
+
+/**
+ * Function takes additional reference to buffer
+ *
+ * @pre this function CAN be called from ISR
+ */
+static inline void os_buf_ref(os_buf_t *buf)
+{
+   os_atomic_inc(&(buf->refcnt));
+}
+
+/**
+ * Function drops the reference to buffer. At last reference the buffer is
+ * returned to pool and the reference to next buffer in chain is dropped as well
+ *
+ * @param buf pointer to buffer (usually head of chain)
+ *
+ * @pre this function CAN be called from ISR
+ */
+void os_buf_unref(os_buf_t *buf);
+
+/**
+ * Function links the buffer (or chain) at the end of chain. Reference to
+ * @param next owned by caller is passed to the chain
+ *
+ * @param buf pointer to head of chain
+ * @param next pointer to buffer which will be appended
+ */
+void os_buf_chain(
+   os_buf_t *buf,
+   os_buf_t *next);
+
+/**
+ * Function returns total data length of all buffers in chain
+ */
+size_t os_buf_chain_len(os_buf_t *buf);
+
+/**
+ * Function copies the data from chain into linear memory
+ *
+ * @param buf pointer to head of chain
+ * @param offset offset of data in chain from which copy should start
+ * @param dst pointer to destination memory
+ * @param len number of bytes to copy
+ *
+ * @return number of bytes copied, smaller than @param len if chain is shorter
+ */
+size_t os_buf_copyout(
+   os_buf_t *buf,
+   size_t offset,
+   void *dst,
+   size_t len);
+
+/**
+ * Function returns the pointer to beginning of data
+ */
+static inline uint8_t *os_buf_data(os_buf_t *buf)
+{
+   return buf->payload + buf->offset;
+}
+
+/**
+ * Function returns the number of bytes available in front of data
+ */
+static inline size_t os_buf_headroom(os_buf_t *buf)
+{
+   return buf->offset;
+}
+
+/**
+ * Function returns the number of bytes available after data
+ */
+static inline size_t os_buf_tailroom(os_buf_t *buf)
+{
+   return buf->size - buf->offset - buf->len;
+}
+
+/**
+ * Function extends the data at the front (prepends header) using headroom
+ *
+ * @param buf pointer to buffer
+ * @param len number of bytes, must be <= os_buf_headroom()
+ *
+ * @return pointer to new beginning of data
+ */
+uint8_t *os_buf_push(
+   os_buf_t *buf,
+   size_t len);
+
+/**
+ * Function removes the data from the front (strips header)
+ *
+ * @param buf pointer to buffer
+ * @param len number of bytes, must be <= data length
+ *
+ * @return pointer to new beginning of data
+ */
+uint8_t *os_buf_pull(
+   os_buf_t *buf,
+   size_t len);
+
+/**
+ * Function extends the data at the end using tailroom
+ *
+ * @param buf pointer to buffer
+ * @param len number of bytes, must be <= os_buf_tailroom()
+ *
+ * @return pointer to appended area
+ */
+uint8_t *os_buf_put(
+   os_buf_t *buf,
+   size_t len);
+
+/**
+ * Function cuts the data at the end to given length
+ *
+ * @param buf pointer to buffer
+ * @param len new length of data, must be <= current data length
+ */
+void os_buf_trim(
+   os_buf_t *buf,
+   size_t len);
+
+#endif
+
+#endif
@@ -69,11 +69,42 @@
  * as mutex, semaphore etc. uses os_taskqueue_t which require task buckets */
 #define OS_CONFIG_PRIOCNT ((uint_fast8_t)5)
 
+/** Define to enable earliest deadline first scheduling band. Tasks created by
+ * os_task_create_edf() run at OS_CONFIG_EDF_PRIO and they are ordered by their
+ * absolute deadline, both in ready_queue and in task_queues of
+ * synchronization primitives. Tasks with priorities above and below the band
+ * keep the fixed priority scheduling */
+//#define OS_CONFIG_EDF
+
+/** Priority used as the EDF band. Regular tasks created with this priority are
+ * treated as more urgent than any EDF task and they are scheduled in FIFO
+ * order among each other, as in other priority levels */
+#define OS_CONFIG_EDF_PRIO ((uint_fast8_t)2)
+
+/** Define to enable execution budgets of tasks (sporadic server). Task which
+ * exhausts its budget is demoted to background priority or suspended until
+ * replenishment, see os_task_budget_set() */
+//#define OS_CONFIG_BUDGET
+
+/** Define to enable time partitions. Each partition owns the ready queue and
+ * schedule table of time windows decides which partition runs, see
+ * os_partition.h */
+//#define OS_CONFIG_PARTITION
+
+/** Define to enable cyclic executive. Jobs are released by os_tick() from
+ * const table of (tick offset, task) entries, see os_cyclic.h */
+//#define OS_CONFIG_CYCLIC
+
 /** Define to enable preemption. Disabling preemption can make kernel less
  * responsive but should make it faster, this can be beneficial for some very
  * constrained environments where we don't need preemption at all */
 //TBD #define OS_CONFIG_PREEMPTION (1)
 
+/** Define to enable preemption thresholds. Running task with threshold can be
+ * preempted only by tasks with priority above its threshold, see
+ * os_task_threshold_set() */
+//#define OS_CONFIG_PREEMPTTHRESHOLD
+
 /** Define to enable semaphores. Keep in mind that semaphores is internally
  * used for os_task_join() call, if OS_CONFIG_SEMAPHORE is not defined
  * os_task_join() will return immediately. This may change the behaviour of
@@ -90,6 +121,13 @@
 /** Define to enable priority inheritance for mutex */
 #define OS_CONFIG_MUTEX_PRIO_INHERITANCE
 
+/** Maximal number of tasks which can own the rwlock at the same time (shared
+ * access). Each rwlock keeps the ownership slot for each of owners since this is
+ * required by priority inheritance. Therefore this number significantly
+ * increase the size of os_rwlock_t. In case all slots are occupied, next reader
+ * will suspend until some of the owners will release the rwlock */
+#define OS_CONFIG_RWLOCK_OWNERS ((uint_fast8_t)4)
+
 /** Define to enable timers. Keep in mind that timers are used for time guard's
  * for blocking primitives such semaphores. This may change the behaviour of
  * application even if it doesn't use timers explicitly (eg not calling the
@@ -100,9 +138,120 @@
  * scheduler for task switching */
 //TBD #define OS_CONFIG_TIMER
 
+/** Width of system tick counter in bits (16, 32 or 64). In case it is not
+ * defined, the native width of arch is used (16 bits on AVR and MSP430, 64 bits
+ * on Linux). Wider counter allows longer timeouts and measurements by
+ * os_ticks_diff(), but on small CPUs it costs additional cycles in os_tick()
+ * and critical section in os_ticks_now(). Narrower counter than native one is
+ * only useful to exercise the tick wrap around and timeout cascading on Linux */
+//#define OS_CONFIG_TICKS_WIDTH 32
+
+/** Define to call the callbacks of application timers from timer daemon task
+ * instead of os_tick(). Timeouts of blocking functions are still handled
+ * directly by os_tick(). Keep in mind that this changes the context of all
+ * application timer callbacks and costs additional task with its stack */
+//#define OS_CONFIG_TIMERDAEMON
+
+/** Priority of timer daemon task */
+#define OS_CONFIG_TIMERDAEMON_PRIO ((uint_fast8_t)(OS_CONFIG_PRIOCNT - 1))
+
+/** Stack size of timer daemon task. Must be compile time constant, so it cannot
+ * be derived from OS_STACK_MINSIZE (on Linux it is SIGSTKSZ, which is not a
+ * constant since glibc 2.34). It cannot be lower than OS_STACK_MINSIZE, adjust
+ * it for small MCUs */
+#define OS_CONFIG_TIMERDAEMON_STACKSIZE ((size_t)16384)
+
+/** Define to enable high resolution (sub-tick) timers and nanosecond
+ * timeouts. Available only on architectures which provide one-shot timer
+ * (ARCH_HAS_HRTIMER) */
+#ifdef ARCH_HAS_HRTIMER
+#define OS_CONFIG_HRTIMER
+#endif
+
+/** Maximal number of simultaneously active hrtimers, including the nanosecond
+ * timeouts of blocked tasks. Each costs one pointer of RAM */
+#define OS_CONFIG_HRTIMER_CNT ((size_t)32)
+
+/** Define to enable timer slack. Timer with slack may burn off up to slack
+ * ticks after its timeout, so its expiration can be batched with other timers
+ * which burn off in the same window. This decrease the number of wakeups, but
+ * costs one os_ticks_t in each timer and task */
+#define OS_CONFIG_TIMERSLACK
+
 /** Define to enable wait queues (synchronization primitive) */
 #define OS_CONFIG_WAITQUEUE
 
+/** Define to enable os_wait_any() which allows to suspend on multiple
+ * semaphores and wait_queues at once. This adds the list head to each
+ * semaphore and wait_queue */
+#define OS_CONFIG_WAITANY
+
+/** Define to enable futex (fast user-space mutex like) primitive */
+#define OS_CONFIG_FUTEX
+
+/** Number of task_queues in futex hash table. Tasks suspended on different
+ * futex words which hash into the same bucket share the task_queue, so
+ * increasing this number decrease the cost of os_futex_wake(). Each bucket
+ * costs one os_taskqueue_t of RAM. Must be power of 2 */
+#define OS_CONFIG_FUTEX_HASHSIZE ((uint_fast8_t)8)
+
+/** Define to enable task notifications. Each task gets the notification word
+ * which can be used as lightweight replacement of semaphore or event flags in
+ * case there is only one receiver */
+#define OS_CONFIG_TASKNOTIFY
+
+/** Define to enable periodic tasks API os_task_periodic_init() and
+ * os_task_wait_next_period(). Each task gets the period, next release tick
+ * and overrun counter */
+#define OS_CONFIG_TASKPERIODIC
+
+/** Define to enable event flags groups (synchronization primitive) */
+#define OS_CONFIG_EVFLAGS
+
+/** Define to enable fixed block memory pools */
+//#define OS_CONFIG_POOL
+
+/** Define to enable real time heap allocator (TLSF) */
+//#define OS_CONFIG_HEAP
+
+/** Number of first level (power of 2) size ranges of heap. Maximal heap size
+ * is about 2^(OS_CONFIG_HEAP_FLCNT + OS_CONFIG_HEAP_SLCNT_LOG2) *
+ * sizeof(void*) bytes. Each range costs one arch_bitmask_t and
+ * 2^OS_CONFIG_HEAP_SLCNT_LOG2 pointers in os_heap_t */
+#define OS_CONFIG_HEAP_FLCNT ((uint_fast8_t)16)
+
+/** Number of second level lists in each first level range (as power of 2).
+ * Higher value decrease the internal fragmentation. Must fit into
+ * arch_bitmask_t */
+#define OS_CONFIG_HEAP_SLCNT_LOG2 ((uint_fast8_t)3)
+
+/** Define to enable per task accounting of heap usage */
+//#define OS_CONFIG_HEAP_TASKSTAT
+
+/** Define to enable reference counted buffers, requires OS_CONFIG_POOL */
+//#define OS_CONFIG_BUF
+
+/** Define to enable zero-copy mailboxes, requires OS_CONFIG_POOL */
+//#define OS_CONFIG_MBOX
+
+/** Define to enable stream buffers */
+//#define OS_CONFIG_STREAM
+
+/** Define to enable softirqs (bottom halves of interrupt handlers) */
+//#define OS_CONFIG_SOFTIRQ
+
+/** Number of softirqs, must fit into arch_bitmask_t */
+#define OS_CONFIG_SOFTIRQCNT ((uint_fast8_t)5)
+
+/** Define to enable deferred posting from ISRs, requires OS_CONFIG_SOFTIRQ */
+//#define OS_CONFIG_ISRPOST
+
+/** Number of slots in deferred post queue, must be power of 2 */
+#define OS_CONFIG_ISRPOST_SIZE ((arch_atomic_t)16)
+
+/** Softirq used for applying the deferred posts, reserved for kernel */
+#define OS_CONFIG_ISRPOST_SOFTIRQ ((uint_fast8_t)(OS_CONFIG_SOFTIRQCNT - 1))
+
 /** Define to enable conditionals (synchronization primitive) */
 //TBD #define OS_CONFG_CONDITIONAL
 
@@ -0,0 +1,212 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_CYCLIC
+
+/** Running cyclic table, NULL if cyclic executive is stopped */
+static const os_cyclic_entry_t *cyclic_table = NULL;
+static size_t cyclic_cnt;
+static os_ticks_t cyclic_hyperperiod;
+static os_cyclic_overrun_t cyclic_overrun;
+
+/** Index of next entry to release */
+static size_t cyclic_idx;
+
+/** Offset of next tick inside of hyperperiod */
+static os_ticks_t cyclic_time;
+
+/* private function forward declarations */
+static bool os_cyclic_intable(
+   const os_cyclic_entry_t *table,
+   size_t cnt,
+   os_task_t *task);
+static void os_cyclic_wakeup_internal(
+   os_retcode_t block_code,
+   const os_cyclic_entry_t *keep_table,
+   size_t keep_cnt);
+
+/* --- public functions --- */
+/* all public functions are documented in os_cyclic.h file */
+
+void os_cyclic_start(
+   const os_cyclic_entry_t *table,
+   size_t cnt,
+   os_ticks_t hyperperiod,
+   os_cyclic_overrun_t overrun)
+{
+   arch_criticalstate_t cristate;
+   size_t i;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(table && (cnt > 0));
+   for (i = 0; i < cnt; i++) {
+      OS_ASSERT(table[i].offset < hyperperiod);
+      /* table must be sorted */
+      OS_ASSERT((0 == i) || (table[i - 1].offset <= table[i].offset));
+   }
+
+   arch_critical_enter(cristate);
+   if (cyclic_table) {
+      /* tasks which are not in new table would never be released */
+      os_cyclic_wakeup_internal(OS_DESTROYED, table, cnt);
+   }
+   cyclic_table = table;
+   cyclic_cnt = cnt;
+   cyclic_hyperperiod = hyperperiod;
+   cyclic_overrun = overrun;
+   cyclic_idx = 0;
+   cyclic_time = 0;
+   os_schedule(1);
+   arch_critical_exit(cristate);
+}
+
+void os_cyclic_stop(void)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+
+   arch_critical_enter(cristate);
+   if (cyclic_table) {
+      os_cyclic_wakeup_internal(OS_DESTROYED, NULL, 0);
+      cyclic_table = NULL;
+      os_schedule(1);
+   }
+   arch_critical_exit(cristate);
+}
+
+os_retcode_t os_cyclic_wait(void)
+{
+   arch_criticalstate_t cristate;
+   os_retcode_t ret;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot suspend in ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   arch_critical_enter(cristate);
+   if (NULL == cyclic_table) {
+      /* there would be no release nor os_cyclic_stop() to wake us up */
+      ret = OS_DESTROYED;
+   } else {
+      /* task which is not in the table would never be released */
+      OS_ASSERT(os_cyclic_intable(cyclic_table, cyclic_cnt, task_current));
+      /* released task is referenced by cyclic table, so there is no need to
+       * keep it on any task_queue */
+      os_task_block_switch(NULL, OS_TASKBLOCK_CYCLIC);
+      ret = task_current->block_code;
+   }
+   arch_critical_exit(cristate);
+
+   return ret;
+}
+
+/* --- protected functions --- */
+
+void os_cyclic_tick(void)
+{
+   const os_cyclic_entry_t *entry;
+   os_task_t *task;
+
+   if (NULL == cyclic_table)
+      return;
+
+   while ((cyclic_idx < cyclic_cnt) &&
+          (cyclic_table[cyclic_idx].offset == cyclic_time)) {
+      entry = &cyclic_table[cyclic_idx++];
+      task = entry->task;
+      if ((TASKSTATE_WAIT == task->state) &&
+          (OS_TASKBLOCK_CYCLIC == task->block_type)) {
+         task->block_code = OS_OK;
+         os_task_makeready(task);
+      } else if (cyclic_overrun) {
+         /* task did not finish its previous job, release is skipped */
+         cyclic_overrun(task);
+      }
+   }
+
+   if (++cyclic_time >= cyclic_hyperperiod) {
+      cyclic_time = 0;
+      cyclic_idx = 0;
+   }
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of os_tick() */
+}
+
+/* --- private functions --- */
+
+/**
+ * Function checks if the task has any entry in table
+ */
+static bool os_cyclic_intable(
+   const os_cyclic_entry_t *table,
+   size_t cnt,
+   os_task_t *task)
+{
+   size_t i;
+
+   for (i = 0; i < cnt; i++) {
+      if (table[i].task == task)
+         return true;
+   }
+
+   return false;
+}
+
+/**
+ * Function wakes up all tasks from the running table which wait for release,
+ * except those which have an entry in keep_table
+ */
+static void os_cyclic_wakeup_internal(
+   os_retcode_t block_code,
+   const os_cyclic_entry_t *keep_table,
+   size_t keep_cnt)
+{
+   os_task_t *task;
+   size_t i;
+
+   for (i = 0; i < cyclic_cnt; i++) {
+      task = cyclic_table[i].task;
+      if ((TASKSTATE_WAIT == task->state) &&
+          (OS_TASKBLOCK_CYCLIC == task->block_type) &&
+          !os_cyclic_intable(keep_table, keep_cnt, task)) {
+         task->block_code = block_code;
+         os_task_makeready(task);
+      }
+   }
+}
+
+#endif
+
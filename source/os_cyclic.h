@@ -0,0 +1,110 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_CYCLIC_
+#define __OS_CYCLIC_
+
+#ifdef OS_CONFIG_CYCLIC
+
+/**
+ * Cyclic executive gives the time-triggered mode of job activation. Instead of
+ * timers, jobs are released from precomputed const table of (tick offset, task)
+ * entries which repeats every hyperperiod. Characteristic of cyclic executive:
+ * - os_tick() walks the table and releases the listed tasks directly into ready
+ *   queue, there are no per-job timers, so the release jitter does not depend
+ *   on number of armed timers (no sorted insert into timer list)
+ * - each entry costs O(1) at its tick, table must be sorted by offset
+ * - task ends its job by os_cyclic_wait(). In case task did not end its
+ *   previous job until its next release, the release is skipped and overrun
+ *   hook is called
+ * - released tasks are scheduled by their priorities, so the table should not
+ *   release higher priority job before lower priority job ends unless
+ *   preemption is intended
+ */
+
+/** Definition of single entry of cyclic table */
+typedef struct {
+   os_ticks_t offset;   /**< tick offset of release inside of hyperperiod */
+   os_task_t *task;     /**< task released at offset */
+} os_cyclic_entry_t;
+
+/** Definition of overrun hook. It is called from os_tick() (from ISR with
+ * interrupts disabled) with the task which missed its release */
+typedef void (*os_cyclic_overrun_t)(os_task_t *task);
+
+/**
+ * Function starts the cyclic table. Entries with offset 0 are released at next
+ * tick, after hyperperiod ticks table repeats from the beginning. It is
+ * allowed to replace the table which is already running, tasks which wait for
+ * release keep waiting for the release from new table. Waiting tasks which
+ * have no entry in new table are woken up with OS_DESTROYED.
+ *
+ * @param table array of entries sorted by offset, memory must be valid until
+ *        os_cyclic_stop() or until the table is replaced
+ * @param cnt number of entries in table
+ * @param hyperperiod length of cycle in ticks, must be greater than offset of
+ *        each entry
+ * @param overrun hook called for each skipped release, can be NULL
+ *
+ * @pre this function cannot be called from ISR
+ */
+void os_cyclic_start(
+   const os_cyclic_entry_t *table,
+   size_t cnt,
+   os_ticks_t hyperperiod,
+   os_cyclic_overrun_t overrun);
+
+/**
+ * Function stops the cyclic table. Tasks from table which wait for the release
+ * are woken up with OS_DESTROYED
+ *
+ * @pre this function cannot be called from ISR
+ */
+void os_cyclic_stop(void);
+
+/**
+ * Function ends the job of the calling task and suspends it until its next
+ * release from cyclic table
+ *
+ * @return OS_OK in case task was released, OS_DESTROYED in case the table was
+ *         stopped or replaced by table without the task (also immediately,
+ *         without suspending, in case no table is running)
+ *
+ * @pre this function cannot be called from ISR
+ * @pre this function cannot be called from idle task
+ * @pre in case table is running, calling task must have an entry in it
+ */
+os_retcode_t os_cyclic_wait(void);
+
+#endif
+
+#endif
+
@@ -0,0 +1,270 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_EVFLAGS
+
+/* private function forward declarations */
+static void os_evflags_timerclbck(void *param);
+
+/* --- private functions --- */
+
+/**
+ * Function checks if wait condition is satisfied for given state of flags
+ */
+static bool os_evflags_match(
+   uint32_t flags,
+   uint32_t mask,
+   uint_fast8_t opt)
+{
+   if (opt & OS_EVFLAGS_ALL)
+      return (flags & mask) == mask;
+
+   return 0 != (flags & mask);
+}
+
+/* --- public functions --- */
+/* all public functions are documented in os_evflags.h file */
+
+void os_evflags_create(
+   os_evflags_t *evflags,
+   uint32_t init_flags)
+{
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+
+   memset(evflags, 0, sizeof(os_evflags_t));
+   os_taskqueue_init(&(evflags->task_queue));
+   evflags->flags = init_flags;
+}
+
+void os_evflags_destroy(os_evflags_t *evflags)
+{
+   arch_criticalstate_t cristate;
+   os_task_t *task;
+
+   OS_ASSERT(0 == isr_nesting);     /* cannot call from ISR */
+   OS_ASSERT(!waitqueue_current);   /* cannot call after os_waitqueue_prepare() */
+
+   arch_critical_enter(cristate);
+
+   /* wake up all task which suspended on event flags group */
+   while ((task = os_taskqueue_dequeue(&(evflags->task_queue)))) {
+      os_blocktimer_destroy(task); /* destroy the tasks timer */
+      task->block_code = OS_DESTROYED;
+      os_task_makeready(task);
+   }
+   memset(evflags, 0, sizeof(os_evflags_t));
+
+   /* schedule to make context switch in case os_evflags_destroy() was called
+    * by lower priority task than tasks which we just woken up */
+   os_schedule(1);
+
+   arch_critical_exit(cristate);
+}
+
+os_retcode_t OS_WARN_UNUSEDRET os_evflags_wait(
+   os_evflags_t *evflags,
+   uint32_t mask,
+   uint_fast8_t opt,
+   os_ticks_t timeout_ticks,
+   uint32_t *flags)
+{
+   os_retcode_t ret;
+   os_timer_t timer;
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   /* calling of blocking function while holding mtx or rwlock will cause
+    * priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+   OS_ASSERT(0 != mask); /* such task would never be woken up */
+
+   /* critical section needed because flags may be set from ISR right after we
+    * check them */
+   arch_critical_enter(cristate);
+   do {
+      if (os_evflags_match(evflags->flags, mask, opt)) {
+         /* condition already satisfied, no need to suspend */
+         if (flags)
+            *flags = evflags->flags;
+         if (opt & OS_EVFLAGS_CLEAR)
+            evflags->flags &= ~mask;
+         ret = OS_OK;
+         break;
+      }
+
+      if (OS_TIMEOUT_TRY == timeout_ticks) {
+         ret = OS_WOULDBLOCK;
+         break;
+      }
+
+      /* does task request timeout guard for operation? */
+      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+         /* we will get callback to os_evflags_timerclbck() in case of
+          * timeout */
+         os_blocktimer_create(&timer, os_evflags_timerclbck, timeout_ticks);
+      }
+
+      /* waker needs to know the wait condition of each task */
+      task_current->evflags_mask = mask;
+      task_current->evflags_opt = opt;
+      os_task_block_switch(&(evflags->task_queue), OS_TASKBLOCK_EVFLAGS);
+
+      /* we return here either after os_evflags_set(), destroy or timeout.
+       * Destroy the timeout guard if it was created */
+      os_blocktimer_destroy(task_current);
+
+      ret = task_current->block_code;
+      /* at wakeup os_evflags_set() stores the state of flags in evflags_mask,
+       * auto clear was already done by os_evflags_set() */
+      if ((OS_OK == ret) && flags)
+         *flags = task_current->evflags_mask;
+
+   } while (0);
+   arch_critical_exit(cristate);
+
+   return ret;
+}
+
+uint32_t os_evflags_set(
+   os_evflags_t *evflags,
+   uint32_t mask)
+{
+   arch_criticalstate_t cristate;
+   os_task_t *task;
+   list_t *itr;
+   uint_fast8_t prio;
+   uint32_t snapshot;
+   uint32_t clear = 0;
+   bool awoken = false;
+
+   /* tasks cannot call any OS functions if they are 'prepared' to suspend on
+    * wait_queue, with exception to ISR's */
+   OS_ASSERT((isr_nesting > 0) || (!waitqueue_current));
+
+   arch_critical_enter(cristate);
+
+   evflags->flags |= mask;
+   snapshot = evflags->flags;
+
+   /* single pass over suspended tasks from the most prioritized level (FIFO
+    * order inside of each level). Only tasks for which the wait condition is
+    * satisfied are woken up, the rest stays on task_queue */
+   for (prio = OS_CONFIG_PRIOCNT; prio-- > 0; ) {
+      itr = list_itr_begin(&(evflags->task_queue.tasks[prio]));
+      while (false == list_itr_end(&(evflags->task_queue.tasks[prio]), itr)) {
+         task = os_container_of(itr, os_task_t, list);
+         itr = itr->next; /* advance before we unlink the task */
+         if (!os_evflags_match(snapshot, task->evflags_mask, task->evflags_opt))
+            continue;
+
+         if (task->evflags_opt & OS_EVFLAGS_CLEAR)
+            clear |= task->evflags_mask;
+
+         os_taskqueue_unlink(task);
+         /* we need to destroy the timer here, because otherwise it may fire
+          * right after we leave the critical section */
+         os_blocktimer_destroy(task);
+         task->evflags_mask = snapshot; /* pass the state of flags to task */
+         task->block_code = OS_OK; /* set the block code to NORMAL WAKEUP */
+         os_task_makeready(task);
+         awoken = true;
+      }
+   }
+
+   /* auto clear is applied after the pass, so all tasks see the same flags */
+   evflags->flags &= ~clear;
+   snapshot = evflags->flags;
+
+   if (awoken) {
+      /* switch to more prioritized READY task, if there is such (1 as param
+       * in os_schedule() means just that */
+      os_schedule(1);
+   }
+
+   arch_critical_exit(cristate);
+
+   return snapshot;
+}
+
+uint32_t os_evflags_clear(
+   os_evflags_t *evflags,
+   uint32_t mask)
+{
+   arch_criticalstate_t cristate;
+   uint32_t prev;
+
+   arch_critical_enter(cristate);
+   prev = evflags->flags;
+   evflags->flags &= ~mask;
+   arch_critical_exit(cristate);
+
+   return prev;
+}
+
+uint32_t os_evflags_get(os_evflags_t *evflags)
+{
+   arch_criticalstate_t cristate;
+   uint32_t flags;
+
+   /* critical section needed since uint32_t may be not atomic on some arch */
+   arch_critical_enter(cristate);
+   flags = evflags->flags;
+   arch_critical_exit(cristate);
+
+   return flags;
+}
+
+/**
+ * Function called by timers module. Used for timeout of os_evflags_wait()
+ * Callback to this function are done from context of timer_trigger().
+ */
+static void os_evflags_timerclbck(void *param)
+{
+   /* single timer has param in os_blocktimer_create() as pointer to task
+    * structure */
+   os_task_t *task = (os_task_t*)param;
+
+   OS_SELFCHECK_ASSERT(TASKSTATE_WAIT == task->state);
+
+   /* remove task from event flags task_queue */
+   os_taskqueue_unlink(task);
+   task->block_code = OS_TIMEOUT;
+   os_task_makeready(task);
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of timer_trigger() */
+}
+
+#endif
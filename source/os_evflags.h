@@ -0,0 +1,175 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_EVFLAGS_
+#define __OS_EVFLAGS_
+
+#ifdef OS_CONFIG_EVFLAGS
+
+/**
+ * Event flags group is synchronization primitive which allows tasks to wait
+ * for combination of events (bits) signaled by other tasks or ISRs. It has
+ * following characteristics:
+ * - group holds 32 independent flags. Flags are set by os_evflags_set() and
+ *   cleared by os_evflags_clear(), both can be called from ISR
+ * - task can wait until any (OS_EVFLAGS_ANY) or all (OS_EVFLAGS_ALL) flags
+ *   from given mask will be set. Flags for which task waited may be cleared
+ *   automatically at wakeup (OS_EVFLAGS_CLEAR)
+ * - os_evflags_set() makes single pass over suspended tasks and wakes up only
+ *   those for which the wait condition is satisfied. Other tasks stay suspended,
+ *   there is no need for predicate loop like with os_waitqueue_t
+ * - all tasks are checked against the same state of flags (taken right after
+ *   setting the new flags). Auto clear requested by woken up tasks is applied
+ *   after the pass, so single os_evflags_set() can wake up multiple tasks
+ *   waiting for the same flag even if they request auto clear
+ * - flags are not counted, setting flag which is already set has no effect
+ * - event flags do not prevent from priority inversion problem
+ */
+
+/** Wait until any flag from mask will be set */
+#define OS_EVFLAGS_ANY ((uint_fast8_t)0x0)
+/** Wait until all flags from mask will be set */
+#define OS_EVFLAGS_ALL ((uint_fast8_t)0x1)
+/** Clear the flags from mask when wait condition is satisfied, can be combined
+ * with OS_EVFLAGS_ANY or OS_EVFLAGS_ALL */
+#define OS_EVFLAGS_CLEAR ((uint_fast8_t)0x2)
+
+/** Definition of event flags group structure */
+typedef struct {
+   /** queue of tasks suspended on this event flags group */
+   os_taskqueue_t task_queue;
+
+   /** current state of flags */
+   uint32_t flags;
+
+} os_evflags_t;
+
+/**
+ * Function creates the event flags group.
+ *
+ * @param evflags pointer to event flags group
+ * @param init_flags initial state of flags
+ */
+void os_evflags_create(
+   os_evflags_t *evflags,
+   uint32_t init_flags);
+
+/**
+ * Function destroys the event flags group
+ *
+ * @param evflags pointer to event flags group
+ *
+ * @pre event flags group must be initialized prior call of this function
+ * @pre this function cannot be called from ISR
+ *
+ * @post tasks suspended on event flags group will be released with
+ *       OS_DESTROYED as return code from os_evflags_wait(). The same race
+ *       conditions as described for os_sem_destroy() apply here.
+ * @post this function may cause preemption since this function wakes up tasks
+ *       suspended on event flags group
+ */
+void os_evflags_destroy(os_evflags_t *evflags);
+
+/**
+ * Function suspends the calling task until flags given by @param mask will be
+ * set, according to @param opt
+ *
+ * @param evflags pointer to event flags group
+ * @param mask flags for which task waits, must be != 0
+ * @param opt either OS_EVFLAGS_ANY or OS_EVFLAGS_ALL, optionally combined with
+ *        OS_EVFLAGS_CLEAR
+ * @param timeout_ticks number of jiffies (os_tick() call count) before
+ *        operation will time out. OS_TIMEOUT_INFINITE and OS_TIMEOUT_TRY have
+ *        the same meaning as for os_sem_down().
+ * @param flags pointer to variable where the state of flags which satisfied
+ *        the wait condition will be stored (before auto clear), can be NULL
+ *
+ * @pre this function cannot be used from ISR nor idle task
+ *
+ * @return OS_OK in case wait condition was satisfied
+ *         OS_DESTROYED in case event flags group was destroyed while calling
+ *         task was suspended on it
+ *         OS_WOULDBLOCK in case wait condition was not satisfied and
+ *         @param timeout_ticks was OS_TIMEOUT_TRY
+ *         OS_TIMEOUT in case operation timeout expired
+ */
+os_retcode_t OS_WARN_UNUSEDRET os_evflags_wait(
+   os_evflags_t *evflags,
+   uint32_t mask,
+   uint_fast8_t opt,
+   os_ticks_t timeout_ticks,
+   uint32_t *flags);
+
+/**
+ * Function sets the flags and wakes up all tasks for which the wait condition
+ * became satisfied
+ *
+ * @param evflags pointer to event flags group
+ * @param mask flags to set
+ *
+ * @pre this function CAN be called from ISR
+ *
+ * @post this function may cause preemption since it can wake up task with
+ *       higher priority than caller task
+ *
+ * @return state of flags after the operation (including auto clear requested
+ *         by woken up tasks)
+ */
+uint32_t os_evflags_set(
+   os_evflags_t *evflags,
+   uint32_t mask);
+
+/**
+ * Function clears the flags
+ *
+ * @param evflags pointer to event flags group
+ * @param mask flags to clear
+ *
+ * @pre this function CAN be called from ISR
+ *
+ * @return state of flags before the operation
+ */
+uint32_t os_evflags_clear(
+   os_evflags_t *evflags,
+   uint32_t mask);
+
+/**
+ * Function returns current state of flags
+ *
+ * @param evflags pointer to event flags group
+ *
+ * @pre this function CAN be called from ISR
+ */
+uint32_t os_evflags_get(os_evflags_t *evflags);
+
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_FUTEX
+
+/** Hash table of task_queues for tasks suspended on futex words */
+static os_taskqueue_t futex_table[OS_CONFIG_FUTEX_HASHSIZE];
+
+/* private function forward declarations */
+static void os_futex_timerclbck(void *param);
+
+/* --- private functions --- */
+
+/**
+ * Function returns the task_queue from futex hash table for given futex word
+ */
+static os_taskqueue_t *os_futex_bucket(const volatile arch_atomic_t *addr)
+{
+   uintptr_t key = (uintptr_t)addr / sizeof(arch_atomic_t);
+
+   /* fold higher bits, futex words are often placed next to each other */
+   key ^= key >> 8;
+
+   return &futex_table[key & (OS_CONFIG_FUTEX_HASHSIZE - 1)];
+}
+
+/* --- protected functions --- */
+
+void OS_COLD os_futex_init(void)
+{
+   uint_fast8_t i;
+
+   for (i = 0; i < OS_CONFIG_FUTEX_HASHSIZE; i++)
+      os_taskqueue_init(&futex_table[i]);
+}
+
+/* --- public functions --- */
+/* all public functions are documented in os_futex.h file */
+
+os_retcode_t OS_WARN_UNUSEDRET os_futex_wait(
+   const volatile arch_atomic_t *addr,
+   arch_atomic_t expected,
+   os_ticks_t timeout_ticks)
+{
+   os_retcode_t ret;
+   os_timer_t timer;
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   /* calling of blocking function while holding mtx or rwlock will cause
+    * priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   /* critical section needed because futex word may be changed and
+    * os_futex_wake() called from ISR right after we check the futex word */
+   arch_critical_enter(cristate);
+   do {
+      if ((os_atomic_load(addr) != expected) ||
+          (OS_TIMEOUT_TRY == timeout_ticks)) {
+         ret = OS_WOULDBLOCK;
+         break;
+      }
+
+      /* does task request timeout guard for operation? */
+      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+         /* we will get callback to os_futex_timerclbck() in case of timeout */
+         os_blocktimer_create(&timer, os_futex_timerclbck, timeout_ticks);
+      }
+
+      /* remember the futex word, bucket may be shared by other futex words */
+      task_current->futex_addr = addr;
+      os_task_block_switch(os_futex_bucket(addr), OS_TASKBLOCK_FUTEX);
+
+      /* we return here either after os_futex_wake() or timeout. Destroy the
+       * timeout guard if it was created */
+      os_blocktimer_destroy(task_current);
+
+      ret = task_current->block_code;
+
+   } while (0);
+   arch_critical_exit(cristate);
+
+   return ret;
+}
+
+uint_fast8_t os_futex_wake(
+   const volatile arch_atomic_t *addr,
+   uint_fast8_t nbr)
+{
+   arch_criticalstate_t cristate;
+   os_taskqueue_t *bucket;
+   os_task_t *task;
+   list_t *itr;
+   uint_fast8_t prio;
+   uint_fast8_t awoken = 0;
+
+   /* tasks cannot call any OS functions if they are are 'prepared' to suspend
+    * on wait_queue, with exception to ISR's */
+   OS_ASSERT((isr_nesting > 0) || (!waitqueue_current));
+   OS_ASSERT(nbr > 0); /* number of tasks to wake up must be > 0 */
+
+   bucket = os_futex_bucket(addr);
+
+   arch_critical_enter(cristate);
+
+   /* bucket may contain tasks suspended on other futex words, so we cannot
+    * just dequeue the tasks. Instead we scan the bucket from the most
+    * prioritized level (FIFO order inside of each level) and pick only tasks
+    * which wait for our futex word */
+   for (prio = OS_CONFIG_PRIOCNT; (prio-- > 0) && (awoken < nbr); ) {
+      itr = list_itr_begin(&(bucket->tasks[prio]));
+      while ((false == list_itr_end(&(bucket->tasks[prio]), itr)) &&
+             (awoken < nbr)) {
+         task = os_container_of(itr, os_task_t, list);
+         itr = itr->next; /* advance before we unlink the task */
+         if (task->futex_addr != addr)
+            continue;
+
+         os_taskqueue_unlink(task);
+         /* we need to destroy the timer here, because otherwise it may fire
+          * right after we leave the critical section */
+         os_blocktimer_destroy(task);
+         task->block_code = OS_OK; /* set the block code to NORMAL WAKEUP */
+         os_task_makeready(task);
+         ++awoken;
+      }
+   }
+
+   if (awoken) {
+      /* switch to more prioritized READY task, if there is such (1 as param
+       * in os_schedule() means just that */
+      os_schedule(1);
+   }
+
+   arch_critical_exit(cristate);
+
+   return awoken;
+}
+
+/**
+ * Function called by timers module. Used for timeout of os_futex_wait()
+ * Callback to this function are done from context of timer_trigger().
+ */
+static void os_futex_timerclbck(void *param)
+{
+   /* single timer has param in os_blocktimer_create() as pointer to task
+    * structure */
+   os_task_t *task = (os_task_t*)param;
+
+   OS_SELFCHECK_ASSERT(TASKSTATE_WAIT == task->state);
+
+   /* remove task from futex bucket */
+   os_taskqueue_unlink(task);
+   task->block_code = OS_TIMEOUT;
+   os_task_makeready(task);
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of timer_trigger() */
+}
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_FUTEX_
+#define __OS_FUTEX_
+
+#ifdef OS_CONFIG_FUTEX
+
+/**
+ * Futex is the kernel side of synchronization primitives built by application
+ * on top of atomic operations. Application keeps the state of primitive in
+ * the futex word (arch_atomic_t) and manipulate it with os_atomic_x() macros
+ * only. Kernel is entered only in case of contention, to suspend the task until
+ * the state of futex word will change or to wake up suspended tasks.
+ *
+ * Following template of code is used for simple lock:
+ * 0: arch_atomic_t word = 0; 0 - unlocked, 1 - locked, 2 - locked contended
+ *
+ * lock:
+ * 1: c = 0;
+ * 2: if (os_atomic_cmp_exch(&word, &c, 1)) {
+ * 3:    if (2 != c)
+ * 4:       c = os_atomic_exch(&word, 2);
+ * 5:    while (0 != c) {
+ * 6:       ret = os_futex_wait(&word, 2, OS_TIMEOUT_INFINITE);
+ * 7:       c = os_atomic_exch(&word, 2);
+ * 8:    }
+ * 9: }
+ *
+ * unlock:
+ * 10: if (2 == os_atomic_exch(&word, 0))
+ * 11:    os_futex_wake(&word, 1);
+ *
+ * Futex has following characteristics:
+ * - futex does not need any kernel object to be created for each futex word.
+ *   Suspended tasks are kept in global hash table of task_queues indexed by
+ *   address of futex word (size given by OS_CONFIG_FUTEX_HASHSIZE)
+ * - os_futex_wait() checks the futex word and suspends the task in single
+ *   atomic step (interrupts are disabled). Therefore wakeup cannot be lost
+ *   between the check of futex word and suspend, even if futex word is modified
+ *   from ISR.
+ * - futex does not accumulate wakeups. os_futex_wake() called while no task is
+ *   suspended on given futex word has no effect. Application must keep all
+ *   required state in the futex word.
+ * - tasks are woken up in priority order (FIFO for the same priority)
+ * - futex does not implement priority inheritance, since kernel does not know
+ *   the owner of application lock. Use os_mtx_t in case this is required.
+ */
+
+/**
+ * Definition of "wake up all tasks" operation given in nbr parameter of
+ * os_futex_wake()
+ */
+#define OS_FUTEX_ALL ((uint_fast8_t)UINT8_MAX)
+
+/**
+ * Function suspends the calling task on futex word, but only if futex word is
+ * still equal to @param expected. Check and suspend are performed atomically
+ * (in reference to both tasks and ISRs).
+ *
+ * @param addr pointer to futex word
+ * @param expected value of futex word for which the task should suspend
+ * @param timeout_ticks number of jiffies (os_tick() call count) before
+ *        operation will time out. OS_TIMEOUT_INFINITE and OS_TIMEOUT_TRY have
+ *        the same meaning as for os_sem_down().
+ *
+ * @pre this function cannot be used from ISR nor idle task
+ *
+ * @return OS_OK in case task was woken up by os_futex_wake()
+ *         OS_WOULDBLOCK in case futex word was different than @param expected
+ *         (task did not suspend) or @param timeout_ticks was OS_TIMEOUT_TRY
+ *         OS_TIMEOUT in case operation timeout expired
+ * @note OS_OK does not imply anything about the current value of futex word,
+ *       application must check it again (usually in loop)
+ */
+os_retcode_t OS_WARN_UNUSEDRET os_futex_wait(
+   const volatile arch_atomic_t *addr,
+   arch_atomic_t expected,
+   os_ticks_t timeout_ticks);
+
+/**
+ * Function wakes up tasks suspended on futex word.
+ *
+ * @param addr pointer to futex word
+ * @param nbr number of task to wakeup. Must be > 0. To wake all task suspended
+ *        on given futex word nbr should be given as OS_FUTEX_ALL.
+ *
+ * @pre this function CAN be called from ISR.
+ *
+ * @post this function may cause preemption since it can wake up task with
+ *       higher priority than caller task
+ *
+ * @return number of tasks which were woken up
+ */
+uint_fast8_t os_futex_wake(
+   const volatile arch_atomic_t *addr,
+   uint_fast8_t nbr);
+
+#endif
+
+#endif
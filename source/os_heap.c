@@ -0,0 +1,406 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_HEAP
+
+/** Header of heap block. Both allocated and free blocks have the header. Free
+ * block list links are placed at beginning of unused payload */
+typedef struct os_heap_block_tag {
+   /** previous block in memory region, used for merging free blocks */
+   struct os_heap_block_tag *prev_phys;
+
+   /** size of block payload, lowest bit marks free block */
+   size_t size;
+
+#ifdef OS_CONFIG_HEAP_TASKSTAT
+   /** task which allocated the block, NULL if allocated from ISR */
+   os_task_t *owner;
+#endif
+
+   /** links of free list, valid only for free blocks */
+   struct os_heap_block_tag *next_free;
+   struct os_heap_block_tag *prev_free;
+} os_heap_block_t;
+
+/** alignment of blocks and their sizes, also the granularity of allocation */
+#define OS_HEAP_ALIGN ((size_t)(2 * sizeof(void*)))
+#define OS_HEAP_ROUNDUP(_s) (((_s) + OS_HEAP_ALIGN - 1) & ~(OS_HEAP_ALIGN - 1))
+#define OS_HEAP_ROUNDDOWN(_s) ((_s) & ~(OS_HEAP_ALIGN - 1))
+
+/** size of block header which precedes the allocated memory */
+#define OS_HEAP_HDRSIZE OS_HEAP_ROUNDUP(offsetof(os_heap_block_t, next_free))
+
+/** minimal payload size, it has to fit the free list links */
+#define OS_HEAP_MINSIZE \
+   ((OS_HEAP_ROUNDUP(sizeof(os_heap_block_t)) > OS_HEAP_HDRSIZE) ? \
+    (OS_HEAP_ROUNDUP(sizeof(os_heap_block_t)) - OS_HEAP_HDRSIZE) : \
+    OS_HEAP_ALIGN)
+
+/** number of second level lists in each first level range */
+#define OS_HEAP_SLCNT ((size_t)1 << OS_CONFIG_HEAP_SLCNT_LOG2)
+
+/** blocks smaller than this are kept in first level range 0, which is split
+ * linearly with OS_HEAP_ALIGN granularity */
+#define OS_HEAP_SMALL (OS_HEAP_SLCNT * OS_HEAP_ALIGN)
+
+#define OS_HEAP_FREE ((size_t)1)
+
+/* --- private functions --- */
+
+/**
+ * Function returns the index of most significant bit set + 1 or 0 if @param
+ * size is 0. It splits the size into arch_bitmask_t chunks, number of
+ * iterations is constant
+ */
+static uint_fast8_t os_heap_fls(size_t size)
+{
+   uint_fast8_t shift = (sizeof(size_t) / sizeof(arch_bitmask_t) - 1) *
+                        ARCH_BITFIELD_MAX;
+   arch_bitmask_t chunk;
+
+   for (;;) {
+      chunk = (arch_bitmask_t)(size >> shift);
+      if (chunk)
+         return shift + arch_bitmask_fls(chunk);
+      if (0 == shift)
+         return 0;
+      shift -= ARCH_BITFIELD_MAX;
+   }
+}
+
+/**
+ * Function returns index of first bit set in @param mask, starting from @param
+ * bit, or ARCH_BITFIELD_MAX if there is no such bit
+ */
+static inline uint_fast8_t os_heap_ffs(
+   arch_bitmask_t mask,
+   uint_fast8_t bit)
+{
+   mask &= (arch_bitmask_t)(~0u << bit);
+   /* isolate the lowest bit and convert it into index */
+   if (0 == mask)
+      return ARCH_BITFIELD_MAX;
+
+   return arch_bitmask_fls(mask & (arch_bitmask_t)(0u - mask)) - 1;
+}
+
+static inline size_t os_heap_size(os_heap_block_t *block)
+{
+   return block->size & ~OS_HEAP_FREE;
+}
+
+static inline os_heap_block_t *os_heap_next(os_heap_block_t *block)
+{
+   return (os_heap_block_t*)
+      ((uint8_t*)block + OS_HEAP_HDRSIZE + os_heap_size(block));
+}
+
+/**
+ * Function calculates the first and second level indexes for given block size
+ */
+static void os_heap_mapping(
+   size_t size,
+   uint_fast8_t *fl,
+   uint_fast8_t *sl)
+{
+   uint_fast8_t msb;
+
+   if (size < OS_HEAP_SMALL) {
+      *fl = 0;
+      *sl = size / OS_HEAP_ALIGN;
+   } else {
+      msb = os_heap_fls(size);
+      *fl = msb - os_heap_fls(OS_HEAP_SMALL) + 1;
+      *sl = (size >> (msb - 1 - OS_CONFIG_HEAP_SLCNT_LOG2)) ^ OS_HEAP_SLCNT;
+   }
+}
+
+static void os_heap_insert(
+   os_heap_t *heap,
+   os_heap_block_t *block)
+{
+   uint_fast8_t fl, sl;
+
+   os_heap_mapping(os_heap_size(block), &fl, &sl);
+   OS_SELFCHECK_ASSERT(fl < OS_CONFIG_HEAP_FLCNT);
+
+   block->size |= OS_HEAP_FREE;
+   block->prev_free = NULL;
+   block->next_free = heap->free_list[fl][sl];
+   if (block->next_free)
+      block->next_free->prev_free = block;
+   heap->free_list[fl][sl] = block;
+
+   arch_bitmask_set(heap->fl_mask[fl / ARCH_BITFIELD_MAX],
+                    fl % ARCH_BITFIELD_MAX);
+   arch_bitmask_set(heap->sl_mask[fl], sl);
+}
+
+static void os_heap_remove(
+   os_heap_t *heap,
+   os_heap_block_t *block)
+{
+   uint_fast8_t fl, sl;
+
+   os_heap_mapping(os_heap_size(block), &fl, &sl);
+
+   if (block->next_free)
+      block->next_free->prev_free = block->prev_free;
+   if (block->prev_free) {
+      block->prev_free->next_free = block->next_free;
+   } else {
+      heap->free_list[fl][sl] = block->next_free;
+      if (!block->next_free) {
+         arch_bitmask_clear(heap->sl_mask[fl], sl);
+         if (0 == heap->sl_mask[fl]) {
+            arch_bitmask_clear(heap->fl_mask[fl / ARCH_BITFIELD_MAX],
+                               fl % ARCH_BITFIELD_MAX);
+         }
+      }
+   }
+   block->size &= ~OS_HEAP_FREE;
+}
+
+/**
+ * Function finds free block which is guaranteed to be big enough for given
+ * size. Size is rounded up to the next second level range, so any block from
+ * found list will fit
+ */
+static os_heap_block_t *os_heap_search(
+   os_heap_t *heap,
+   size_t size)
+{
+   uint_fast8_t fl, sl, word;
+
+   if (size >= OS_HEAP_SMALL)
+      size += ((size_t)1 << (os_heap_fls(size) - 1 -
+                             OS_CONFIG_HEAP_SLCNT_LOG2)) - 1;
+   os_heap_mapping(size, &fl, &sl);
+   if (fl >= OS_CONFIG_HEAP_FLCNT)
+      return NULL;
+
+   /* first check the lists in the same first level range */
+   sl = os_heap_ffs(heap->sl_mask[fl], sl);
+   if (sl >= ARCH_BITFIELD_MAX) {
+      /* look for any list in higher first level ranges, number of loops is
+       * constant and usually == 1 */
+      ++fl;
+      for (word = fl / ARCH_BITFIELD_MAX, fl %= ARCH_BITFIELD_MAX;
+           word < OS_HEAP_FLWORDS;
+           word++, fl = 0) {
+         fl = os_heap_ffs(heap->fl_mask[word], fl);
+         if (fl < ARCH_BITFIELD_MAX)
+            break;
+      }
+      if (word >= OS_HEAP_FLWORDS)
+         return NULL;
+      fl += word * ARCH_BITFIELD_MAX;
+      sl = os_heap_ffs(heap->sl_mask[fl], 0);
+   }
+
+   return heap->free_list[fl][sl];
+}
+
+/* --- public functions --- */
+/* all public functions are documented in os_heap.h file */
+
+void os_heap_create(
+   os_heap_t *heap,
+   void *mem,
+   size_t size)
+{
+   os_heap_block_t *block;
+   os_heap_block_t *sentinel;
+   uintptr_t start;
+
+   memset(heap, 0, sizeof(os_heap_t));
+
+   /* align the beginning of region */
+   start = OS_HEAP_ROUNDUP((uintptr_t)mem);
+   OS_ASSERT(size > (start - (uintptr_t)mem) +
+                    2 * OS_HEAP_HDRSIZE + OS_HEAP_MINSIZE);
+   size = OS_HEAP_ROUNDDOWN(size - (start - (uintptr_t)mem));
+
+   /* single free block followed by zero size allocated sentinel, which
+    * prevents from merging beyond the region */
+   block = (os_heap_block_t*)start;
+   block->prev_phys = NULL;
+   block->size = size - 2 * OS_HEAP_HDRSIZE;
+   sentinel = os_heap_next(block);
+   sentinel->prev_phys = block;
+   sentinel->size = 0;
+
+   /* region exceeds the range supported by OS_CONFIG_HEAP_FLCNT */
+   OS_ASSERT(os_heap_fls(block->size) - os_heap_fls(OS_HEAP_SMALL) + 1 <
+             OS_CONFIG_HEAP_FLCNT);
+
+   heap->first = block;
+   heap->size = block->size;
+   os_heap_insert(heap, block);
+}
+
+void *os_heap_alloc(
+   os_heap_t *heap,
+   size_t size)
+{
+   arch_criticalstate_t cristate;
+   os_heap_block_t *block;
+   os_heap_block_t *rest;
+   os_task_t *owner;
+
+   if ((0 == size) || (size > heap->size))
+      return NULL;
+   size = OS_HEAP_ROUNDUP(size);
+   if (size < OS_HEAP_MINSIZE)
+      size = OS_HEAP_MINSIZE;
+
+   arch_critical_enter(cristate);
+   do {
+      block = os_heap_search(heap, size);
+      if (!block)
+         break;
+      os_heap_remove(heap, block);
+
+      /* split the block if the rest can form the new free block */
+      if (os_heap_size(block) >= size + OS_HEAP_HDRSIZE + OS_HEAP_MINSIZE) {
+         rest = (os_heap_block_t*)((uint8_t*)block + OS_HEAP_HDRSIZE + size);
+         rest->prev_phys = block;
+         rest->size = os_heap_size(block) - size - OS_HEAP_HDRSIZE;
+         os_heap_next(rest)->prev_phys = rest;
+         block->size = size;
+         os_heap_insert(heap, rest);
+      }
+
+      heap->used += os_heap_size(block);
+      if (heap->used > heap->used_peak)
+         heap->used_peak = heap->used;
+
+      owner = (isr_nesting > 0) ? NULL : task_current;
+#ifdef OS_CONFIG_HEAP_TASKSTAT
+      block->owner = owner;
+      if (owner) {
+         owner->heap_used += os_heap_size(block);
+         if (owner->heap_used > owner->heap_peak)
+            owner->heap_peak = owner->heap_used;
+      }
+#else
+      (void)owner;
+#endif
+   } while (0);
+   arch_critical_exit(cristate);
+
+   return block ? (uint8_t*)block + OS_HEAP_HDRSIZE : NULL;
+}
+
+void os_heap_free(
+   os_heap_t *heap,
+   void *ptr)
+{
+   arch_criticalstate_t cristate;
+   os_heap_block_t *block;
+   os_heap_block_t *next;
+
+   if (!ptr)
+      return;
+
+   block = (os_heap_block_t*)((uint8_t*)ptr - OS_HEAP_HDRSIZE);
+   OS_ASSERT(!(block->size & OS_HEAP_FREE)); /* double free */
+
+   arch_critical_enter(cristate);
+
+   heap->used -= os_heap_size(block);
+#ifdef OS_CONFIG_HEAP_TASKSTAT
+   if (block->owner)
+      block->owner->heap_used -= os_heap_size(block);
+#endif
+
+   /* merge with next block if it is free */
+   next = os_heap_next(block);
+   if (next->size & OS_HEAP_FREE) {
+      os_heap_remove(heap, next);
+      block->size += OS_HEAP_HDRSIZE + os_heap_size(next);
+      os_heap_next(block)->prev_phys = block;
+   }
+
+   /* merge with previous block if it is free */
+   if (block->prev_phys && (block->prev_phys->size & OS_HEAP_FREE)) {
+      next = block;
+      block = block->prev_phys;
+      os_heap_remove(heap, block);
+      block->size += OS_HEAP_HDRSIZE + os_heap_size(next);
+      os_heap_next(block)->prev_phys = block;
+   }
+
+   os_heap_insert(heap, block);
+
+   arch_critical_exit(cristate);
+}
+
+void os_heap_stats(
+   os_heap_t *heap,
+   os_heap_stats_t *stats)
+{
+   arch_criticalstate_t cristate;
+   os_heap_block_t *block;
+   size_t size;
+
+   memset(stats, 0, sizeof(os_heap_stats_t));
+
+   arch_critical_enter(cristate);
+   stats->size = heap->size;
+   stats->used = heap->used;
+   stats->used_peak = heap->used_peak;
+   /* sentinel is the only block with 0 size */
+   for (block = heap->first;
+        0 != (size = os_heap_size(block));
+        block = os_heap_next(block)) {
+      if (block->size & OS_HEAP_FREE) {
+         stats->free += size;
+         stats->free_blocks++;
+         if (size > stats->free_largest)
+            stats->free_largest = size;
+      } else {
+         stats->used_blocks++;
+      }
+   }
+   arch_critical_exit(cristate);
+
+   if (stats->free) {
+      stats->fragmentation = (uint_fast8_t)
+         (100 - (stats->free_largest * 100) / stats->free);
+   }
+}
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_HEAP_
+#define __OS_HEAP_
+
+#ifdef OS_CONFIG_HEAP
+
+/**
+ * Heap is the real time allocator of variable size memory blocks implemented
+ * as TLSF (two level segregated fit). It has following characteristics:
+ * - heap manages statically provided memory region, there may be many
+ *   independent heaps
+ * - free blocks are kept on segregated lists. First level splits the sizes by
+ *   power of 2, second level splits each first level range into
+ *   2^OS_CONFIG_HEAP_SLCNT_LOG2 equal subranges. Non empty lists are marked in
+ *   bitmasks, so the suitable list is found by arch_bitmask_fls() in the same
+ *   way as the most prioritized task in task_queue
+ * - both os_heap_alloc() and os_heap_free() execute in bounded time which does
+ *   not depend on number of allocated blocks. Neighbour free blocks are merged
+ *   immediately in os_heap_free()
+ * - allocation and free are done in critical section so they can be called
+ *   from ISR
+ * - allocation may return NULL even if there is enough free memory in case it
+ *   is fragmented or the only suitable block is in the same second level
+ *   range as requested size (good fit instead of best fit)
+ * - with OS_CONFIG_HEAP_TASKSTAT each allocated block remembers the task which
+ *   allocated it and bytes are accounted in heap_used and heap_peak fields of
+ *   task TCB. Blocks allocated from ISR are not accounted to any task.
+ */
+
+/** Number of arch_bitmask_t words needed for first level bitmask */
+#define OS_HEAP_FLWORDS \
+   ((OS_CONFIG_HEAP_FLCNT + ARCH_BITFIELD_MAX - 1) / ARCH_BITFIELD_MAX)
+
+/** Definition of heap structure */
+typedef struct {
+   /** bitmask of non empty first level ranges */
+   arch_bitmask_t fl_mask[OS_HEAP_FLWORDS];
+
+   /** bitmasks of non empty second level lists for each first level range */
+   arch_bitmask_t sl_mask[OS_CONFIG_HEAP_FLCNT];
+
+   /** heads of free block lists */
+   struct os_heap_block_tag
+      *free_list[OS_CONFIG_HEAP_FLCNT][1 << OS_CONFIG_HEAP_SLCNT_LOG2];
+
+   /** first block in memory region */
+   struct os_heap_block_tag *first;
+
+   /** size of memory region managed by heap (without internal headers) */
+   size_t size;
+
+   /** number of bytes currently allocated */
+   size_t used;
+
+   /** high water mark of allocated bytes */
+   size_t used_peak;
+
+} os_heap_t;
+
+/** Heap statistics and fragmentation report */
+typedef struct {
+   size_t size;          /**< size of memory region managed by heap */
+   size_t used;          /**< number of bytes currently allocated */
+   size_t used_peak;     /**< high water mark of allocated bytes */
+   size_t used_blocks;   /**< number of allocated blocks */
+   size_t free;          /**< number of free bytes */
+   size_t free_largest;  /**< size of largest free block */
+   size_t free_blocks;   /**< number of free blocks */
+   uint_fast8_t fragmentation; /**< free memory which is not part of largest
+                                    free block, in percents */
+} os_heap_stats_t;
+
+/**
+ * Function creates the heap in given memory region
+ *
+ * @param heap pointer to heap
+ * @param mem pointer to memory region
+ * @param size size of memory region, maximal supported size depends on
+ *        OS_CONFIG_HEAP_FLCNT
+ */
+void os_heap_create(
+   os_heap_t *heap,
+   void *mem,
+   size_t size);
+
+/**
+ * Function allocates memory block from heap
+ *
+ * @param heap pointer to heap
+ * @param size requested size of block in bytes
+ *
+ * @pre this function CAN be called from ISR
+ *
+ * @return pointer to allocated memory block aligned to 2 * sizeof(void*), NULL
+ *         in case there was no suitable free block or @param size was 0
+ */
+void *os_heap_alloc(
+   os_heap_t *heap,
+   size_t size);
+
+/**
+ * Function returns memory block to heap
+ *
+ * @param heap pointer to heap
+ * @param ptr pointer to block allocated from the same heap, NULL is ignored
+ *
+ * @pre this function CAN be called from ISR
+ * @pre if OS_CONFIG_HEAP_TASKSTAT is defined, task which allocated the block
+ *      must still exist (its TCB is updated)
+ */
+void os_heap_free(
+   os_heap_t *heap,
+   void *ptr);
+
+/**
+ * Function gathers heap statistics and fragmentation report
+ *
+ * @param heap pointer to heap
+ * @param stats pointer to structure which will be filled with statistics
+ *
+ * @note Function walks through all blocks in critical section, the execution
+ *       time depends on number of blocks. Do not use it in time critical code.
+ */
+void os_heap_stats(
+   os_heap_t *heap,
+   os_heap_stats_t *stats);
+
+#endif
+
+#endif
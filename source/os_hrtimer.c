@@ -0,0 +1,247 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_HRTIMER
+
+/** Binary min-heap of active hrtimers, ordered by deadline. Each active timer
+ * keeps its own index in the heap, so it can be removed without search */
+static os_hrtimer_t *hrtimer_heap[OS_CONFIG_HRTIMER_CNT];
+
+/** Number of active hrtimers in hrtimer_heap */
+static size_t hrtimer_cnt;
+
+/** Sequence number of hrtimer_add(), keeps FIFO order of equal deadlines */
+static uint64_t hrtimer_seq;
+
+/* private function forward declarations */
+static bool hrtimer_is_active(os_hrtimer_t *timer);
+static void hrtimer_add(os_hrtimer_t *timer);
+static void hrtimer_remove(os_hrtimer_t *timer);
+static void hrtimer_rearm(void);
+
+/* --- public functions --- */
+/* all public functions are documented in os_hrtimer.h file */
+
+uint64_t os_hrtimer_now(void)
+{
+   return arch_hrtimer_now();
+}
+
+void os_hrtimer_start(
+   os_hrtimer_t *timer,
+   timer_proc_t clbck,
+   void *param,
+   uint64_t timeout_ns,
+   uint64_t period_ns)
+{
+   arch_criticalstate_t cristate;
+   os_hrtimer_t *first;
+
+   OS_ASSERT(timeout_ns > 0);
+
+   arch_critical_enter(cristate);
+   first = (hrtimer_cnt > 0) ? hrtimer_heap[0] : NULL;
+   if (hrtimer_is_active(timer)) {
+      /* restart of active timer, it cannot stay in heap with old deadline */
+      hrtimer_remove(timer);
+   }
+   timer->period_ns = period_ns;
+   timer->clbck = clbck;
+   timer->param = param;
+   timer->deadline_ns = arch_hrtimer_now() + timeout_ns;
+   hrtimer_add(timer);
+   if ((hrtimer_heap[0] == timer) || (hrtimer_heap[0] != first)) {
+      /* new earliest deadline */
+      hrtimer_rearm();
+   }
+   arch_critical_exit(cristate);
+}
+
+void os_hrtimer_cancel(os_hrtimer_t *timer)
+{
+   arch_criticalstate_t cristate;
+   bool first;
+
+   arch_critical_enter(cristate);
+   if (hrtimer_is_active(timer)) {
+      first = (hrtimer_heap[0] == timer);
+      hrtimer_remove(timer);
+      if (first)
+         hrtimer_rearm();
+   }
+   arch_critical_exit(cristate);
+}
+
+/* --- protected functions --- */
+
+void os_hrtimer_init(void)
+{
+   hrtimer_cnt = 0;
+   hrtimer_seq = 0;
+   arch_hrtimer_init();
+}
+
+void os_hrtimer_isr(void)
+{
+   arch_criticalstate_t cristate;
+   os_hrtimer_t *timer;
+   uint64_t now;
+
+   arch_critical_enter(cristate);
+
+   now = arch_hrtimer_now();
+   while (hrtimer_cnt > 0) {
+      timer = hrtimer_heap[0];
+      if (timer->deadline_ns > now)
+         break; /* heap root has earliest deadline, none of others expired */
+
+      hrtimer_remove(timer);
+      if (timer->period_ns > 0) {
+         /* reload from previous deadline, skip the missed periods. Reloaded
+          * deadline is always in future so timer will not expire again in
+          * this loop */
+         timer->deadline_ns += timer->period_ns;
+         if (OS_UNLIKELY(timer->deadline_ns <= now)) {
+            timer->deadline_ns += timer->period_ns *
+               (((now - timer->deadline_ns) / timer->period_ns) + 1);
+         }
+         hrtimer_add(timer);
+      }
+      /* callback may cancel or restart the timer */
+      timer->clbck(timer->param);
+   }
+
+   hrtimer_rearm();
+
+   /* callbacks might wake up tasks */
+   os_schedule(1);
+
+   arch_critical_exit(cristate);
+}
+
+/* --- private functions --- */
+
+/** Function returns true if timer a expires before timer b. Timers with the
+ * same deadline expire in FIFO order */
+static inline bool hrtimer_before(os_hrtimer_t *a, os_hrtimer_t *b)
+{
+   return (a->deadline_ns < b->deadline_ns) ||
+          ((a->deadline_ns == b->deadline_ns) && (a->seq < b->seq));
+}
+
+/** Function puts the timer at given index of heap */
+static inline void hrtimer_place(os_hrtimer_t *timer, size_t idx)
+{
+   hrtimer_heap[idx] = timer;
+   timer->idx = idx;
+}
+
+/** Function moves the timer from idx towards the root of heap until its parent
+ * expires earlier */
+static void hrtimer_siftup(os_hrtimer_t *timer, size_t idx)
+{
+   size_t parent;
+
+   while (idx > 0) {
+      parent = (idx - 1) / 2;
+      if (!hrtimer_before(timer, hrtimer_heap[parent]))
+         break;
+      hrtimer_place(hrtimer_heap[parent], idx);
+      idx = parent;
+   }
+   hrtimer_place(timer, idx);
+}
+
+/** Function moves the timer from idx towards the leafs of heap until both its
+ * children expire later */
+static void hrtimer_siftdown(os_hrtimer_t *timer, size_t idx)
+{
+   size_t child;
+
+   while ((child = (2 * idx) + 1) < hrtimer_cnt) {
+      if (((child + 1) < hrtimer_cnt) &&
+          hrtimer_before(hrtimer_heap[child + 1], hrtimer_heap[child]))
+         ++child;
+      if (!hrtimer_before(hrtimer_heap[child], timer))
+         break;
+      hrtimer_place(hrtimer_heap[child], idx);
+      idx = child;
+   }
+   hrtimer_place(timer, idx);
+}
+
+/** Function checks if timer is in heap. It does not depend on the content of
+ * timer memory, so it is safe also for timers which were never started */
+static bool hrtimer_is_active(os_hrtimer_t *timer)
+{
+   return (timer->idx < hrtimer_cnt) && (hrtimer_heap[timer->idx] == timer);
+}
+
+/** Function adds the timer to the heap of active hrtimers */
+static void hrtimer_add(os_hrtimer_t *timer)
+{
+   /* increase OS_CONFIG_HRTIMER_CNT in case of this assert */
+   OS_ASSERT(hrtimer_cnt < OS_CONFIG_HRTIMER_CNT);
+
+   timer->seq = hrtimer_seq++;
+   hrtimer_siftup(timer, hrtimer_cnt++);
+}
+
+/** Function removes the active timer from the heap, the last timer from heap
+ * takes its place */
+static void hrtimer_remove(os_hrtimer_t *timer)
+{
+   os_hrtimer_t *last;
+   size_t idx = timer->idx;
+
+   last = hrtimer_heap[--hrtimer_cnt];
+   if (last != timer) {
+      if ((idx > 0) && hrtimer_before(last, hrtimer_heap[(idx - 1) / 2]))
+         hrtimer_siftup(last, idx);
+      else
+         hrtimer_siftdown(last, idx);
+   }
+   timer->idx = OS_CONFIG_HRTIMER_CNT;
+}
+
+/** Function arms the host timer for the earliest deadline, or disarms it in
+ * case there are no active hrtimers */
+static void hrtimer_rearm(void)
+{
+   if (hrtimer_cnt > 0)
+      arch_hrtimer_arm(hrtimer_heap[0]->deadline_ns);
+   else
+      arch_hrtimer_arm(0);
+}
+
+#endif
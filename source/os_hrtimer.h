@@ -0,0 +1,103 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_HRTIMER_
+#define __OS_HRTIMER_
+
+#ifdef OS_CONFIG_HRTIMER
+
+/**
+ * High resolution timers are the sub-tick timers with nanosecond deadlines.
+ * They do not depend on os_tick(), instead they use the one-shot timer of the
+ * architecture (ARCH_HAS_HRTIMER) which is always armed for the earliest
+ * deadline. Because of that they can be used for control loops with periods
+ * much shorter than the system tick, without increasing the tick frequency.
+ * Characteristic of hrtimers:
+ * - active timers are kept in binary min-heap ordered by absolute deadline, so
+ *   os_hrtimer_start(), os_hrtimer_cancel() and expiration cost O(log n) and
+ *   do not depend linearly on the number of active timers. The heap is static
+ *   array of OS_CONFIG_HRTIMER_CNT pointers
+ * - callbacks are called from the hrtimer ISR, so they can use only those OS
+ *   functions which can be called from ISR
+ * - periodic timers are reloaded from previous deadline (not from the moment
+ *   of callback) so they do not drift. In case ISR latency was longer than the
+ *   period, missed periods are skipped
+ */
+
+/** Definition of high resolution timer */
+typedef struct {
+   size_t idx;                /**< index in heap of active hrtimers */
+   uint64_t seq;              /**< sequence of start, for FIFO order */
+   uint64_t deadline_ns;      /**< absolute expiration time */
+   uint64_t period_ns;        /**< period of auto-reload, 0 for one-shot */
+   timer_proc_t clbck;        /**< callback called at expiration */
+   void *param;               /**< parameter for callback */
+} os_hrtimer_t;
+
+/**
+ * Function returns the current time of high resolution clock
+ *
+ * @return monotonic time in nanoseconds
+ */
+uint64_t os_hrtimer_now(void);
+
+/**
+ * Function starts the high resolution timer
+ *
+ * @param timer pointer to hrtimer, memory must be valid until timer expires (or
+ *        until os_hrtimer_cancel() for periodic timers)
+ * @param clbck callback called from hrtimer ISR at expiration
+ * @param param parameter which will be passed to callback function
+ * @param timeout_ns time from now until expiration in nanoseconds, must be > 0
+ * @param period_ns period of the timer in nanoseconds, 0 for one-shot timers
+ *
+ * @post Starting the timer which is still active restarts it with new
+ *       parameters, it will expire only once at the new deadline.
+ */
+void os_hrtimer_start(
+   os_hrtimer_t *timer,
+   timer_proc_t clbck,
+   void *param,
+   uint64_t timeout_ns,
+   uint64_t period_ns);
+
+/**
+ * Function stops the high resolution timer. It is allowed to cancel the timer
+ * which already expired or which was already canceled, also from its own
+ * callback.
+ *
+ * @param timer pointer to hrtimer which was started before
+ */
+void os_hrtimer_cancel(os_hrtimer_t *timer);
+
+#endif
+
+#endif
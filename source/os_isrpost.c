@@ -0,0 +1,159 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_ISRPOST
+
+/** Definition of deferred post record */
+typedef struct {
+   void *obj;
+   uint32_t arg;
+   os_isrpost_op_t op;
+} os_isrpost_rec_t;
+
+/** Indexes run over twice the queue size, so full and empty queue can be
+ * distinguished */
+#define OS_ISRPOST_IDXMASK ((arch_atomic_t)(2 * OS_CONFIG_ISRPOST_SIZE - 1))
+
+/** Queue of post records */
+static os_isrpost_rec_t isrpost_queue[OS_CONFIG_ISRPOST_SIZE];
+
+/** Index of next free slot, reserved by ISRs */
+static arch_atomic_t isrpost_in;
+
+/** Index of next record to apply, modified only by softirq */
+static arch_atomic_t isrpost_out;
+
+/* private function forward declarations */
+static void os_isrpost_apply(os_isrpost_rec_t *rec);
+static void os_isrpost_softirq(void *param);
+
+/* --- public functions --- */
+/* all public functions are documented in os_isrpost.h file */
+
+void os_isrpost(
+   os_isrpost_op_t op,
+   void *obj,
+   uint32_t arg)
+{
+   os_isrpost_rec_t *rec;
+   os_isrpost_rec_t tmp;
+   arch_atomic_t in;
+
+   OS_ASSERT(isr_nesting > 0); /* only ISR can post */
+
+   /* reserve the slot, nested ISR may reserve the slot in meantime. Reserved
+    * slot is always filled before softirq runs since softirq runs only after
+    * all ISRs finished */
+   in = os_atomic_load(&isrpost_in);
+   do {
+      if (((in - os_atomic_load(&isrpost_out)) & OS_ISRPOST_IDXMASK) >=
+          OS_CONFIG_ISRPOST_SIZE) {
+         /* queue is full, apply as direct call from ISR would do */
+         tmp.obj = obj;
+         tmp.arg = arg;
+         tmp.op = op;
+         os_isrpost_apply(&tmp);
+         return;
+      }
+   } while (os_atomic_cmp_exch(
+               &isrpost_in, &in, (in + 1) & OS_ISRPOST_IDXMASK));
+
+   rec = &isrpost_queue[in & (OS_CONFIG_ISRPOST_SIZE - 1)];
+   rec->obj = obj;
+   rec->arg = arg;
+   rec->op = op;
+
+   os_softirq_raise(OS_CONFIG_ISRPOST_SOFTIRQ);
+}
+
+/* --- protected functions --- */
+
+void os_isrpost_init(void)
+{
+   isrpost_in = 0;
+   isrpost_out = 0;
+   os_softirq_register(OS_CONFIG_ISRPOST_SOFTIRQ, os_isrpost_softirq, NULL);
+}
+
+/* --- private functions --- */
+
+/**
+ * Function applies the post record by calling the wakeup function
+ */
+static void os_isrpost_apply(os_isrpost_rec_t *rec)
+{
+   uint32_t i;
+
+   switch (rec->op) {
+   case OS_ISRPOST_SEM_UP:
+      for (i = 0; i < rec->arg; i++)
+         os_sem_up((os_sem_t*)rec->obj);
+      break;
+#ifdef OS_CONFIG_WAITQUEUE
+   case OS_ISRPOST_WAITQUEUE_WAKEUP:
+      os_waitqueue_wakeup((os_waitqueue_t*)rec->obj, (uint_fast8_t)rec->arg);
+      break;
+#endif
+#ifdef OS_CONFIG_EVFLAGS
+   case OS_ISRPOST_EVFLAGS_SET:
+      (void)os_evflags_set((os_evflags_t*)rec->obj, rec->arg);
+      break;
+#endif
+#ifdef OS_CONFIG_TASKNOTIFY
+   case OS_ISRPOST_TASK_NOTIFY:
+      os_task_notify((os_task_t*)rec->obj, rec->arg, OS_NOTIFY_SETBITS);
+      break;
+#endif
+   default:
+      OS_ASSERT(0);
+      break;
+   }
+}
+
+/**
+ * Softirq handler which applies all queued records. Runs at exit of most
+ * outer ISR, with interrupts enabled
+ */
+static void os_isrpost_softirq(void *OS_UNUSED(param))
+{
+   arch_atomic_t out = isrpost_out;
+
+   while (out != os_atomic_load(&isrpost_in)) {
+      os_isrpost_apply(&isrpost_queue[out & (OS_CONFIG_ISRPOST_SIZE - 1)]);
+      /* free the slot after the record was applied */
+      out = (out + 1) & OS_ISRPOST_IDXMASK;
+      os_atomic_store(&isrpost_out, out);
+   }
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_ISRPOST_
+#define __OS_ISRPOST_
+
+#ifdef OS_CONFIG_ISRPOST
+
+/**
+ * Deferred ISR posting. Instead of calling os_sem_up() and other wakeup
+ * functions directly, ISR can push small post record (object, operation,
+ * argument) into lock-free queue. Records are applied by softirq
+ * OS_CONFIG_ISRPOST_SOFTIRQ which runs at exit of most outer ISR with
+ * interrupts enabled (see os_softirq.h). Deferred posting has following
+ * characteristics:
+ * - ISR does not manipulate the kernel lists, so the time spent with
+ *   interrupts disabled by top half of ISR is limited to few instructions
+ *   needed to reserve the queue slot
+ * - records are applied in order in which they were posted, before any task
+ *   resumes. From point of view of tasks the effect is the same as for
+ *   direct call
+ * - in case queue is full, the record is applied immediately (as direct call
+ *   from ISR would do). This keeps the semantic but such record may be
+ *   applied before records which are still in queue
+ * - queue has OS_CONFIG_ISRPOST_SIZE slots, it should be sized for maximal
+ *   number of posts between two exits of most outer ISR
+ */
+
+/** Operation applied by deferred post */
+typedef enum {
+   OS_ISRPOST_SEM_UP = 0,       /**< os_sem_up() arg times, obj is os_sem_t */
+#ifdef OS_CONFIG_WAITQUEUE
+   OS_ISRPOST_WAITQUEUE_WAKEUP, /**< os_waitqueue_wakeup(), arg is number of
+                                     tasks, obj is os_waitqueue_t */
+#endif
+#ifdef OS_CONFIG_EVFLAGS
+   OS_ISRPOST_EVFLAGS_SET,      /**< os_evflags_set(), arg is mask, obj is
+                                     os_evflags_t */
+#endif
+#ifdef OS_CONFIG_TASKNOTIFY
+   OS_ISRPOST_TASK_NOTIFY,      /**< os_task_notify() with OS_NOTIFY_SETBITS,
+                                     arg is value, obj is os_task_t */
+#endif
+} os_isrpost_op_t;
+
+/**
+ * Function posts the deferred operation on kernel object
+ *
+ * @param op operation
+ * @param obj pointer to kernel object, type depends on @param op
+ * @param arg argument of operation, meaning depends on @param op
+ *
+ * @pre this function can be called ONLY from ISR
+ * @pre object must not be destroyed until the record is applied
+ */
+void os_isrpost(
+   os_isrpost_op_t op,
+   void *obj,
+   uint32_t arg);
+
+/**
+ * Function posts deferred os_sem_up()
+ *
+ * @pre this function can be called ONLY from ISR
+ */
+static inline void os_isrpost_sem_up(os_sem_t *sem)
+{
+   os_isrpost(OS_ISRPOST_SEM_UP, sem, 1);
+}
+
+#ifdef OS_CONFIG_WAITQUEUE
+/**
+ * Function posts deferred os_waitqueue_wakeup()
+ *
+ * @pre this function can be called ONLY from ISR
+ */
+static inline void os_isrpost_waitqueue_wakeup(
+   os_waitqueue_t *queue,
+   uint_fast8_t nbr)
+{
+   os_isrpost(OS_ISRPOST_WAITQUEUE_WAKEUP, queue, nbr);
+}
+#endif
+
+#ifdef OS_CONFIG_EVFLAGS
+/**
+ * Function posts deferred os_evflags_set()
+ *
+ * @pre this function can be called ONLY from ISR
+ */
+static inline void os_isrpost_evflags_set(
+   os_evflags_t *evflags,
+   uint32_t mask)
+{
+   os_isrpost(OS_ISRPOST_EVFLAGS_SET, evflags, mask);
+}
+#endif
+
+#ifdef OS_CONFIG_TASKNOTIFY
+/**
+ * Function posts deferred os_task_notify() with OS_NOTIFY_SETBITS action
+ *
+ * @pre this function can be called ONLY from ISR
+ */
+static inline void os_isrpost_task_notify(
+   os_task_t *task,
+   uint32_t value)
+{
+   os_isrpost(OS_ISRPOST_TASK_NOTIFY, task, value);
+}
+#endif
+
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_MBOX
+
+/* private function forward declarations */
+static void os_mbox_timerclbck(void *param);
+
+/* --- public functions --- */
+/* all public functions are documented in os_mbox.h file */
+
+void os_mbox_create(
+   os_mbox_t *mbox,
+   void *mem,
+   size_t msg_size,
+   arch_ridx_t msg_cnt)
+{
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   OS_ASSERT(msg_cnt > 0);
+   OS_ASSERT(msg_size > 0);
+   OS_ASSERT(0 == ((uintptr_t)mem % sizeof(void*)));
+
+   memset(mbox, 0, sizeof(os_mbox_t));
+   os_taskqueue_init(&(mbox->task_queue));
+   /* ring is placed at the beginning of memory, message slots after it */
+   mbox->ring = (void**)mem;
+   mbox->size = msg_cnt;
+   os_pool_create(&(mbox->pool), mbox->ring + msg_cnt,
+                  OS_MBOX_SLOTSIZE(msg_size), msg_cnt);
+}
+
+void os_mbox_destroy(os_mbox_t *mbox)
+{
+   arch_criticalstate_t cristate;
+   os_task_t *task;
+
+   OS_ASSERT(0 == isr_nesting);     /* cannot call from ISR */
+   OS_ASSERT(!waitqueue_current);   /* cannot call after os_waitqueue_prepare() */
+
+   arch_critical_enter(cristate);
+
+   /* wake up all task which suspended in os_mbox_borrow() */
+   while ((task = os_taskqueue_dequeue(&(mbox->task_queue)))) {
+      os_blocktimer_destroy(task); /* destroy the tasks timer */
+      task->block_code = OS_DESTROYED;
+      os_task_makeready(task);
+   }
+   /* this will also wake up tasks suspended in os_mbox_reserve() and call the
+    * os_schedule() */
+   os_pool_destroy(&(mbox->pool));
+   memset(mbox, 0, sizeof(os_mbox_t));
+
+   arch_critical_exit(cristate);
+}
+
+void *os_mbox_reserve(
+   os_mbox_t *mbox,
+   os_ticks_t timeout_ticks)
+{
+   /* tasks can block only with timeout, ISR can only try */
+   OS_ASSERT((0 == isr_nesting) || (OS_TIMEOUT_TRY == timeout_ticks));
+
+   if (OS_TIMEOUT_TRY == timeout_ticks)
+      return os_pool_alloc(&(mbox->pool));
+
+   return os_pool_alloc_wait(&(mbox->pool), timeout_ticks);
+}
+
+void os_mbox_commit(
+   os_mbox_t *mbox,
+   void *msg)
+{
+   arch_criticalstate_t cristate;
+   os_task_t *task;
+
+   /* tasks cannot call any OS functions if they are 'prepared' to suspend on
+    * wait_queue, with exception to ISR's */
+   OS_ASSERT((isr_nesting > 0) || (!waitqueue_current));
+
+   arch_critical_enter(cristate);
+
+   task = os_taskqueue_dequeue(&(mbox->task_queue));
+   if (task) {
+      /* receiver is waiting so the ring is empty, hand over the message
+       * directly to the most prioritized receiver */
+      os_blocktimer_destroy(task);
+      task->pool_block = msg;
+      task->block_code = OS_OK; /* set the block code to NORMAL WAKEUP */
+      os_task_makeready(task);
+
+      /* switch to more prioritized READY task, if there is such (1 as param
+       * in os_schedule() means just that */
+      os_schedule(1);
+   } else {
+      /* ring cannot overflow since there are as many ring entries as slots */
+      OS_SELFCHECK_ASSERT(mbox->cnt < mbox->size);
+      mbox->ring[mbox->in] = msg;
+      if (++(mbox->in) == mbox->size)
+         mbox->in = 0;
+      ++(mbox->cnt);
+   }
+
+   arch_critical_exit(cristate);
+}
+
+void *os_mbox_borrow(
+   os_mbox_t *mbox,
+   os_ticks_t timeout_ticks)
+{
+   void *msg = NULL;
+   os_timer_t timer;
+   arch_criticalstate_t cristate;
+
+   /* tasks can block only with timeout, ISR can only try */
+   OS_ASSERT((0 == isr_nesting) || (OS_TIMEOUT_TRY == timeout_ticks));
+   OS_ASSERT((isr_nesting > 0) || (!waitqueue_current));
+
+   arch_critical_enter(cristate);
+   do {
+      if (mbox->cnt > 0) {
+         msg = mbox->ring[mbox->out];
+         if (++(mbox->out) == mbox->size)
+            mbox->out = 0;
+         --(mbox->cnt);
+         break;
+      }
+
+      if (OS_TIMEOUT_TRY == timeout_ticks)
+         break;
+
+      /* following are checked only for blocking call */
+      OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+      /* calling of blocking function while holding mtx or rwlock will cause
+       * priority inversion */
+      OS_ASSERT(list_is_empty(&task_current->mtx_list));
+      OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+      /* does task request timeout guard for operation? */
+      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+         /* we will get callback to os_mbox_timerclbck() in case of timeout */
+         os_blocktimer_create(&timer, os_mbox_timerclbck, timeout_ticks);
+      }
+
+      os_task_block_switch(&(mbox->task_queue), OS_TASKBLOCK_MBOX);
+
+      /* we return here either after os_mbox_commit(), destroy or timeout.
+       * Destroy the timeout guard if it was created */
+      os_blocktimer_destroy(task_current);
+
+      /* in case of normal wakeup the message was handed over by
+       * os_mbox_commit() */
+      if (OS_OK == task_current->block_code)
+         msg = task_current->pool_block;
+
+   } while (0);
+   arch_critical_exit(cristate);
+
+   return msg;
+}
+
+/**
+ * Function called by timers module. Used for timeout of os_mbox_borrow()
+ * Callback to this function are done from context of timer_trigger().
+ */
+static void os_mbox_timerclbck(void *param)
+{
+   /* single timer has param in os_blocktimer_create() as pointer to task
+    * structure */
+   os_task_t *task = (os_task_t*)param;
+
+   OS_SELFCHECK_ASSERT(TASKSTATE_WAIT == task->state);
+
+   /* remove task from mailbox task_queue */
+   os_taskqueue_unlink(task);
+   task->block_code = OS_TIMEOUT;
+   os_task_makeready(task);
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of timer_trigger() */
+}
+
+#endif
@@ -0,0 +1,204 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_MBOX_
+#define __OS_MBOX_
+
+#ifdef OS_CONFIG_MBOX
+
+/**
+ * Mailbox allows to pass messages between tasks and ISRs without copying of
+ * the message payload. It has following characteristics:
+ * - mailbox owns the fixed number of message slots of the same size. Slots are
+ *   kept in os_pool_t so they are reserved and released in constant time
+ * - sender reserves the free slot by os_mbox_reserve(), fills the message in
+ *   place and publishes it by os_mbox_commit(). Receiver borrows the oldest
+ *   committed message by os_mbox_borrow(), processes it in place and gives the
+ *   slot back by os_mbox_release(). Only the pointer is passed, the payload is
+ *   never copied
+ * - messages are received in commit order (FIFO), which does not have to be
+ *   the same as reservation order. Many senders and receivers may use the same
+ *   mailbox
+ * - os_mbox_reserve() suspends the task while all slots are in use,
+ *   os_mbox_borrow() suspends the task while there is no committed message.
+ *   Both accept timeout. Committed message is handed over directly to the most
+ *   prioritized waiting receiver
+ * - ISR may reserve and borrow with OS_TIMEOUT_TRY and commit or release
+ *   without any limitation. Commit never blocks since there are as many
+ *   places in the mailbox ring as slots
+ */
+
+/** Definition of mailbox structure */
+typedef struct {
+   /** queue of tasks suspended in os_mbox_borrow() */
+   os_taskqueue_t task_queue;
+
+   /** pool of message slots, also queues tasks suspended in
+    * os_mbox_reserve() */
+   os_pool_t pool;
+
+   /** ring of committed messages */
+   void **ring;
+
+   /** number of slots and ring entries */
+   arch_ridx_t size;
+
+   /** ring index where next committed message will be stored */
+   arch_ridx_t in;
+
+   /** ring index of oldest committed message */
+   arch_ridx_t out;
+
+   /** number of committed messages in ring */
+   arch_ridx_t cnt;
+
+} os_mbox_t;
+
+/**
+ * Calculates the size of message slot for given message size
+ */
+#define OS_MBOX_SLOTSIZE(_msg_size) \
+   (((_msg_size) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+/**
+ * Calculates the size of memory which must be provided for mailbox with given
+ * message size and number of messages
+ */
+#define OS_MBOX_MEMSIZE(_msg_size, _msg_cnt) \
+   ((_msg_cnt) * (sizeof(void*) + OS_MBOX_SLOTSIZE(_msg_size)))
+
+/**
+ * Function creates the mailbox
+ *
+ * @param mbox pointer to mailbox
+ * @param mem pointer to memory for message slots and mailbox ring, must be
+ *        aligned to sizeof(void*) and has the size given by OS_MBOX_MEMSIZE()
+ * @param msg_size size of single message
+ * @param msg_cnt number of message slots, must be > 0
+ */
+void os_mbox_create(
+   os_mbox_t *mbox,
+   void *mem,
+   size_t msg_size,
+   arch_ridx_t msg_cnt);
+
+/**
+ * Function destroys the mailbox
+ *
+ * @param mbox pointer to mailbox
+ *
+ * @pre mailbox must be initialized prior call of this function
+ * @pre this function cannot be called from ISR
+ *
+ * @post tasks suspended on mailbox will be released with NULL as result of
+ *       os_mbox_reserve() or os_mbox_borrow(). The same race conditions as
+ *       described for os_sem_destroy() apply here.
+ * @post this function may cause preemption since this function wakes up tasks
+ *       suspended on mailbox
+ */
+void os_mbox_destroy(os_mbox_t *mbox);
+
+/**
+ * Function reserves the free message slot. In case all slots are in use
+ * function will suspend calling task until some message will be released or
+ * when requested timeout will burn off.
+ *
+ * @param mbox pointer to mailbox
+ * @param timeout_ticks number of jiffies (os_tick() call count) before
+ *        operation will time out. OS_TIMEOUT_INFINITE and OS_TIMEOUT_TRY have
+ *        the same meaning as for os_sem_down().
+ *
+ * @pre this function can be called from ISR only with OS_TIMEOUT_TRY
+ *
+ * @return pointer to message slot, NULL in case of timeout, when there was no
+ *         free slot and @param timeout_ticks was OS_TIMEOUT_TRY or when mailbox
+ *         was destroyed while task was suspended
+ */
+void *os_mbox_reserve(
+   os_mbox_t *mbox,
+   os_ticks_t timeout_ticks);
+
+/**
+ * Function publishes the message for receivers
+ *
+ * @param mbox pointer to mailbox
+ * @param msg pointer to message slot returned by os_mbox_reserve()
+ *
+ * @pre this function CAN be called from ISR
+ *
+ * @post this function may cause preemption since it can wake up task with
+ *       higher priority than caller task
+ */
+void os_mbox_commit(
+   os_mbox_t *mbox,
+   void *msg);
+
+/**
+ * Function borrows the oldest committed message. In case there is no message
+ * function will suspend calling task until some message will be committed or
+ * when requested timeout will burn off.
+ *
+ * @param mbox pointer to mailbox
+ * @param timeout_ticks the same meaning as for os_mbox_reserve()
+ *
+ * @pre this function can be called from ISR only with OS_TIMEOUT_TRY
+ *
+ * @return pointer to message, NULL in case of timeout, when there was no
+ *         message and @param timeout_ticks was OS_TIMEOUT_TRY or when mailbox
+ *         was destroyed while task was suspended
+ */
+void *os_mbox_borrow(
+   os_mbox_t *mbox,
+   os_ticks_t timeout_ticks);
+
+/**
+ * Function gives back the message slot to mailbox. It can be also used to
+ * cancel reserved but not committed message.
+ *
+ * @param mbox pointer to mailbox
+ * @param msg pointer to message returned by os_mbox_borrow() or
+ *        os_mbox_reserve()
+ *
+ * @pre this function CAN be called from ISR
+ *
+ * @post this function may cause preemption since it can wake up task with
+ *       higher priority than caller task
+ */
+static inline void os_mbox_release(
+   os_mbox_t *mbox,
+   void *msg)
+{
+   os_pool_free(&(mbox->pool), msg);
+}
+
+#endif
+
+#endif
@@ -68,41 +68,67 @@ static inline void os_mtx_clear_owner(os_mtx_t *mtx)
  */
 static void os_mtx_lock_prio_boost(os_mtx_t *mtx)
 {
-   os_task_t *task = mtx->owner;
-   const uint_fast8_t task_current_prio = task_current->prio_current;
+   /* why we walk through the blocking chain ? see comment 2 */
+   os_task_prio_boost(mtx->owner, task_current->prio_current);
+}
 
-   /* check for priority inversion precondition */
-   if (task->prio_current < task_current_prio) {
+/* --- protected functions --- */
 
-      /* why we use loop here ? see comment 2 */
-      while (1) {
+/**
+ * Function boosts the priority of @param task to at least @param prio and then
+ * walks down the blocking chain (see comment 2). In case the task is blocked on
+ * mutex we continue with owner of this mutex. In case the task is blocked on
+ * rwlock, all owners of this rwlock are boosted (bounded by
+ * OS_CONFIG_RWLOCK_OWNERS).
+ * We can stop the walk as soon as we meet the task which already has the prio
+ * equal or greater than @param prio, since all of its blockers were already
+ * boosted at least to its prio while it was blocking on resource.
+ */
+void os_task_prio_boost(
+   os_task_t *task,
+   uint_fast8_t prio)
+{
+   os_rwlock_t *rwlock;
+   uint_fast8_t i;
 
-         uint_fast8_t prio_new;
+   while (task->prio_current < prio) {
 
-         /* boost the prio of task which hold mtx */
-         prio_new = os_max(task_current->prio_current, task_current_prio);
-         os_taskqueue_reprio(task, prio_new);
+      /* boost the prio of task which hold the resource */
+      os_taskqueue_reprio(task, prio);
 
-         /* in case such task is also blocked on mtx, go down into the
-          * blocking chain boost the prio of their blockers */
-         if ((TASKSTATE_WAIT != task->state) ||
-             (OS_TASKBLOCK_MTX != task->block_type))
-            break;
+      /* in case such task is also blocked on mtx, go down into the
+       * blocking chain boost the prio of their blockers */
+      if (TASKSTATE_WAIT != task->state)
+         break;
+      if (OS_TASKBLOCK_MTX == task->block_type) {
          /* because (OS_TASKBLOCK_MTX == task->block_type), task->task_queue
           * points into os_mtx_t->task_queue */
          task = os_container_of(
             task->task_queue, os_mtx_t, task_queue)->owner;
+         continue;
+      }
+      rwlock = os_rwlock_from_task(task);
+      if (!rwlock)
+         break;
+      /* rwlock may be owned by several readers, so in this case blocking
+       * chain forks, use recursion for all owners except the last one */
+      for (i = 0; i < (OS_CONFIG_RWLOCK_OWNERS - 1); i++) {
+         if (rwlock->owners[i].task)
+            os_task_prio_boost(rwlock->owners[i].task, prio);
       }
+      task = rwlock->owners[OS_CONFIG_RWLOCK_OWNERS - 1].task;
+      if (!task)
+         break;
    }
 }
 
 /**
- * Task priority inheritance function for mutex unlocking.
+ * Task priority inheritance function for mutex and rwlock unlocking.
  * This function reset the priority of task_current to proper level according to
  * priority inheritance rules. This prevents priority inversion to happen
  * even when indirect recursive lock dependency is still present
  */
-static void os_mtx_unlock_prio_reset(void)
+void os_task_prio_reset(void)
 {
    if (task_current->prio_current != task_current->prio_base) {
       /* calculation of new priority is quite complicated since we may have been
@@ -117,6 +143,7 @@ static void os_mtx_unlock_prio_reset(void)
       os_task_t *task;
       list_t *itr;
       os_mtx_t *itr_mtx;
+      os_rwlock_t *itr_rwlock;
       uint_fast8_t prio_new;
 
       /* new prio will be not less than prio_base of the task */
@@ -140,6 +167,20 @@ static void os_mtx_unlock_prio_reset(void)
          itr = itr->next; /* advance to next mtx on list */
       }
 
+      /* the same for rwlocks, both readers and writers which are suspended on
+       * rwlock are blocked by us */
+      itr = list_itr_begin(&(task_current->rwlock_list));
+      while (false == list_itr_end(&(task_current->rwlock_list), itr)) {
+         itr_rwlock = os_container_of(itr, os_rwlock_owner_t, listh)->rwlock;
+         task = os_taskqueue_peek(&(itr_rwlock->rd_queue));
+         if (task)
+            prio_new = os_max(prio_new, task->prio_current);
+         task = os_taskqueue_peek(&(itr_rwlock->wr_queue));
+         if (task)
+            prio_new = os_max(prio_new, task->prio_current);
+         itr = itr->next; /* advance to next rwlock on list */
+      }
+
       /* apply newly calculated prio
        * since task_current is RUNNING we can just modify prio_current */
       task_current->prio_current = prio_new;
@@ -179,7 +220,7 @@ void os_mtx_destroy(os_mtx_t *mtx)
 
 #ifdef OS_CONFIG_MUTEX_PRIO_INHERITANCE
       /* recalculate the prio of owner */
-      os_mtx_unlock_prio_reset();
+      os_task_prio_reset();
 #endif
 
       /* wake up all tasks from mtx->task_queue */
@@ -276,7 +317,7 @@ void os_mtx_unlock(os_mtx_t *mtx)
 #ifdef OS_CONFIG_MUTEX_PRIO_INHERITANCE
       /* before os_schedule we need to check if task_current does not have the
        * priority boosted and revert it to original priority if needed */
-      os_mtx_unlock_prio_reset();
+      os_task_prio_reset();
 #endif
 
       /* since we unlocking the mtx we need to transfer the ownership to top
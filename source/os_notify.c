@@ -0,0 +1,170 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_TASKNOTIFY
+
+/* private function forward declarations */
+static void os_notify_timerclbck(void *param);
+
+/* --- public functions --- */
+/* all public functions are documented in os_notify.h file */
+
+void os_task_notify(
+   os_task_t *task,
+   uint32_t value,
+   os_notify_action_t action)
+{
+   arch_criticalstate_t cristate;
+
+   /* tasks cannot call any OS functions if they are 'prepared' to suspend
+    * on wait_queue, with exception to ISR's */
+   OS_ASSERT((isr_nesting > 0) || (!waitqueue_current));
+   OS_ASSERT(task->state < TASKSTATE_DESTROYED);
+
+   arch_critical_enter(cristate);
+
+   switch (action) {
+   case OS_NOTIFY_SETBITS:
+      task->notify_value |= value;
+      break;
+   case OS_NOTIFY_INCREMENT:
+      task->notify_value += value;
+      break;
+   case OS_NOTIFY_OVERWRITE:
+      task->notify_value = value;
+      break;
+   default:
+      OS_ASSERT(0);
+   }
+   task->notify_pending = true;
+
+   /* only the owner of notification word may wait on it, so in case task is
+    * suspended we know that it waits on its own notification word. Such task is
+    * not placed on any task_queue, so we can move it straight into ready_queue */
+   if ((TASKSTATE_WAIT == task->state) &&
+       (OS_TASKBLOCK_NOTIFY == task->block_type)) {
+      /* we need to destroy the timer here, because otherwise it may fire
+       * right after we leave the critical section */
+      os_blocktimer_destroy(task);
+      task->block_code = OS_OK; /* set the block code to NORMAL WAKEUP */
+      os_task_makeready(task);
+
+      /* switch to more prioritized READY task, if there is such (1 as param
+       * in os_schedule() means just that */
+      os_schedule(1);
+   }
+
+   arch_critical_exit(cristate);
+}
+
+os_retcode_t OS_WARN_UNUSEDRET os_task_notify_wait(
+   uint32_t clear_mask,
+   os_ticks_t timeout_ticks,
+   uint32_t *value)
+{
+   os_retcode_t ret;
+   os_timer_t timer;
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   /* calling of blocking function while holding mtx or rwlock will cause
+    * priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   /* critical section needed because notification may come from ISR right
+    * after we check the notify_pending */
+   arch_critical_enter(cristate);
+   do {
+      if (!task_current->notify_pending) {
+         if (OS_TIMEOUT_TRY == timeout_ticks) {
+            ret = OS_WOULDBLOCK;
+            break;
+         }
+
+         /* does task request timeout guard for operation? */
+         if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+            /* we will get callback to os_notify_timerclbck() in case of
+             * timeout */
+            os_blocktimer_create(&timer, os_notify_timerclbck, timeout_ticks);
+         }
+
+         /* task blocks on its own TCB, so there is no task_queue */
+         os_task_block_switch(NULL, OS_TASKBLOCK_NOTIFY);
+
+         /* we return here either after os_task_notify() or timeout. Destroy
+          * the timeout guard if it was created */
+         os_blocktimer_destroy(task_current);
+
+         ret = task_current->block_code;
+         if (OS_OK != ret)
+            break;
+      }
+
+      /* consume the notification */
+      task_current->notify_pending = false;
+      if (value)
+         *value = task_current->notify_value;
+      task_current->notify_value &= ~clear_mask;
+      ret = OS_OK;
+
+   } while (0);
+   arch_critical_exit(cristate);
+
+   return ret;
+}
+
+/* --- private functions --- */
+
+/**
+ * Function called by timers module. Used for timeout of os_task_notify_wait()
+ * Callback to this function are done from context of timer_trigger().
+ */
+static void os_notify_timerclbck(void *param)
+{
+   /* single timer has param in os_blocktimer_create() as pointer to task
+    * structure */
+   os_task_t *task = (os_task_t*)param;
+
+   OS_SELFCHECK_ASSERT(TASKSTATE_WAIT == task->state);
+
+   /* task is not linked to any task_queue, just make it ready */
+   task->block_code = OS_TIMEOUT;
+   os_task_makeready(task);
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of timer_trigger() */
+}
+
+#endif
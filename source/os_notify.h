@@ -0,0 +1,112 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_NOTIFY_
+#define __OS_NOTIFY_
+
+#ifdef OS_CONFIG_TASKNOTIFY
+
+/**
+ * Task notification is the lightweight signaling mechanism for the case where
+ * there is only one receiver of the signal. Instead of separate kernel object
+ * (like os_sem_t) each task has the notification word inside its own TCB.
+ * Other tasks or ISRs modify the notification word by os_task_notify() while
+ * the owner of the word waits for the notification by os_task_notify_wait().
+ *
+ * Notification has following characteristics:
+ * - since only the owner may wait for its own notification word, notified task
+ *   is moved straight into ready_queue. There is no task_queue to scan and no
+ *   priority ordering of waiters, which makes os_task_notify() cheaper than
+ *   os_sem_up()
+ * - notification word can be used as binary semaphore (OS_NOTIFY_SETBITS with
+ *   clear_mask = all ones), counting semaphore (OS_NOTIFY_INCREMENT) as event
+ *   flags (OS_NOTIFY_SETBITS) or as single element mailbox
+ *   (OS_NOTIFY_OVERWRITE)
+ * - notification is accumulated. If task was notified before it called
+ *   os_task_notify_wait() it will not block.
+ */
+
+/** Action performed on notification word by os_task_notify() */
+typedef enum {
+   OS_NOTIFY_SETBITS = 0, /**< bitwise OR the value with notification word */
+   OS_NOTIFY_INCREMENT,   /**< add the value to notification word */
+   OS_NOTIFY_OVERWRITE    /**< overwrite the notification word with value */
+} os_notify_action_t;
+
+/**
+ * Function notifies the task by modifying its notification word. If task is
+ * suspended in os_task_notify_wait() it will be woken up.
+ *
+ * @param task task which should be notified
+ * @param value value used for modification of notification word, meaning
+ *        depends on @param action
+ * @param action action performed on notification word
+ *
+ * @pre this function CAN be called from ISR
+ * @pre task must be valid, initialized and not finished
+ *
+ * @post this function may cause preemption since it can wake up task with
+ *       higher priority than caller task
+ */
+void os_task_notify(
+   os_task_t *task,
+   uint32_t value,
+   os_notify_action_t action);
+
+/**
+ * Function suspends the calling task until it will be notified by
+ * os_task_notify(). Function does not block if task was already notified since
+ * last call.
+ *
+ * @param clear_mask bits which will be cleared in notification word after it
+ *        would be copied into @param value. Use 0 to keep the notification
+ *        word intact, UINT32_MAX to reset it to 0.
+ * @param timeout_ticks number of jiffies (os_tick() call count) before
+ *        operation will time out. OS_TIMEOUT_INFINITE and OS_TIMEOUT_TRY have
+ *        the same meaning as for os_sem_down().
+ * @param value pointer to variable where notification word will be stored,
+ *        can be NULL
+ *
+ * @pre this function cannot be used from ISR nor idle task
+ *
+ * @return OS_OK in case task was notified
+ *         OS_WOULDBLOCK in case task was not notified and @param timeout_ticks
+ *         was OS_TIMEOUT_TRY
+ *         OS_TIMEOUT in case operation timeout expired
+ */
+os_retcode_t OS_WARN_UNUSEDRET os_task_notify_wait(
+   uint32_t clear_mask,
+   os_ticks_t timeout_ticks,
+   uint32_t *value);
+
+#endif
+
+#endif
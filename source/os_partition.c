@@ -0,0 +1,155 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_PARTITION
+
+/** Partition which owns the current window, NULL in background window */
+os_partition_t *partition_active = NULL;
+
+/** System task, it belongs to partition_active whichever it is */
+os_task_t *partition_systask = NULL;
+
+/** Running schedule table, NULL if partitions are not scheduled */
+static const os_partition_window_t *partition_table = NULL;
+static size_t partition_cnt;
+static size_t partition_idx;
+
+/** Ticks remaining until the end of current window */
+static os_ticks_t partition_rem;
+
+/* private function forward declarations */
+static void partition_activate(os_partition_t *partition);
+
+/* --- public functions --- */
+/* all public functions are documented in os_partition.h file */
+
+void os_partition_create(os_partition_t *partition)
+{
+   os_taskqueue_init(&(partition->ready_queue));
+}
+
+void os_partition_assign(os_partition_t *partition, os_task_t *task)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(task->prio_base > 0); /* idle task has to stay in background */
+   OS_ASSERT(task != partition_systask); /* system task cannot be assigned */
+
+   arch_critical_enter(cristate);
+   task->partition = partition;
+   /* task_current preempted from ISR may still have READY state while it is
+    * not enqueued, check the queue instead (same as os_taskqueue_reprio()) */
+   if ((TASKSTATE_READY == task->state) && task->task_queue) {
+      os_taskqueue_unlink(task);
+      os_taskqueue_enqueue(os_task_readyqueue(task), task);
+   }
+   /* task_current may no longer own the window or READY task may be moved to
+    * active partition */
+   os_schedule(1);
+   arch_critical_exit(cristate);
+}
+
+void os_partition_schedule(const os_partition_window_t *table, size_t cnt)
+{
+   arch_criticalstate_t cristate;
+   size_t i;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT((NULL == table) || (cnt > 0));
+   for (i = 0; table && (i < cnt); i++)
+      OS_ASSERT(table[i].duration > 0);
+
+   arch_critical_enter(cristate);
+   partition_table = table;
+   partition_cnt = cnt;
+   partition_idx = 0;
+   if (table) {
+      partition_activate(table[0].partition);
+      partition_rem = table[0].duration;
+   } else {
+      partition_activate(NULL);
+   }
+   os_schedule(1);
+   arch_critical_exit(cristate);
+}
+
+os_partition_t *os_partition_active(void)
+{
+   return partition_active;
+}
+
+/* --- protected functions --- */
+
+void os_partition_tick(void)
+{
+   if (NULL == partition_table)
+      return;
+
+   if (--partition_rem > 0)
+      return;
+
+   /* switch to next window, os_tick() calls os_schedule() at its end which
+    * will preempt the task of previous window */
+   if (++partition_idx >= partition_cnt)
+      partition_idx = 0;
+   partition_activate(partition_table[partition_idx].partition);
+   partition_rem = partition_table[partition_idx].duration;
+}
+
+void OS_COLD os_partition_systask_set(os_task_t *task)
+{
+   OS_ASSERT(!partition_systask); /* only one system task is supported */
+   OS_ASSERT(!task->partition);
+
+   partition_systask = task;
+}
+
+/* --- private functions --- */
+
+/** Function switches the active partition. READY system task is moved to the
+ * ready queue of new partition, so it competes with its tasks by priority */
+static void partition_activate(os_partition_t *partition)
+{
+   if (partition_systask && (TASKSTATE_READY == partition_systask->state) &&
+       partition_systask->task_queue) {
+      os_taskqueue_unlink(partition_systask);
+      partition_active = partition;
+      os_taskqueue_enqueue(
+         os_task_readyqueue(partition_systask), partition_systask);
+   } else {
+      partition_active = partition;
+   }
+}
+
+#endif
+
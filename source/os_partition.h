@@ -0,0 +1,117 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_PARTITION_
+#define __OS_PARTITION_
+
+#ifdef OS_CONFIG_PARTITION
+
+/**
+ * Time partitions give the temporal isolation between groups of tasks (in the
+ * style of ARINC-653 major and minor frames). Each partition owns the subset of
+ * tasks and its own ready queue. Static schedule table divides the time into
+ * windows, os_tick() advances the table and each window selects the partition
+ * which the scheduler draws the tasks from. Characteristic of partitions:
+ * - tasks from partition run only inside of the windows of their partition,
+ *   regardless of their priority. Inside the window, tasks of partition are
+ *   scheduled by their priorities as usual
+ * - tasks which were not assigned to any partition (including the idle task)
+ *   belong to background partition. Background tasks run in background windows
+ *   (window with NULL partition) and in slack of other windows, when there is
+ *   no READY task in the active partition
+ * - timer daemon (OS_CONFIG_TIMERDAEMON) is the system task, it belongs to
+ *   whichever partition owns the current window and it competes with its tasks
+ *   by priority. Therefore timer callbacks are not delayed until background
+ *   window, while their CPU time is taken from the current window
+ * - partition switch only exchanges the pointer of active ready queue, so it
+ *   costs O(1) and does not depend on number of tasks nor partitions
+ * - task created by os_task_create() inherits the partition of its creator
+ * - tasks from different partitions should not share the mutexes, priority
+ *   inheritance cannot push the owner outside of its windows
+ */
+
+/** Definition of partition */
+typedef struct os_partition_tag {
+   os_taskqueue_t ready_queue; /**< READY tasks of the partition */
+} os_partition_t;
+
+/** Definition of single window of schedule table */
+typedef struct {
+   os_partition_t *partition; /**< partition which owns the window, NULL for
+                                   background window */
+   os_ticks_t duration;       /**< length of window in ticks, must be > 0 */
+} os_partition_window_t;
+
+/**
+ * Function initializes the partition
+ *
+ * @param partition pointer to partition, memory must be valid for whole time
+ *        when any task is assigned to it
+ */
+void os_partition_create(os_partition_t *partition);
+
+/**
+ * Function moves the task to partition
+ *
+ * @param partition pointer to partition, NULL moves the task to background
+ * @param task pointer to task, cannot be idle task nor timer daemon
+ *
+ * @note In case task_current is moved to partition which does not own the
+ *       current window, it will be preempted immediately
+ */
+void os_partition_assign(os_partition_t *partition, os_task_t *task);
+
+/**
+ * Function starts the schedule table. First window starts immediately, after
+ * the last window schedule continues from the first one (major frame). It is
+ * allowed to replace the table which is already running.
+ *
+ * @param table array of windows, memory must be valid until the table is
+ *        replaced. NULL stops the schedule, then all tasks are scheduled only
+ *        by priority while only background tasks are able to run.
+ * @param cnt number of windows in table
+ *
+ * @pre this function cannot be called from ISR
+ */
+void os_partition_schedule(const os_partition_window_t *table, size_t cnt);
+
+/**
+ * Function returns the partition which owns current window
+ *
+ * @return pointer to partition or NULL in background window (or if schedule
+ *         table is not running)
+ */
+os_partition_t *os_partition_active(void);
+
+#endif
+
+#endif
+
@@ -0,0 +1,278 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_POOL
+
+/* private function forward declarations */
+static void os_pool_timerclbck(void *param);
+
+/* --- private functions --- */
+
+/**
+ * Function returns the pointer to link field of block with given index + 1
+ */
+static inline volatile arch_atomic_t *os_pool_link(
+   os_pool_t *pool,
+   arch_atomic_t idx)
+{
+   return (volatile arch_atomic_t*)(pool->mem + (idx - 1) * pool->block_size);
+}
+
+/**
+ * Function creates new value of free list head. Index of first free block is
+ * stored in lower bits while the modification tag (incremented at each call) in
+ * upper bits
+ */
+static inline arch_atomic_t os_pool_head(
+   os_pool_t *pool,
+   arch_atomic_t old,
+   arch_atomic_t idx)
+{
+   /* calculations are done on unsigned type since arch_atomic_t may be signed
+    * and the tag is expected to wrap around */
+   unsigned long tag = (unsigned long)(old & ~pool->idx_mask);
+
+   tag = (tag + pool->idx_mask + 1) & ARCH_ATOMIC_MAX & ~pool->idx_mask;
+
+   return (arch_atomic_t)(tag | idx);
+}
+
+/* --- public functions --- */
+/* all public functions are documented in os_pool.h file */
+
+void os_pool_create(
+   os_pool_t *pool,
+   void *mem,
+   size_t block_size,
+   size_t block_cnt)
+{
+   size_t i;
+
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   OS_ASSERT(block_cnt > 0);
+   OS_ASSERT(block_cnt < ARCH_ATOMIC_MAX);
+   OS_ASSERT(0 == (block_size % sizeof(arch_atomic_t)));
+   OS_ASSERT(0 == ((uintptr_t)mem % sizeof(arch_atomic_t)));
+   OS_ASSERT(block_size > 0);
+
+   memset(pool, 0, sizeof(os_pool_t));
+   os_taskqueue_init(&(pool->task_queue));
+   pool->mem = (uint8_t*)mem;
+   pool->block_size = block_size;
+   pool->block_cnt = block_cnt;
+
+   /* smallest 2^n - 1 mask which can hold block_cnt (index 0 means empty
+    * list), rest of the bits are used for modification tag */
+   while ((size_t)pool->idx_mask < block_cnt)
+      pool->idx_mask = (pool->idx_mask << 1) | 1;
+
+   /* link all blocks into free list, in order of addresses */
+   for (i = 1; i < block_cnt; i++)
+      *os_pool_link(pool, i) = (arch_atomic_t)(i + 1);
+   *os_pool_link(pool, block_cnt) = 0;
+   pool->head = 1;
+}
+
+void os_pool_destroy(os_pool_t *pool)
+{
+   arch_criticalstate_t cristate;
+   os_task_t *task;
+
+   OS_ASSERT(0 == isr_nesting);     /* cannot call from ISR */
+   OS_ASSERT(!waitqueue_current);   /* cannot call after os_waitqueue_prepare() */
+
+   arch_critical_enter(cristate);
+
+   /* wake up all task which suspended on memory pool */
+   while ((task = os_taskqueue_dequeue(&(pool->task_queue)))) {
+      os_blocktimer_destroy(task); /* destroy the tasks timer */
+      task->block_code = OS_DESTROYED;
+      os_task_makeready(task);
+   }
+   memset(pool, 0, sizeof(os_pool_t));
+
+   /* schedule to make context switch in case os_pool_destroy() was called by
+    * lower priority task than tasks which we just woken up */
+   os_schedule(1);
+
+   arch_critical_exit(cristate);
+}
+
+void *os_pool_alloc(os_pool_t *pool)
+{
+   arch_atomic_t old;
+   arch_atomic_t next;
+   arch_atomic_t idx;
+
+   old = os_atomic_load(&(pool->head));
+   do {
+      idx = old & pool->idx_mask;
+      if (0 == idx)
+         return NULL;
+
+      /* block may be allocated and overwritten by other task or ISR right
+       * after we read the link. In such case the tag in head is changed and
+       * cmp_exch fails, so we will not use the garbage */
+      next = os_atomic_load(os_pool_link(pool, idx));
+   } while (os_atomic_cmp_exch(&(pool->head), &old,
+                               os_pool_head(pool, old, next)));
+
+   return (void*)os_pool_link(pool, idx);
+}
+
+void *os_pool_alloc_wait(
+   os_pool_t *pool,
+   os_ticks_t timeout_ticks)
+{
+   void *block;
+   os_timer_t timer;
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   /* calling of blocking function while holding mtx or rwlock will cause
+    * priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   /* fast path without critical section */
+   block = os_pool_alloc(pool);
+   if (block || (OS_TIMEOUT_TRY == timeout_ticks))
+      return block;
+
+   /* os_pool_free() checks for waiting tasks after it puts the block on free
+    * list. So by checking the free list again in critical section we are sure
+    * that block will not be lost */
+   arch_critical_enter(cristate);
+   do {
+      block = os_pool_alloc(pool);
+      if (block)
+         break;
+
+      /* does task request timeout guard for operation? */
+      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+         /* we will get callback to os_pool_timerclbck() in case of timeout */
+         os_blocktimer_create(&timer, os_pool_timerclbck, timeout_ticks);
+      }
+
+      os_task_block_switch(&(pool->task_queue), OS_TASKBLOCK_POOL);
+
+      /* we return here either after os_pool_free(), destroy or timeout.
+       * Destroy the timeout guard if it was created */
+      os_blocktimer_destroy(task_current);
+
+      /* in case of normal wakeup the block was handed over by os_pool_free() */
+      if (OS_OK == task_current->block_code)
+         block = task_current->pool_block;
+
+   } while (0);
+   arch_critical_exit(cristate);
+
+   return block;
+}
+
+void os_pool_free(
+   os_pool_t *pool,
+   void *block)
+{
+   arch_criticalstate_t cristate;
+   os_task_t *task;
+   arch_atomic_t old;
+   arch_atomic_t idx;
+   bool awoken = false;
+
+   /* tasks cannot call any OS functions if they are 'prepared' to suspend on
+    * wait_queue, with exception to ISR's */
+   OS_ASSERT((isr_nesting > 0) || (!waitqueue_current));
+   OS_ASSERT((uint8_t*)block >= pool->mem);
+   OS_ASSERT(0 == (((uint8_t*)block - pool->mem) % pool->block_size));
+
+   idx = (arch_atomic_t)(((uint8_t*)block - pool->mem) / pool->block_size) + 1;
+   OS_ASSERT((size_t)idx <= pool->block_cnt);
+
+   old = os_atomic_load(&(pool->head));
+   do {
+      os_atomic_store(os_pool_link(pool, idx), old & pool->idx_mask);
+   } while (os_atomic_cmp_exch(&(pool->head), &old,
+                               os_pool_head(pool, old, idx)));
+
+   /* tasks which wait for free block enqueue themselves in critical section
+    * after check of free list. We put the block on list before this check so
+    * either waiter got the block or we see the waiter here */
+   if (OS_LIKELY(0 == pool->task_queue.mask))
+      return;
+
+   arch_critical_enter(cristate);
+   /* hand over free blocks to waiting tasks, block could be taken in
+    * meantime by somebody else so we need to allocate it again */
+   while ((0 != pool->task_queue.mask) && (block = os_pool_alloc(pool))) {
+      task = os_taskqueue_dequeue(&(pool->task_queue));
+      /* we need to destroy the timer here, because otherwise it may fire
+       * right after we leave the critical section */
+      os_blocktimer_destroy(task);
+      task->pool_block = block;
+      task->block_code = OS_OK; /* set the block code to NORMAL WAKEUP */
+      os_task_makeready(task);
+      awoken = true;
+   }
+
+   if (awoken) {
+      /* switch to more prioritized READY task, if there is such (1 as param
+       * in os_schedule() means just that */
+      os_schedule(1);
+   }
+   arch_critical_exit(cristate);
+}
+
+/**
+ * Function called by timers module. Used for timeout of os_pool_alloc_wait()
+ * Callback to this function are done from context of timer_trigger().
+ */
+static void os_pool_timerclbck(void *param)
+{
+   /* single timer has param in os_blocktimer_create() as pointer to task
+    * structure */
+   os_task_t *task = (os_task_t*)param;
+
+   OS_SELFCHECK_ASSERT(TASKSTATE_WAIT == task->state);
+
+   /* remove task from memory pool task_queue */
+   os_taskqueue_unlink(task);
+   task->block_code = OS_TIMEOUT;
+   os_task_makeready(task);
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of timer_trigger() */
+}
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_POOL_
+#define __OS_POOL_
+
+#ifdef OS_CONFIG_POOL
+
+/**
+ * Memory pool allows for allocation of fixed size blocks from statically
+ * provided memory region. It has following characteristics:
+ * - memory region is carved into equal blocks at os_pool_create(), there is
+ *   no fragmentation and both allocation and free are constant time operations
+ * - free blocks are kept on lock-free list (LIFO) which is modified only by
+ *   os_atomic_cmp_exch(). Therefore os_pool_alloc() and os_pool_free() can be
+ *   called from ISR and they do not disable interrupts (with exception to
+ *   os_pool_free() when there are tasks waiting for free block)
+ * - head of free list keeps the index of first free block in lower bits and
+ *   the modification tag in upper bits of arch_atomic_t. The tag is
+ *   incremented on each modification, which protects against the ABA problem
+ *   in case task was preempted in middle of os_pool_alloc(). Number of tag
+ *   bits depends on arch_atomic_t size and the number of blocks, pools which
+ *   use all bits of arch_atomic_t for block index are not ABA protected
+ * - free block stores the index of next free block in its first bytes, so
+ *   block size must be at least sizeof(arch_atomic_t)
+ * - tasks can wait for free block by os_pool_alloc_wait(). Freed block is
+ *   handed over directly to the most prioritized waiting task
+ */
+
+/** Definition of memory pool structure */
+typedef struct {
+   /** queue of tasks suspended in os_pool_alloc_wait() */
+   os_taskqueue_t task_queue;
+
+   /** head of free list, modification tag and index of first free block + 1
+    * (0 means that list is empty) */
+   arch_atomic_t head;
+
+   /** mask for block index part of head */
+   arch_atomic_t idx_mask;
+
+   /** memory region carved into blocks */
+   uint8_t *mem;
+
+   /** size of single block */
+   size_t block_size;
+
+   /** number of blocks in pool */
+   size_t block_cnt;
+
+} os_pool_t;
+
+/**
+ * Function creates the memory pool.
+ *
+ * @param pool pointer to memory pool
+ * @param mem pointer to memory region, must be aligned at least to
+ *        sizeof(arch_atomic_t) and be at least @param block_size *
+ *        @param block_cnt bytes long
+ * @param block_size size of single block, must be multiple of
+ *        sizeof(arch_atomic_t). Use multiple of largest alignment required by
+ *        data stored in blocks
+ * @param block_cnt number of blocks, must be > 0 and < ARCH_ATOMIC_MAX
+ *
+ * @post all blocks are free after this call
+ */
+void os_pool_create(
+   os_pool_t *pool,
+   void *mem,
+   size_t block_size,
+   size_t block_cnt);
+
+/**
+ * Function destroys the memory pool
+ *
+ * @param pool pointer to memory pool
+ *
+ * @pre memory pool must be initialized prior call of this function
+ * @pre this function cannot be called from ISR
+ *
+ * @post tasks suspended in os_pool_alloc_wait() will be released and get NULL
+ *       as allocated block. The same race conditions as described for
+ *       os_sem_destroy() apply here. Blocks which were not freed are not
+ *       tracked, memory region can be reused after this call.
+ * @post this function may cause preemption since this function wakes up tasks
+ *       suspended on memory pool
+ */
+void os_pool_destroy(os_pool_t *pool);
+
+/**
+ * Function allocates single block from memory pool
+ *
+ * @param pool pointer to memory pool
+ *
+ * @pre this function CAN be called from ISR
+ *
+ * @return pointer to allocated block, NULL in case there was no free block
+ */
+void *os_pool_alloc(os_pool_t *pool);
+
+/**
+ * Function allocates single block from memory pool. In case there is no free
+ * block function will suspend calling task until other task or ISR will free
+ * the block or when requested timeout will burn off.
+ *
+ * @param pool pointer to memory pool
+ * @param timeout_ticks number of jiffies (os_tick() call count) before
+ *        operation will time out. OS_TIMEOUT_INFINITE and OS_TIMEOUT_TRY have
+ *        the same meaning as for os_sem_down().
+ *
+ * @pre this function cannot be used from ISR nor idle task
+ *
+ * @return pointer to allocated block, NULL in case of timeout, when
+ *         @param timeout_ticks was OS_TIMEOUT_TRY and there was no free block,
+ *         or when memory pool was destroyed while task was suspended
+ */
+void *os_pool_alloc_wait(
+   os_pool_t *pool,
+   os_ticks_t timeout_ticks);
+
+/**
+ * Function returns the block to memory pool
+ *
+ * @param pool pointer to memory pool
+ * @param block pointer to block previously allocated from the same pool
+ *
+ * @pre this function CAN be called from ISR
+ *
+ * @post this function may cause preemption since it can wake up task with
+ *       higher priority than caller task
+ */
+void os_pool_free(
+   os_pool_t *pool,
+   void *block);
+
+#endif
+
+#endif
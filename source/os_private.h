@@ -140,6 +140,11 @@ extern os_taskqueue_t ready_queue;
 extern volatile arch_atomic_t sched_lock;
 #ifdef OS_CONFIG_WAITQUEUE
 extern os_waitqueue_t *waitqueue_current;
+extern os_waitqueue_t *waitqueue_prepared;
+#endif
+#ifdef OS_CONFIG_PARTITION
+extern os_partition_t *partition_active;
+extern os_task_t *partition_systask;
 #endif
 
 void OS_HOT os_taskqueue_enqueue(
@@ -193,10 +198,54 @@ void arch_idle(void);
 
 /* --- OS private inline functions --- */
 
+#ifdef OS_CONFIG_EDF
+/** Function returns true in case task_a is more urgent than task_b in EDF
+ * band. Regular tasks which use the band priority are more urgent than EDF
+ * tasks, so they keep the FIFO order among each other */
+static inline bool os_task_edf_before(
+   const os_task_t *task_a,
+   const os_task_t *task_b)
+{
+   if (0 == task_a->edf_reldeadline)
+      return (0 != task_b->edf_reldeadline);
+   if (0 == task_b->edf_reldeadline)
+      return false;
+   /* deadlines are within half of os_ticks_t range, so the overflow of
+    * difference tells which is earlier */
+   return (os_ticks_t)(task_a->edf_deadline - task_b->edf_deadline) >
+          (OS_TICKS_MAX / 2);
+}
+#endif
+
+#ifdef OS_CONFIG_PARTITION
+/** Function returns the partition which owns the task. System task belongs to
+ * whichever partition owns the current window */
+static inline os_partition_t *os_task_partition(os_task_t *task)
+{
+   return OS_UNLIKELY(task == partition_systask) ?
+      partition_active : task->partition;
+}
+#endif
+
+/** Function returns the ready queue of partition which owns the task */
+static inline os_taskqueue_t *os_task_readyqueue(os_task_t *task)
+{
+#ifdef OS_CONFIG_PARTITION
+   os_partition_t *partition = os_task_partition(task);
+
+   if (partition)
+      return &(partition->ready_queue);
+#else
+   (void)task;
+#endif
+   return &ready_queue;
+}
+
 static inline void os_task_makeready(os_task_t *task)
 {
-   task->state = TASKSTATE_READY;            /* set the task state */
-   os_taskqueue_enqueue(&ready_queue, task); /* put task into ready_queue */
+   task->state = TASKSTATE_READY; /* set the task state */
+   /* put task into ready_queue */
+   os_taskqueue_enqueue(os_task_readyqueue(task), task);
 }
 
 static inline void os_task_makewait(
@@ -207,20 +256,72 @@ static inline void os_task_makewait(
     * set during all wakeups */
    task_current->state = TASKSTATE_WAIT;
    task_current->block_type = block_type;
-   os_taskqueue_enqueue(task_queue, task_current);
+   /* task_queue may be NULL in case task blocks on its own TCB (task
+    * notification), in that case waker knows the task and there is no need to
+    * keep it on any task_queue */
+   if (task_queue)
+      os_taskqueue_enqueue(task_queue, task_current);
+   else
+      task_current->task_queue = NULL;
+}
+
+extern os_ticks_t ticks_cnt;
+
+/** Function converts absolute deadline into the number of ticks remaining from
+ * now. Must be called from critical section, so the deadline is converted
+ * against the same tick on which the block timer is armed. Deadlines which are
+ * more than half of os_ticks_t range ahead are considered as already passed.
+ *
+ * @return number of ticks until deadline or 0 if deadline was already reached
+ */
+static inline os_ticks_t os_ticks_until(os_ticks_t deadline)
+{
+   os_ticks_t ticks = (os_ticks_t)(deadline - ticks_cnt);
+
+   return (ticks > (OS_TICKS_MAX / 2)) ? 0 : ticks;
 }
 
+/** Function creates the timer which callback is always called from os_tick(),
+ * even if OS_CONFIG_TIMERDAEMON is enabled. Used for block timers */
+void os_timer_create_direct(
+   os_timer_t *timer,
+   timer_proc_t clbck,
+   void *param,
+   os_ticks_t timeout_ticks,
+   os_ticks_t slack_ticks);
+
 static inline void os_blocktimer_create(
    os_timer_t *timer,
    timer_proc_t clbck,
-   uint_fast16_t timeout_ticks)
+   os_ticks_t timeout_ticks)
 {
    OS_SELFCHECK_ASSERT(!task_current->timer);
 
-   os_timer_create(timer, clbck, task_current, timeout_ticks, 0);
+   /* callbacks of block timers are always called from os_tick() */
+#ifdef OS_CONFIG_TIMERSLACK
+   os_timer_create_direct(
+      timer, clbck, task_current, timeout_ticks, task_current->timer_slack);
+#else
+   os_timer_create_direct(timer, clbck, task_current, timeout_ticks, 0);
+#endif
    task_current->timer = timer;
 }
 
+#ifdef OS_CONFIG_HRTIMER
+/** Same as os_blocktimer_create() but timeout is given in nanoseconds.
+ * Callback is called from hrtimer ISR instead of os_tick() */
+static inline void os_hrblocktimer_create(
+   os_hrtimer_t *timer,
+   timer_proc_t clbck,
+   uint64_t timeout_ns)
+{
+   OS_SELFCHECK_ASSERT(!task_current->hrtimer);
+
+   os_hrtimer_start(timer, clbck, task_current, timeout_ns, 0);
+   task_current->hrtimer = timer;
+}
+#endif
+
 static inline void os_blocktimer_destroy(os_task_t *task)
 {
    /* check if there is a timeout associated with task */
@@ -228,12 +329,95 @@ static inline void os_blocktimer_destroy(os_task_t *task)
       os_timer_destroy(task->timer);
       task->timer = NULL;
    }
+#ifdef OS_CONFIG_HRTIMER
+   if (task->hrtimer) {
+      os_hrtimer_cancel(task->hrtimer);
+      task->hrtimer = NULL;
+   }
+#endif
+}
+
+/* --- Mutex and rwlock protected functions --- */
+
+#ifdef OS_CONFIG_MUTEX_PRIO_INHERITANCE
+void os_task_prio_boost(
+   os_task_t *task,
+   uint_fast8_t prio);
+void os_task_prio_reset(void);
+#endif
+
+/**
+ * Function returns the rwlock on which task is suspended or NULL in case task
+ * is not suspended on rwlock
+ */
+static inline os_rwlock_t *os_rwlock_from_task(os_task_t *task)
+{
+   if (OS_TASKBLOCK_RWLOCK_RD == task->block_type)
+      return os_container_of(task->task_queue, os_rwlock_t, rd_queue);
+   if (OS_TASKBLOCK_RWLOCK_WR == task->block_type)
+      return os_container_of(task->task_queue, os_rwlock_t, wr_queue);
+   return NULL;
 }
 
 /* --- Timers protected types and functions --- */
 
 /* protected function from timer module */
 void os_timers_init(void);
+#ifdef OS_CONFIG_TIMERDAEMON
+void os_timers_daemon_init(void);
+#endif
+
+#ifdef OS_CONFIG_BUDGET
+/** Called from os_tick() to charge task_current for the tick */
+void os_task_budget_charge(void);
+#endif
+
+#ifdef OS_CONFIG_PARTITION
+/** Called from os_tick() to advance the schedule table */
+void os_partition_tick(void);
+
+/** Makes the task the system task, which is never starved by windows of
+ * partitions. Can be called only from os_init() */
+void os_partition_systask_set(os_task_t *task);
+#endif
+
+#ifdef OS_CONFIG_CYCLIC
+/** Called from os_tick() to release the jobs from cyclic table */
+void os_cyclic_tick(void);
+#endif
+
+#ifdef OS_CONFIG_HRTIMER
+void os_hrtimer_init(void);
+/** Called by arch from the ISR of one-shot timer */
+void os_hrtimer_isr(void);
+#endif
+
+/* --- Wait any protected functions --- */
+
+#ifdef OS_CONFIG_WAITANY
+bool os_waitany_wakeup(
+   listprio_t *list,
+   os_task_t *task,
+   os_retcode_t block_code);
+#endif
+
+/* --- Futex protected functions --- */
+
+#ifdef OS_CONFIG_FUTEX
+void os_futex_init(void);
+#endif
+
+/* --- Softirq protected functions --- */
+
+#ifdef OS_CONFIG_SOFTIRQ
+void os_softirq_init(void);
+#endif
+
+/* --- Deferred ISR post protected functions --- */
+
+#ifdef OS_CONFIG_ISRPOST
+void os_isrpost_init(void);
+#endif
 
 #endif
 
@@ -51,15 +51,86 @@
 //enum { OS_CONCAT(static_assert_, __LINE__) = 1 / (!!(_e)) }
 //char OS_CONCAT(static_assert_, __LINE__)[0 - 1*!(_e)];
 
-/** Definition of system tick, it is defined by arch but never can be smaller
- * than uint16_t */
+/** Definition of system tick. By default it is defined by arch (native width
+ * which can be accessed atomically) but it can be changed by
+ * OS_CONFIG_TICKS_WIDTH. Narrower counter than arch native width is still
+ * accessed atomically, this is used to emulate 16 bit platforms on Linux. It
+ * never can be smaller than uint16_t */
+#ifdef OS_CONFIG_TICKS_WIDTH
+#define OS_TICKS_WIDTH OS_CONFIG_TICKS_WIDTH
+#else
+#define OS_TICKS_WIDTH ARCH_TICKS_WIDTH
+#endif
+#if OS_TICKS_WIDTH == ARCH_TICKS_WIDTH
 typedef arch_ticks_t os_ticks_t;
-OS_STATIC_ASSERT(sizeof(os_ticks_t) >= sizeof(uint16_t));
-OS_STATIC_ASSERT(ARCH_TICKS_MAX >= (UINT16_MAX - 1));
 #define OS_TICKS_MAX ARCH_TICKS_MAX
+#elif OS_TICKS_WIDTH == 16
+typedef uint16_t os_ticks_t;
+#define OS_TICKS_MAX ((os_ticks_t)UINT16_MAX)
+#elif OS_TICKS_WIDTH == 32
+typedef uint32_t os_ticks_t;
+#define OS_TICKS_MAX ((os_ticks_t)UINT32_MAX)
+#elif OS_TICKS_WIDTH == 64
+typedef uint64_t os_ticks_t;
+#define OS_TICKS_MAX ((os_ticks_t)UINT64_MAX)
+#else
+#error "OS_CONFIG_TICKS_WIDTH must be 16, 32 or 64"
+#endif
+OS_STATIC_ASSERT(sizeof(os_ticks_t) >= sizeof(uint16_t));
+/* tick counter wraps around at type boundary, this makes the differences of
+ * ticks calculated by unsigned arithmetic wrap-safe */
+OS_STATIC_ASSERT(sizeof(os_ticks_t) * 8 == OS_TICKS_WIDTH);
 
 /* check if requested number of priorities is suppoeted by arch platform */
 OS_STATIC_ASSERT(OS_CONFIG_PRIOCNT <= ARCH_BITFIELD_MAX);
 
+/* rwlock needs at least one ownership slot, used for exclusive access */
+OS_STATIC_ASSERT(OS_CONFIG_RWLOCK_OWNERS >= 1);
+
+#ifdef OS_CONFIG_FUTEX
+/* futex hash is calculated by masking */
+OS_STATIC_ASSERT(0 == (OS_CONFIG_FUTEX_HASHSIZE &
+                       (OS_CONFIG_FUTEX_HASHSIZE - 1)));
+#endif
+
+#if defined(OS_CONFIG_BUF) && !defined(OS_CONFIG_POOL)
+#error "OS_CONFIG_BUF requires OS_CONFIG_POOL"
+#endif
+
+#if defined(OS_CONFIG_MBOX) && !defined(OS_CONFIG_POOL)
+#error "OS_CONFIG_MBOX requires OS_CONFIG_POOL"
+#endif
+
+#ifdef OS_CONFIG_HEAP
+/* second level lists are tracked by single arch_bitmask_t */
+OS_STATIC_ASSERT((1 << OS_CONFIG_HEAP_SLCNT_LOG2) <= ARCH_BITFIELD_MAX);
+#endif
+
+#ifdef OS_CONFIG_EDF
+/* EDF band cannot take the idle task priority */
+OS_STATIC_ASSERT((OS_CONFIG_EDF_PRIO > 0) &&
+                 (OS_CONFIG_EDF_PRIO < OS_CONFIG_PRIOCNT));
+#endif
+
+#ifdef OS_CONFIG_TIMERDAEMON
+/* timer daemon is a regular task */
+OS_STATIC_ASSERT((OS_CONFIG_TIMERDAEMON_PRIO > 0) &&
+                 (OS_CONFIG_TIMERDAEMON_PRIO < OS_CONFIG_PRIOCNT));
+#endif
+
+#ifdef OS_CONFIG_SOFTIRQ
+/* pending softirqs are tracked by single arch_bitmask_t */
+OS_STATIC_ASSERT(OS_CONFIG_SOFTIRQCNT <= ARCH_BITFIELD_MAX);
+#endif
+
+#ifdef OS_CONFIG_ISRPOST
+#ifndef OS_CONFIG_SOFTIRQ
+#error "OS_CONFIG_ISRPOST requires OS_CONFIG_SOFTIRQ"
+#endif
+/* deferred post queue is indexed by masking */
+OS_STATIC_ASSERT(0 == (OS_CONFIG_ISRPOST_SIZE & (OS_CONFIG_ISRPOST_SIZE - 1)));
+OS_STATIC_ASSERT(OS_CONFIG_ISRPOST_SOFTIRQ < OS_CONFIG_SOFTIRQCNT);
+#endif
+
 #endif
 
@@ -0,0 +1,400 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+/* private function forward declarations */
+static void os_rwlock_timerclbck(void *param);
+
+/* --- private functions --- */
+
+/**
+ * Function returns ownership slot of given task or NULL in case task does not
+ * own the rwlock
+ */
+static os_rwlock_owner_t *os_rwlock_find_owner(
+   os_rwlock_t *rwlock,
+   os_task_t *task)
+{
+   uint_fast8_t i;
+
+   for (i = 0; i < OS_CONFIG_RWLOCK_OWNERS; i++) {
+      if (rwlock->owners[i].task == task)
+         return &(rwlock->owners[i]);
+   }
+
+   return NULL;
+}
+
+/**
+ * Assign rwlock ownership to given task
+ * This is equivalent to locking the rwlock. Caller must check beforehand if
+ * there is a free slot.
+ */
+static void os_rwlock_set_owner(
+   os_rwlock_t *rwlock,
+   os_task_t *task,
+   bool writer)
+{
+   os_rwlock_owner_t *slot;
+
+   slot = os_rwlock_find_owner(rwlock, NULL);
+   OS_SELFCHECK_ASSERT(slot);
+
+   slot->task = task;
+   /* add this slot to task owned list,
+    * required for prio recalculation during unlock */
+   list_append(&(task->rwlock_list), &(slot->listh));
+
+   if (writer)
+      rwlock->writer = true;
+   else
+      ++(rwlock->readers);
+}
+
+/**
+ * Clear ownership of rwlock.
+ * This is equivalent to unlocking the rwlock.
+ */
+static void os_rwlock_clear_owner(
+   os_rwlock_t *rwlock,
+   os_task_t *task)
+{
+   os_rwlock_owner_t *slot;
+
+   slot = os_rwlock_find_owner(rwlock, task);
+   OS_ASSERT(slot); /* only owner can unlock the rwlock */
+
+   slot->task = NULL;
+   list_unlink(&(slot->listh));
+
+   if (rwlock->writer)
+      rwlock->writer = false;
+   else
+      --(rwlock->readers);
+}
+
+/**
+ * Function checks if reader with given priority may obtain the shared access.
+ * Reader cannot pass over the writer which is already waiting, unless it has
+ * strictly higher priority (this protects from writer starvation)
+ */
+static bool os_rwlock_rd_allowed(
+   os_rwlock_t *rwlock,
+   uint_fast8_t prio)
+{
+   os_task_t *writer;
+
+   if (rwlock->writer || (rwlock->readers >= OS_CONFIG_RWLOCK_OWNERS))
+      return false;
+
+   writer = os_taskqueue_peek(&(rwlock->wr_queue));
+   return !writer || (prio > writer->prio_current);
+}
+
+/**
+ * Function checks if writer may obtain the exclusive access
+ */
+static bool os_rwlock_wr_allowed(os_rwlock_t *rwlock)
+{
+   return !(rwlock->writer) && (0 == rwlock->readers);
+}
+
+#ifdef OS_CONFIG_MUTEX_PRIO_INHERITANCE
+/**
+ * Task priority inheritance function for rwlock.
+ * Function boost all owners of rwlock (and their blockers) to given priority.
+ */
+static void os_rwlock_prio_boost(
+   os_rwlock_t *rwlock,
+   uint_fast8_t prio)
+{
+   uint_fast8_t i;
+
+   for (i = 0; i < OS_CONFIG_RWLOCK_OWNERS; i++) {
+      if (rwlock->owners[i].task)
+         os_task_prio_boost(rwlock->owners[i].task, prio);
+   }
+}
+#endif
+
+/**
+ * Function passes the ownership of rwlock to suspended tasks in case this is
+ * possible. Function is called each time the rwlock was released or when
+ * suspended writer gave up due timeout.
+ *
+ * @return true in case some task was woken up
+ *
+ * \note we do not destroy the timers of woken up tasks here, since this
+ *       function may be called from timer callback (destroying other timers
+ *       while timer_trigger() is iterating over timer list is not allowed).
+ *       Instead woken up tasks destroy their timers by themselves and
+ *       os_rwlock_timerclbck() ignores the tasks which are not suspended.
+ */
+static bool os_rwlock_grant(os_rwlock_t *rwlock)
+{
+   os_task_t *task;
+   os_task_t *reader;
+   bool awoken = false;
+
+   /* writer is preferred over readers with the same priority */
+   if (os_rwlock_wr_allowed(rwlock)) {
+      task = os_taskqueue_peek(&(rwlock->wr_queue));
+      reader = os_taskqueue_peek(&(rwlock->rd_queue));
+      if (task && (!reader || (task->prio_current >= reader->prio_current))) {
+         task = os_taskqueue_dequeue(&(rwlock->wr_queue));
+         os_rwlock_set_owner(rwlock, task, true);
+         task->block_code = OS_OK; /* set the block code to NORMAL WAKEUP */
+         os_task_makeready(task);
+         awoken = true;
+      }
+   }
+
+   /* wake up as many readers as we can, in priority order */
+   while ((reader = os_taskqueue_peek(&(rwlock->rd_queue))) &&
+          os_rwlock_rd_allowed(rwlock, reader->prio_current)) {
+      task = os_taskqueue_dequeue(&(rwlock->rd_queue));
+      os_rwlock_set_owner(rwlock, task, false);
+      task->block_code = OS_OK; /* set the block code to NORMAL WAKEUP */
+      os_task_makeready(task);
+      awoken = true;
+   }
+
+#ifdef OS_CONFIG_MUTEX_PRIO_INHERITANCE
+   /* tasks which still wait are now blocked by new set of owners */
+   if (awoken) {
+      if ((task = os_taskqueue_peek(&(rwlock->rd_queue))))
+         os_rwlock_prio_boost(rwlock, task->prio_current);
+      if ((task = os_taskqueue_peek(&(rwlock->wr_queue))))
+         os_rwlock_prio_boost(rwlock, task->prio_current);
+   }
+#endif
+
+   return awoken;
+}
+
+/**
+ * Common implementation of shared and exclusive lock
+ */
+static os_retcode_t os_rwlock_lock(
+   os_rwlock_t *rwlock,
+   os_ticks_t timeout_ticks,
+   bool writer)
+{
+   os_retcode_t ret;
+   os_timer_t timer;
+   arch_criticalstate_t cristate;
+   bool allowed;
+
+   OS_ASSERT(0 == isr_nesting);           /* cannot operate on rwlock from ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+
+   arch_critical_enter(cristate);
+   do {
+      /* recursive locking of rwlock is not supported */
+      OS_ASSERT(!os_rwlock_find_owner(rwlock, task_current));
+
+      allowed = writer ?
+                os_rwlock_wr_allowed(rwlock) :
+                os_rwlock_rd_allowed(rwlock, task_current->prio_current);
+      if (allowed) {
+         /* rwlock available, take ownership */
+         os_rwlock_set_owner(rwlock, task_current, writer);
+         ret = OS_OK;
+         break;
+      }
+
+      if (OS_TIMEOUT_TRY == timeout_ticks) {
+         /* task request to bail out in case operation would block */
+         ret = OS_WOULDBLOCK;
+         break;
+      }
+
+      /* does task request timeout guard for operation? */
+      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+         /* we will get callback to os_rwlock_timerclbck() in case of timeout */
+         os_blocktimer_create(&timer, os_rwlock_timerclbck, timeout_ticks);
+      }
+
+#ifdef OS_CONFIG_MUTEX_PRIO_INHERITANCE
+      /* rwlock is owned by other tasks, boost the prio of all owners if they
+       * have lower prio than current task, same as for mutex */
+      os_rwlock_prio_boost(rwlock, task_current->prio_current);
+#endif
+
+      /* block the current task and switch context to READY task */
+      if (writer) {
+         os_task_block_switch(&(rwlock->wr_queue), OS_TASKBLOCK_RWLOCK_WR);
+      } else {
+         os_task_block_switch(&(rwlock->rd_queue), OS_TASKBLOCK_RWLOCK_RD);
+      }
+
+      /* we return here once ownership was passed to us in os_rwlock_grant(),
+       * on timeout or when rwlock was destroyed. Destroy the timeout guard if
+       * it was created */
+      os_blocktimer_destroy(task_current);
+
+      ret = task_current->block_code;
+
+   } while (0);
+   arch_critical_exit(cristate);
+
+   return ret;
+}
+
+/* --- public functions --- */
+/* all public functions are documented in os_rwlock.h file */
+
+void os_rwlock_create(os_rwlock_t *rwlock)
+{
+   uint_fast8_t i;
+
+   OS_ASSERT(0 == isr_nesting);     /* cannot operate on rwlock from ISR */
+   OS_ASSERT(!waitqueue_current);   /* forbidden after os_waitqueue_prepare() */
+
+   memset(rwlock, 0, sizeof(os_rwlock_t));
+   for (i = 0; i < OS_CONFIG_RWLOCK_OWNERS; i++) {
+      list_init(&(rwlock->owners[i].listh));
+      rwlock->owners[i].rwlock = rwlock;
+   }
+   os_taskqueue_init(&(rwlock->rd_queue));
+   os_taskqueue_init(&(rwlock->wr_queue));
+}
+
+void os_rwlock_destroy(os_rwlock_t *rwlock)
+{
+   arch_criticalstate_t cristate;
+   os_task_t *task;
+
+   OS_ASSERT(0 == isr_nesting);     /* cannot operate on rwlock from ISR */
+   OS_ASSERT(!waitqueue_current);   /* forbidden after os_waitqueue_prepare() */
+
+   arch_critical_enter(cristate);
+
+   /* only the writer can destroy the owned rwlock */
+   OS_ASSERT(0 == rwlock->readers);
+   if (rwlock->writer) {
+      os_rwlock_clear_owner(rwlock, task_current);
+#ifdef OS_CONFIG_MUTEX_PRIO_INHERITANCE
+      /* recalculate the prio of owner */
+      os_task_prio_reset();
+#endif
+   }
+
+   /* wake up all tasks suspended on rwlock, timers will be destroyed by woken
+    * up tasks */
+   while ((task = os_taskqueue_dequeue(&(rwlock->wr_queue))) ||
+          (task = os_taskqueue_dequeue(&(rwlock->rd_queue)))) {
+      task->block_code = OS_DESTROYED;
+      os_task_makeready(task);
+   }
+
+   memset(rwlock, 0, sizeof(os_rwlock_t));   /* finally deface rwlock data */
+   os_schedule(1);                           /* schedule to make possible
+                                              * context switch after we woke up
+                                              * tasks */
+
+   arch_critical_exit(cristate);
+}
+
+os_retcode_t OS_WARN_UNUSEDRET os_rwlock_rdlock(
+   os_rwlock_t *rwlock,
+   os_ticks_t timeout_ticks)
+{
+   return os_rwlock_lock(rwlock, timeout_ticks, false);
+}
+
+os_retcode_t OS_WARN_UNUSEDRET os_rwlock_wrlock(
+   os_rwlock_t *rwlock,
+   os_ticks_t timeout_ticks)
+{
+   return os_rwlock_lock(rwlock, timeout_ticks, true);
+}
+
+void os_rwlock_unlock(os_rwlock_t *rwlock)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting);     /* cannot operate on rwlock from ISR */
+   OS_ASSERT(!waitqueue_current);   /* forbidden after os_waitqueue_prepare() */
+
+   arch_critical_enter(cristate);
+
+   os_rwlock_clear_owner(rwlock, task_current);
+
+#ifdef OS_CONFIG_MUTEX_PRIO_INHERITANCE
+   /* we may not be the last owner, but still we no longer block the waiting
+    * tasks, so revert the prio of task_current to proper level */
+   os_task_prio_reset();
+#endif
+
+   /* pass the ownership to suspended tasks if possible */
+   (void)os_rwlock_grant(rwlock);
+
+   /* we call schedule even if nobody was woken up, since our priority might
+    * have been decreased. Switch only to task with higher prio (forced 1 as
+    * parameter) */
+   os_schedule(1);
+
+   arch_critical_exit(cristate);
+}
+
+/**
+ * Function called by timers module. Used for timeout of rwlock lock operations.
+ * Callback to this function are done from context of timer_trigger().
+ */
+static void os_rwlock_timerclbck(void *param)
+{
+   /* single timer has param in os_blocktimer_create() as pointer to task
+    * structure */
+   os_task_t *task = (os_task_t*)param;
+   os_rwlock_t *rwlock;
+
+   /* task may be already woken up by os_rwlock_grant(), but not yet scheduled
+    * to destroy its timer. Ignore such timeout (see os_rwlock_grant()) */
+   if (TASKSTATE_WAIT != task->state)
+      return;
+
+   rwlock = os_rwlock_from_task(task);
+   OS_SELFCHECK_ASSERT(rwlock);
+
+   /* remove task from rwlock task queue */
+   os_taskqueue_unlink(task);
+   task->block_code = OS_TIMEOUT;
+   os_task_makeready(task);
+
+   /* if it was a writer, readers suspended behind it may progress now */
+   (void)os_rwlock_grant(rwlock);
+
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of timer_trigger() */
+}
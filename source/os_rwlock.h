@@ -0,0 +1,188 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_RWLOCK_
+#define __OS_RWLOCK_
+
+/**
+ * Reader-writer lock is synchronization primitive which protects the data that
+ * is often read but rarely modified. Comparing to mutex it has following
+ * differences:
+ * - rwlock can be owned by several readers at the same time (shared access) or
+ *   by single writer (exclusive access). Readers do not serialize each other
+ *   as it would happen with mutex.
+ * - the set of reader owners is bounded by OS_CONFIG_RWLOCK_OWNERS. This is
+ *   because rwlock tracks all of its owners for priority inheritance. If all
+ *   slots are occupied, next reader will suspend until some of owners will
+ *   release the rwlock.
+ * - rwlock cannot be used from ISR
+ * - rwlock prevents from writer starvation. If writer is waiting for the lock,
+ *   new readers will suspend (even if rwlock is currently owned by readers)
+ *   unless they have strictly higher priority than waiting writer. When rwlock
+ *   is released, waiting writer is preferred over readers with the same
+ *   priority.
+ * - rwlock prevents from priority inversion in the same way as mutex does (see
+ *   os_mtx.h). Task which suspends on rwlock will boost the priority of all
+ *   current owners (and recursively the owners of resources on which they
+ *   are blocked). Priority of owner is recalculated when it releases the
+ *   rwlock.
+ * - rwlock does not support recursive locking. Owner which will try to lock
+ *   the rwlock again (in any mode) will assert in case of OS_CONFIG_APICHECK
+ *   (or deadlock itself otherwise).
+ * - in opposite to mutex, lock operations have the timeout guard. Keep in mind
+ *   that in case of timeout the priority of owners is not decreased until they
+ *   release the rwlock (owners may be boosted for a bit longer than needed).
+ */
+
+/** Definition of rwlock ownership slot */
+typedef struct {
+   /** list link which allows to place this slot on owner task rwlock_list */
+   list_t listh;
+
+   /** Task which owns this slot, NULL in case slot is free */
+   os_task_t *task;
+
+   /** Pointer to rwlock which contains this slot */
+   struct os_rwlock_tag *rwlock;
+
+} os_rwlock_owner_t;
+
+/** Definition of rwlock structure */
+typedef struct os_rwlock_tag {
+   /** Ownership slots, for exclusive access only first slot is used */
+   os_rwlock_owner_t owners[OS_CONFIG_RWLOCK_OWNERS];
+
+   /** Queue of readers suspended on this rwlock */
+   os_taskqueue_t rd_queue;
+
+   /** Queue of writers suspended on this rwlock */
+   os_taskqueue_t wr_queue;
+
+   /** Number of readers which currently own the rwlock */
+   uint_fast8_t readers;
+
+   /** Flag which marks that rwlock is owned by writer */
+   bool writer;
+
+} os_rwlock_t;
+
+/**
+ * Function creates the rwlock.
+ *
+ * Rwlock structure can be allocated by from any memory. Function initializes
+ * rwlock structure given by @param rwlock (does not use dynamic memory of any
+ * kind).
+ *
+ * @param rwlock pointer to rwlock
+ */
+void os_rwlock_create(os_rwlock_t *rwlock);
+
+/**
+ * Function destroys the rwlock
+ *
+ * Function overwrite rwlock structure memory. As same as with
+ * os_rwlock_create() it does not refer to any dynamic memory.
+ *
+ * @param rwlock pointer to rwlock
+ *
+ * @pre rwlock must be initialized prior call of this function
+ * @pre rwlock cannot be owned by any task except the caller which may own it
+ *      with exclusive access. As same as for mutex, well written code should
+ *      lock the rwlock for exclusive access before destroying it
+ * @pre this function cannot be used from ISR
+ *
+ * @post rwlock will be uninitialized after this call. Tasks which was suspended
+ *       on rwlock prior call of os_rwlock_destroy() will be released with
+ *       OS_DESTROYED return code.
+ * @post this function may cause preemption since this function wakes up tasks
+ *       suspended on rwlock (possibly with higher priority than calling
+ *       task)
+ */
+void os_rwlock_destroy(os_rwlock_t *rwlock);
+
+/**
+ * Function locks the rwlock for shared (read) access. If the rwlock is owned by
+ * writer, some writer with equal or higher priority is waiting, or all
+ * ownership slots are occupied, the calling task will suspend until it can
+ * obtain the shared access or until timeout will burn off.
+ *
+ * @param rwlock pointer to rwlock
+ * @param timeout_ticks number of jiffies (os_tick() call count) before
+ *        operation will time out. OS_TIMEOUT_INFINITE and OS_TIMEOUT_TRY have
+ *        the same meaning as for os_sem_down().
+ *
+ * @pre rwlock must be initialized prior call of this function
+ * @pre this function cannot be used from ISR nor idle task
+ * @pre calling task cannot already own the rwlock
+ *
+ * @return OS_OK in case rwlock was successfully locked by calling task
+ *         OS_WOULDBLOCK in case rwlock could not be locked and @param
+ *         timeout_ticks was OS_TIMEOUT_TRY
+ *         OS_TIMEOUT in case operation timeout expired
+ *         OS_DESTROYED in case rwlock was destroyed while calling task was
+ *         suspended on the lock operation
+ * @note user code should always check the return code
+ */
+os_retcode_t OS_WARN_UNUSEDRET os_rwlock_rdlock(
+   os_rwlock_t *rwlock,
+   os_ticks_t timeout_ticks);
+
+/**
+ * Function locks the rwlock for exclusive (write) access. If the rwlock is
+ * owned by anybody the calling task will suspend until all owners will release
+ * the rwlock or until timeout will burn off.
+ *
+ * @param rwlock pointer to rwlock
+ * @param timeout_ticks same as for os_rwlock_rdlock()
+ *
+ * @pre same as for os_rwlock_rdlock()
+ *
+ * @return same as for os_rwlock_rdlock()
+ * @note user code should always check the return code
+ */
+os_retcode_t OS_WARN_UNUSEDRET os_rwlock_wrlock(
+   os_rwlock_t *rwlock,
+   os_ticks_t timeout_ticks);
+
+/**
+ * Function releases the rwlock, regardless if it was locked for shared or
+ * exclusive access.
+ *
+ * @param rwlock pointer to rwlock
+ *
+ * @pre rwlock must be owned by task that calls this function
+ * @pre this function cannot be used from ISR
+ * @post this function may cause preemption since it can wake up task with
+ *       higher priority than caller task
+ */
+void os_rwlock_unlock(os_rwlock_t *rwlock);
+
+#endif
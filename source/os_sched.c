@@ -68,6 +68,24 @@ volatile arch_atomic_t sched_lock = 0;
 
 /* --- forward declaration of private functions --- */
 
+static void os_task_create_internal(
+   os_task_t *task,
+   uint_fast8_t prio,
+   void *stack,
+   size_t stack_size,
+   os_taskproc_t proc,
+   void *param,
+   os_ticks_t rel_deadline);
+static void os_task_sleep_internal(
+   os_ticks_t timeout_ticks,
+   bool until);
+static void os_task_sleep_timerclbck(void *param);
+static os_task_t *os_taskqueue_dequeue_ready(void);
+#ifdef OS_CONFIG_BUDGET
+static void os_task_budget_restore(os_task_t *task);
+static void os_task_budget_replenish(void *param);
+#endif
+
 #ifdef OS_CONFIG_CHECKSTACK
 static void os_task_check_init(
    os_task_t *task,
@@ -125,6 +143,18 @@ void os_init(void)
    /* initialize OS subsystem and variables */
    os_taskqueue_init(&ready_queue);
    os_timers_init();
+#ifdef OS_CONFIG_HRTIMER
+   os_hrtimer_init();
+#endif
+#ifdef OS_CONFIG_FUTEX
+   os_futex_init();
+#endif
+#ifdef OS_CONFIG_SOFTIRQ
+   os_softirq_init();
+#endif
+#ifdef OS_CONFIG_ISRPOST
+   os_isrpost_init();
+#endif
 
    /* create and switch to idle task */
    os_task_init(&task_idle, 0);
@@ -135,6 +165,11 @@ void os_init(void)
     * application. After return, user code should initialize system interrupts
     * (tick and others). Therefore we keep interrupts dissabled. */
    sched_lock = 1;
+
+#ifdef OS_CONFIG_TIMERDAEMON
+   /* scheduler is locked so daemon will not run until os_start() */
+   os_timers_daemon_init();
+#endif
 }
 
 void OS_NORETURN os_start(os_idleproc_t app_idle)
@@ -171,29 +206,40 @@ void os_task_create(
    os_taskproc_t proc,
    void *param)
 {
-   arch_criticalstate_t cristate;
+   os_task_create_internal(task, prio, stack, stack_size, proc, param, 0);
+}
 
-   OS_ASSERT(0 == isr_nesting); /* cannot create task from ISR */
-   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
-   OS_ASSERT(prio < OS_CONFIG_PRIOCNT); /* prio must be less than prio config limit */
-   OS_ASSERT(prio > 0); /* only idle task may have the prio 0 */
-   OS_ASSERT(stack); /* stack must be given */
-   OS_ASSERT(stack_size >= OS_STACK_MINSIZE); /* minimal size for stack */
+#ifdef OS_CONFIG_EDF
+void os_task_create_edf(
+   os_task_t *task,
+   void *stack,
+   size_t stack_size,
+   os_taskproc_t proc,
+   void *param,
+   os_ticks_t rel_deadline)
+{
+   /* deadlines are compared in the half of os_ticks_t range */
+   OS_ASSERT((rel_deadline > 0) && (rel_deadline <= (OS_TICKS_MAX / 2)));
 
-   os_task_init(task, prio);
+   os_task_create_internal(
+      task, OS_CONFIG_EDF_PRIO, stack, stack_size, proc, param, rel_deadline);
+}
 
-#ifdef OS_CONFIG_CHECKSTACK
-   os_task_check_init(task, stack, stack_size);
-#endif
-   arch_task_init(task, stack, stack_size, proc, param);
+void os_task_edf_deadline_set(os_ticks_t deadline)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current->edf_reldeadline > 0); /* only for EDF tasks */
 
    arch_critical_enter(cristate);
-   os_taskqueue_enqueue(&ready_queue, task);
-   /* 1 as a param allows context switch only if created task has higher
-    * priority than task_current */
+   /* task_current is not enqueued, so we can change the key freely */
+   task_current->edf_deadline = deadline;
+   /* postponed deadline may allow other EDF task to run */
    os_schedule(1);
    arch_critical_exit(cristate);
 }
+#endif
 
 int os_task_join(os_task_t *task)
 {
@@ -243,6 +289,226 @@ void os_yield(void)
    arch_critical_exit(cristate);
 }
 
+void os_task_sleep_until(os_ticks_t deadline)
+{
+   os_task_sleep_internal(deadline, true);
+}
+
+void os_task_sleep(os_ticks_t timeout_ticks)
+{
+   OS_ASSERT(timeout_ticks > 0);
+   OS_ASSERT(timeout_ticks < OS_TIMEOUT_INFINITE);
+
+   os_task_sleep_internal(timeout_ticks, false);
+}
+
+#ifdef OS_CONFIG_TIMERSLACK
+void os_task_timerslack_set(os_ticks_t slack_ticks)
+{
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+
+   /* only task itself use this field, no need for critical section */
+   task_current->timer_slack = slack_ticks;
+}
+#endif
+
+#ifdef OS_CONFIG_PREEMPTTHRESHOLD
+void os_task_threshold_set(os_task_t *task, uint_fast8_t threshold)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(threshold < OS_CONFIG_PRIOCNT);
+   OS_ASSERT((0 == threshold) || (threshold >= task->prio_base));
+
+   arch_critical_enter(cristate);
+   if (task->prio_preempted) {
+      /* task was preempted and it waits in ready queue with its old threshold,
+       * give back its priority */
+      if (task->prio_current == task->prio_threshold)
+         os_taskqueue_reprio(task, task->prio_preempted);
+      task->prio_preempted = 0;
+   }
+   task->prio_threshold = threshold;
+   /* lowered threshold of task_current may allow READY task to preempt */
+   os_schedule(1);
+   arch_critical_exit(cristate);
+}
+#endif
+
+#ifdef OS_CONFIG_BUDGET
+void os_task_budget_set(
+   os_task_t *task,
+   os_ticks_t budget,
+   os_ticks_t period,
+   uint_fast8_t bg_prio)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT((0 == budget) || (budget < period));
+
+   arch_critical_enter(cristate);
+   /* stop the current reservation, task gets back its priority and it is
+    * woken up in case it was suspended */
+   if (task->budget_armed) {
+      os_timer_destroy(&(task->budget_timer));
+      task->budget_armed = false;
+   }
+   os_task_budget_restore(task);
+
+   OS_ASSERT(bg_prio < task->prio_base);
+   task->budget = budget;
+   task->budget_rem = budget;
+   task->budget_period = period;
+   task->budget_prio = bg_prio;
+
+   os_schedule(1);
+   arch_critical_exit(cristate);
+}
+
+void os_task_budget_charge(void)
+{
+   os_task_t *task = task_current;
+
+   if (OS_LIKELY(0 == task->budget))
+      return; /* task without reservation (including idle task) */
+
+   if (task->budget_rem > 0) {
+      if (!task->budget_armed) {
+         /* first tick consumed from full budget, start the replenishment
+          * period */
+         os_timer_create_direct(
+            &(task->budget_timer), os_task_budget_replenish, task,
+            task->budget_period, 0);
+         task->budget_armed = true;
+      }
+      if (--(task->budget_rem) > 0)
+         return;
+
+      if (task->budget_prio > 0) {
+         /* demote the task, it is running so it is not enqueued. Boost from
+          * priority inheritance is kept, it will be reset to new base
+          * priority while releasing the lock */
+         task->budget_prio_orig = task->prio_base;
+         task->prio_base = task->budget_prio;
+         if (task->prio_current == task->budget_prio_orig)
+            task->prio_current = task->budget_prio;
+         /* os_tick() will switch to more prioritized task */
+         return;
+      }
+   } else if (task->budget_prio > 0) {
+      return; /* demoted task runs in background */
+   }
+
+   /* suspend the task until replenishment. We can switch only from most outer
+    * ISR and while scheduler is not locked, otherwise we will try at next
+    * tick. Owner of mutex or rwlock is not suspended either, since its waiters
+    * (boosted by priority inheritance or not) would be blocked until
+    * replenishment, we try again at first tick after it releases the lock */
+   if ((isr_nesting <= 1) && (0 == sched_lock) &&
+       list_is_empty(&(task->mtx_list)) &&
+       list_is_empty(&(task->rwlock_list))) {
+      task->state = TASKSTATE_WAIT;
+      task->block_type = OS_TASKBLOCK_BUDGET;
+      task->task_queue = NULL;
+      /* at least idle task is READY, context switch will be done at the end
+       * of ISR (see arch_contextrestore_i) */
+      task_current = os_taskqueue_dequeue_ready();
+      task_current->state = TASKSTATE_RUNNING;
+   }
+}
+#endif
+
+#ifdef OS_CONFIG_HRTIMER
+void os_task_sleep_ns(uint64_t timeout_ns)
+{
+   os_hrtimer_t timer;
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot sleep in ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   OS_ASSERT(timeout_ns > 0);
+   /* sleeping while holding mtx or rwlock will cause priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   arch_critical_enter(cristate);
+   os_hrblocktimer_create(&timer, os_task_sleep_timerclbck, timeout_ns);
+   os_task_block_switch(NULL, OS_TASKBLOCK_SLEEP);
+   os_blocktimer_destroy(task_current);
+   arch_critical_exit(cristate);
+}
+#endif
+
+#ifdef OS_CONFIG_TASKPERIODIC
+void os_task_periodic_init(os_ticks_t period)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot be periodic */
+   /* releases are compared in the half of os_ticks_t range */
+   OS_ASSERT((period > 0) && (period <= (OS_TICKS_MAX / 2)));
+
+   arch_critical_enter(cristate);
+   task_current->period = period;
+   task_current->period_release = ticks_cnt;
+   task_current->period_overruns = 0;
+#ifdef OS_CONFIG_EDF
+   if (task_current->edf_reldeadline > 0) {
+      /* first job is released now */
+      task_current->edf_deadline = ticks_cnt + task_current->edf_reldeadline;
+   }
+#endif
+   arch_critical_exit(cristate);
+}
+
+uint_fast16_t os_task_wait_next_period(void)
+{
+   arch_criticalstate_t cristate;
+   os_ticks_t late;
+   uint_fast16_t missed = 0;
+
+   OS_ASSERT(task_current->period > 0); /* os_task_periodic_init() missing */
+
+   arch_critical_enter(cristate);
+   task_current->period_release += task_current->period;
+   if (0 == os_ticks_until(task_current->period_release)) {
+      late = os_ticks_diff(task_current->period_release, ticks_cnt);
+      if (late > 0) {
+         /* the next release already passed, skip all missed releases to keep
+          * the phase of the task. Release which falls exactly at current tick
+          * is still valid, same as in case late == 0 */
+         missed = (uint_fast16_t)(
+            (late + task_current->period - 1) / task_current->period);
+         task_current->period_release +=
+            (os_ticks_t)missed * task_current->period;
+         task_current->period_overruns += missed;
+      }
+   }
+#ifdef OS_CONFIG_EDF
+   if (task_current->edf_reldeadline > 0) {
+      /* deadline of next job is relative to its release */
+      task_current->edf_deadline =
+         task_current->period_release + task_current->edf_reldeadline;
+   }
+#endif
+   /* critical sections are nested, so the release tick is converted and
+    * armed without any tick in between */
+   os_task_sleep_internal(task_current->period_release, true);
+#ifdef OS_CONFIG_EDF
+   /* in case task did not sleep, its deadline was postponed and other EDF task
+    * may be more urgent now */
+   os_schedule(1);
+#endif
+   arch_critical_exit(cristate);
+
+   return missed;
+}
+#endif
+
 #ifdef OS_CONFIG_CHECKSTACK
 void os_task_check(os_task_t *task)
 {
@@ -273,8 +539,33 @@ void OS_HOT os_taskqueue_enqueue(
    os_taskqueue_t *task_queue,
    os_task_t *task)
 {
-   /* enqueue the task to task_queue bucket */
-   list_append(&(task_queue->tasks[task->prio_current]), &(task->list));
+#ifdef OS_CONFIG_EDF
+   list_t *itr;
+   list_t *task_list;
+
+   if (OS_UNLIKELY(OS_CONFIG_EDF_PRIO == task->prio_current)) {
+      /* EDF band is kept sorted by deadline, FIFO for equal deadlines */
+      task_list = &(task_queue->tasks[OS_CONFIG_EDF_PRIO]);
+      itr = list_itr_begin(task_list);
+      while (!list_itr_end(task_list, itr)) {
+         if (os_task_edf_before(task, os_container_of(itr, os_task_t, list)))
+            break;
+         itr = itr->next;
+      }
+      list_put_before(itr, &(task->list));
+   } else
+#endif
+#ifdef OS_CONFIG_PREEMPTTHRESHOLD
+   if (OS_UNLIKELY(task->prio_preempted)) {
+      /* preempted task resumes before the tasks which are already READY with
+       * priority equal to its threshold, since they could not preempt it */
+      list_prepend(&(task_queue->tasks[task->prio_current]), &(task->list));
+   } else
+#endif
+   {
+      /* enqueue the task to task_queue bucket */
+      list_append(&(task_queue->tasks[task->prio_current]), &(task->list));
+   }
    task->task_queue = task_queue;
 
    /* update the mask for task_queue buckets */
@@ -344,6 +635,15 @@ static os_task_t *os_taskqueue_intdequeue(
    }
 
    task->task_queue = NULL;
+#ifdef OS_CONFIG_PREEMPTTHRESHOLD
+   if (OS_UNLIKELY(task->prio_preempted)) {
+      /* task leaves the ready queue, give back its priority unless it was
+       * boosted above threshold by priority inheritance in the meantime */
+      if (task->prio_current == task->prio_threshold)
+         task->prio_current = task->prio_preempted;
+      task->prio_preempted = 0;
+   }
+#endif
    return task;
 }
 
@@ -386,6 +686,54 @@ os_task_t*OS_HOT os_taskqueue_dequeue_prio(
    return os_taskqueue_intdequeue(task_queue, maxprio);
 }
 
+#ifdef OS_CONFIG_EDF
+/**
+ * Similar to os_taskqueue_dequeue_prio() for ready queue while task_current
+ * runs in EDF band. Task from the band is dequeued only if it has earlier
+ * deadline than task_current (or the same deadline if higher_prio is 0)
+ */
+static os_task_t *os_taskqueue_dequeue_edf(
+   os_taskqueue_t *task_queue,
+   uint_fast8_t higher_prio)
+{
+   uint_fast8_t maxprio;
+   os_task_t *task;
+
+   maxprio = arch_bitmask_fls(task_queue->mask);
+   if (0 == maxprio)
+      return NULL;
+   --maxprio; /* convert to index counted from 0 */
+
+   if (maxprio < OS_CONFIG_EDF_PRIO)
+      return NULL;
+
+   if (OS_CONFIG_EDF_PRIO == maxprio) {
+      task = os_container_of(
+         list_peekfirst(&(task_queue->tasks[maxprio])), os_task_t, list);
+      if (higher_prio ?
+          !os_task_edf_before(task, task_current) :
+          os_task_edf_before(task_current, task))
+         return NULL;
+   }
+
+   return os_taskqueue_intdequeue(task_queue, maxprio);
+}
+#endif
+
+/**
+ * Function dequeues the most urgent READY task regardless of task_current.
+ * Tasks of active partition take precedence over background tasks. Never
+ * returns NULL since at least idle task is READY
+ */
+static os_task_t *os_taskqueue_dequeue_ready(void)
+{
+#ifdef OS_CONFIG_PARTITION
+   if (partition_active && (0 != partition_active->ready_queue.mask))
+      return os_taskqueue_dequeue(&(partition_active->ready_queue));
+#endif
+   return os_taskqueue_dequeue(&ready_queue);
+}
+
 /**
  *  Function returns the pointer to top prio task on the task_queue
  *  This function does not dequeue the task from task_queue, it just returns
@@ -453,6 +801,7 @@ void os_taskqueue_init(os_taskqueue_t *task_queue)
 void OS_HOT os_schedule(uint_fast8_t higher_prio)
 {
    os_task_t *new_task;
+   os_taskqueue_t *task_queue;
 
    /* this function can be called only from OS critical section */
    OS_SELFCHECK_ASSERT(arch_is_dint());
@@ -461,13 +810,58 @@ void OS_HOT os_schedule(uint_fast8_t higher_prio)
     * Do not switch tasks in case of nested ISR or in case we explicitly locked
     * the scheduler for whatever reason */
    if (OS_LIKELY((isr_nesting <= 1) && (0 == sched_lock))) {
-      /* dequeue another READY task which has priority equal or greater than
-       * task_current (see condition inside os_taskqueue_dequeue_prio) */
-      new_task = os_taskqueue_dequeue_prio(
-         &ready_queue, task_current->prio_current + higher_prio);
+      /* priorities are compared only inside of the same ready queue */
+      task_queue = os_task_readyqueue(task_current);
+#ifdef OS_CONFIG_PARTITION
+      if (OS_UNLIKELY(os_task_partition(task_current) != partition_active)) {
+         if (task_current->partition) {
+            /* window of task_current partition is over, it has to give up
+             * the CPU regardless of priorities */
+            task_queue = NULL;
+            new_task = os_taskqueue_dequeue_ready();
+         } else if (0 != partition_active->ready_queue.mask) {
+            /* any task of active partition preempts the background task */
+            task_queue = NULL;
+            new_task = os_taskqueue_dequeue(&(partition_active->ready_queue));
+         }
+      }
+#endif
+      if (OS_LIKELY(task_queue)) {
+#ifdef OS_CONFIG_PREEMPTTHRESHOLD
+         if (OS_UNLIKELY(task_current->prio_threshold >
+                         task_current->prio_current)) {
+            /* only tasks above threshold can preempt, regardless of
+             * higher_prio, so there is no time slicing as well */
+            new_task = os_taskqueue_dequeue_prio(
+               task_queue, task_current->prio_threshold + 1);
+         } else
+#endif
+#ifdef OS_CONFIG_EDF
+         if (OS_UNLIKELY(OS_CONFIG_EDF_PRIO == task_current->prio_current)) {
+            /* inside of EDF band the deadline decides */
+            new_task = os_taskqueue_dequeue_edf(task_queue, higher_prio);
+         } else
+#endif
+         {
+            /* dequeue another READY task which has priority equal or
+             * greater than task_current (see condition inside
+             * os_taskqueue_dequeue_prio) */
+            new_task = os_taskqueue_dequeue_prio(
+               task_queue, task_current->prio_current + higher_prio);
+         }
+      }
 
       /* we will get NULL in case all READY tasks have lower priority */
       if (new_task) {
+#ifdef OS_CONFIG_PREEMPTTHRESHOLD
+         if (OS_UNLIKELY(task_current->prio_threshold >
+                         task_current->prio_current)) {
+            /* preempted task is enqueued with its threshold, so it resumes
+             * before tasks which cannot preempt it */
+            task_current->prio_preempted = task_current->prio_current;
+            task_current->prio_current = task_current->prio_threshold;
+         }
+#endif
          /* since we have new task, task_current need to be pushed to
           * ready-queue */
          os_task_makeready(task_current);
@@ -507,7 +901,7 @@ void OS_HOT os_task_block_switch(
 
    /* chose any READY task and switch to it - at least idle task is READY
     * so we will never get the NULL from os_taskqueue_dequeue() */
-   arch_context_switch(os_taskqueue_dequeue(&ready_queue));
+   arch_context_switch(os_taskqueue_dequeue_ready());
 
    /* we will return to this point after future context switch.
     * After return task state should be again set to TASKSTATE_RUNING, also
@@ -533,6 +927,12 @@ void OS_NORETURN OS_COLD os_task_exit(int retv)
     * that. */
    arch_critical_enter(cristate);
 
+#ifdef OS_CONFIG_BUDGET
+   /* replenishment timer cannot outlive the task */
+   if (task_current->budget_armed)
+      os_timer_destroy(&(task_current->budget_timer));
+#endif
+
    task_current->ret_value = retv; /* store the return value for future join() */
    task_current->state = TASKSTATE_DESTROYED;
 
@@ -551,7 +951,7 @@ void OS_NORETURN OS_COLD os_task_exit(int retv)
     * state (ready_queue) (os_taskqueue_dequeue(&ready_queue) never returns
     * NULL.  We're not pushing current_task anywhere, so it will disappear from
     * scheduling. Afer that OS no longer manage this task structure */
-   arch_context_switch(os_taskqueue_dequeue(&ready_queue));
+   arch_context_switch(os_taskqueue_dequeue_ready());
 
    /* we should never reach this point, there is no chance that scheduler picked
     * up this code again since we dropped the task */
@@ -564,6 +964,141 @@ void OS_NORETURN OS_COLD os_task_exit(int retv)
 
 /* --- private function implementation --- */
 
+#ifdef OS_CONFIG_BUDGET
+/**
+ * Function gives back the priority to demoted task or wakes up the task
+ * suspended due exhausted budget
+ */
+static void os_task_budget_restore(os_task_t *task)
+{
+   if ((task->budget > 0) && (0 == task->budget_rem)) {
+      if (task->budget_prio > 0) {
+         task->prio_base = task->budget_prio_orig;
+         /* task may be READY or suspended on any task_queue */
+         if (task->prio_current < task->prio_base)
+            os_taskqueue_reprio(task, task->prio_base);
+      } else if ((TASKSTATE_WAIT == task->state) &&
+                 (OS_TASKBLOCK_BUDGET == task->block_type)) {
+         os_task_makeready(task);
+      }
+   }
+   task->budget_rem = task->budget;
+}
+
+/**
+ * Function called by timers module at the end of replenishment period.
+ * Callback to this function are done from contxt of timer_trigger().
+ */
+static void os_task_budget_replenish(void *param)
+{
+   os_task_t *task = (os_task_t*)param;
+
+   os_timer_destroy(&(task->budget_timer));
+   task->budget_armed = false;
+   os_task_budget_restore(task);
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of timer_trigger() */
+}
+#endif
+
+/**
+ * Common implementation of os_task_create() and os_task_create_edf().
+ * rel_deadline is 0 for regular tasks
+ */
+static void os_task_create_internal(
+   os_task_t *task,
+   uint_fast8_t prio,
+   void *stack,
+   size_t stack_size,
+   os_taskproc_t proc,
+   void *param,
+   os_ticks_t rel_deadline)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot create task from ISR */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   OS_ASSERT(prio < OS_CONFIG_PRIOCNT); /* prio must be less than prio config limit */
+   OS_ASSERT(prio > 0); /* only idle task may have the prio 0 */
+   OS_ASSERT(stack); /* stack must be given */
+   OS_ASSERT(stack_size >= OS_STACK_MINSIZE); /* minimal size for stack */
+
+   os_task_init(task, prio);
+#ifdef OS_CONFIG_EDF
+   task->edf_reldeadline = rel_deadline;
+   task->edf_deadline = ticks_cnt + rel_deadline;
+#else
+   (void)rel_deadline;
+#endif
+#ifdef OS_CONFIG_PARTITION
+   /* task inherits the partition of its creator */
+   task->partition = task_current->partition;
+#endif
+
+#ifdef OS_CONFIG_CHECKSTACK
+   os_task_check_init(task, stack, stack_size);
+#endif
+   arch_task_init(task, stack, stack_size, proc, param);
+
+   arch_critical_enter(cristate);
+   os_taskqueue_enqueue(os_task_readyqueue(task), task);
+   /* 1 as a param allows context switch only if created task has higher
+    * priority (or earlier deadline in EDF band) than task_current */
+   os_schedule(1);
+   arch_critical_exit(cristate);
+}
+
+/**
+ * Common implementation of os_task_sleep() and os_task_sleep_until(). If until
+ * is true, the timeout_ticks is an absolute deadline.
+ */
+static void os_task_sleep_internal(
+   os_ticks_t timeout_ticks,
+   bool until)
+{
+   os_timer_t timer;
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot sleep in ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   /* sleeping while holding mtx or rwlock will cause priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   arch_critical_enter(cristate);
+   if (until) {
+      /* deadline is converted in the same critical section in which we arm
+       * the timer, so the task is released exactly at deadline tick */
+      timeout_ticks = os_ticks_until(timeout_ticks);
+   }
+   if (timeout_ticks > 0) {
+      os_blocktimer_create(&timer, os_task_sleep_timerclbck, timeout_ticks);
+      /* nobody except the timer can wake us up, so no task_queue */
+      os_task_block_switch(NULL, OS_TASKBLOCK_SLEEP);
+      os_blocktimer_destroy(task_current);
+   }
+   arch_critical_exit(cristate);
+}
+
+/**
+ * Function called by timers module. Used for wakeup from os_task_sleep(),
+ * os_task_sleep_until() and os_task_sleep_ns().
+ * Callback to this function are done from contxt of timer_trigger().
+ */
+static void os_task_sleep_timerclbck(void *param)
+{
+   os_task_t *task = (os_task_t*)param;
+
+   OS_SELFCHECK_ASSERT(TASKSTATE_WAIT == task->state);
+   OS_SELFCHECK_ASSERT(OS_TASKBLOCK_SLEEP == task->block_type);
+
+   task->block_code = OS_TIMEOUT;
+   os_task_makeready(task);
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of timer_trigger() */
+}
+
 #ifdef OS_CONFIG_CHECKSTACK
 /**
  * Initialize task checking mechanism
@@ -597,5 +1132,6 @@ static void os_task_init(
    task->state = TASKSTATE_READY;
    task->block_type = OS_TASKBLOCK_INVALID;
    list_init(&(task->mtx_list));
+   list_init(&(task->rwlock_list));
 }
 
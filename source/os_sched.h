@@ -57,7 +57,22 @@ typedef enum {
    OS_TASKBLOCK_INVALID = 0,  /**< Invalid placeholder */
    OS_TASKBLOCK_SEM,          /**< Task blocked on semaphore */
    OS_TASKBLOCK_MTX,          /**< Task blocked on mutex */
-   OS_TASKBLOCK_WAITQUEUE     /**< Task blocked on wait_queue */
+   OS_TASKBLOCK_WAITQUEUE,    /**< Task blocked on wait_queue */
+   OS_TASKBLOCK_RWLOCK_RD,    /**< Task blocked on rwlock for shared access */
+   OS_TASKBLOCK_RWLOCK_WR,    /**< Task blocked on rwlock for exclusive
+                                   access */
+   OS_TASKBLOCK_FUTEX,        /**< Task blocked on futex word */
+   OS_TASKBLOCK_WAITANY,      /**< Task blocked on multiple objects in
+                                   os_wait_any() */
+   OS_TASKBLOCK_NOTIFY,       /**< Task blocked on its own notification word */
+   OS_TASKBLOCK_EVFLAGS,      /**< Task blocked on event flags group */
+   OS_TASKBLOCK_POOL,         /**< Task blocked on memory pool */
+   OS_TASKBLOCK_MBOX,         /**< Task blocked on empty mailbox */
+   OS_TASKBLOCK_STREAM,       /**< Task blocked on stream buffer */
+   OS_TASKBLOCK_TIMERDAEMON,  /**< Timer daemon waits for expired timers */
+   OS_TASKBLOCK_SLEEP,        /**< Task sleeps until deadline */
+   OS_TASKBLOCK_BUDGET,       /**< Task exhausted its execution budget */
+   OS_TASKBLOCK_CYCLIC        /**< Task waits for release by cyclic table */
 } os_taskblock_t;
 
 /** Return codes for OS API functions */
@@ -73,6 +88,7 @@ typedef enum {
 struct os_taskqueue_tag;
 struct os_sem_tag;
 struct os_waitqueue_tag;
+struct os_partition_tag;
 
 /** Definition of Task Structure - Task Control Block - TCB */
 typedef struct {
@@ -92,6 +108,17 @@ typedef struct {
     * changed by priority inheritance code */
    uint_fast8_t prio_current;
 
+#ifdef OS_CONFIG_PREEMPTTHRESHOLD
+   /** preemption threshold, while task is running only tasks with priority
+    * above threshold can preempt it. 0 in case threshold is not used */
+   uint_fast8_t prio_threshold;
+
+   /** prio_current saved while task is READY after preemption, in that time
+    * task is enqueued with prio_threshold so it resumes before tasks with
+    * priority lower or equal to threshold. 0 if task was not preempted */
+   uint_fast8_t prio_preempted;
+#endif
+
    /** state of task - common meaning as in other RTOS'es */
    os_taskstate_t state;
 
@@ -110,8 +137,106 @@ typedef struct {
       /** associated timer while waiting on resource with timeout guard, valid
        * only if task state = TASKSTATE_WAIT */
       os_timer_t *timer;
+
+#ifdef OS_CONFIG_HRTIMER
+      /** associated hrtimer while waiting with nanosecond timeout, valid only
+       * if task state = TASKSTATE_WAIT */
+      os_hrtimer_t *hrtimer;
+#endif
+
+#ifdef OS_CONFIG_FUTEX
+      /** address of futex word on which task is suspended, valid only if task
+       * state = TASKSTATE_WAIT and block_type = OS_TASKBLOCK_FUTEX. Used to
+       * distinguish tasks which share the same futex hash bucket */
+      const volatile arch_atomic_t *futex_addr;
+#endif
+
+#ifdef OS_CONFIG_EVFLAGS
+      /** flags for which task waits, valid only if task state = TASKSTATE_WAIT
+       * and block_type = OS_TASKBLOCK_EVFLAGS. At wakeup os_evflags_set()
+       * overwrites it with the state of flags which satisfied the wait */
+      uint32_t evflags_mask;
+
+      /** wait options given to os_evflags_wait() */
+      uint_fast8_t evflags_opt;
+#endif
+
+#ifdef OS_CONFIG_POOL
+      /** block handed over by os_pool_free() to task suspended in
+       * os_pool_alloc_wait() or message handed over by os_mbox_commit() to
+       * task suspended in os_mbox_borrow(), valid only at wakeup with
+       * block_code = OS_OK */
+      void *pool_block;
+#endif
    };
 
+#ifdef OS_CONFIG_TASKNOTIFY
+   /** notification word of the task, modified by os_task_notify() and consumed
+    * by os_task_notify_wait() */
+   uint32_t notify_value;
+
+   /** true in case task was notified since last os_task_notify_wait() */
+   bool notify_pending;
+#endif
+
+#ifdef OS_CONFIG_EDF
+   /** relative deadline of EDF task, 0 for regular tasks */
+   os_ticks_t edf_reldeadline;
+
+   /** absolute deadline of current job of EDF task, this is the key by which
+    * the task is ordered in EDF band of task_queues */
+   os_ticks_t edf_deadline;
+#endif
+
+#ifdef OS_CONFIG_BUDGET
+   /** execution budget in ticks per replenishment period, 0 in case task
+    * execution is not limited */
+   os_ticks_t budget;
+
+   /** remaining execution budget, task is exhausted when it reaches 0 */
+   os_ticks_t budget_rem;
+
+   /** replenishment period of budget */
+   os_ticks_t budget_period;
+
+   /** background priority used while budget is exhausted, 0 means that task
+    * is suspended until replenishment */
+   uint_fast8_t budget_prio;
+
+   /** base priority of the task saved while task is demoted */
+   uint_fast8_t budget_prio_orig;
+
+   /** true in case replenishment is pending (budget_timer is active) */
+   bool budget_armed;
+
+   /** timer which replenish the budget */
+   os_timer_t budget_timer;
+#endif
+
+#ifdef OS_CONFIG_PARTITION
+   /** partition which owns the task, NULL for background partition */
+   struct os_partition_tag *partition;
+#endif
+
+#ifdef OS_CONFIG_TIMERSLACK
+   /** slack used for timeouts of blocking functions called by this task, see
+    * os_task_timerslack_set() */
+   os_ticks_t timer_slack;
+#endif
+
+#ifdef OS_CONFIG_TASKPERIODIC
+   /** period of the task set by os_task_periodic_init(), 0 for non periodic
+    * tasks */
+   os_ticks_t period;
+
+   /** tick of the next release of the periodic task */
+   os_ticks_t period_release;
+
+   /** number of releases missed because the task did not finish its job
+    * within the period */
+   uint32_t period_overruns;
+#endif
+
    /** list of mutexes owned by task, this list is required to calculate new
     * prio_current during mutex unlock, extensive explanation of this can be
     * found in os_mtx_unlock. This list may be either empty or occupied either
@@ -119,6 +244,11 @@ typedef struct {
     * mutexes */
    list_t mtx_list;
 
+   /** list of rwlock ownership slots held by task, either shared or
+    * exclusive. Same as mtx_list it is used to calculate new prio_current
+    * while releasing the rwlock or any mutex */
+   list_t rwlock_list;
+
    /** pointer to semaphore from os_task_join(), it is provided by task which
     * would like to join this task and waits until this task will finish. Tis is
     * quite cheap solution to join() operation since here we kept only the
@@ -137,6 +267,14 @@ typedef struct {
       os_retcode_t block_code;
    };
 
+#ifdef OS_CONFIG_HEAP_TASKSTAT
+   /** number of bytes allocated by task from all heaps and not yet freed */
+   size_t heap_used;
+
+   /** high water mark of heap_used */
+   size_t heap_peak;
+#endif
+
 #ifdef OS_CONFIG_CHECKSTACK
    /** Pointer to stack end used for verification if it was not overflowed */
    void *stack_end;
@@ -317,6 +455,49 @@ void os_task_create(
    os_taskproc_t proc,
    void *param);
 
+#ifdef OS_CONFIG_EDF
+/**
+ * Function creates the task in EDF band. Within the band tasks are scheduled by
+ * their absolute deadline, task with the earliest deadline runs first and it
+ * preempts EDF task with later deadline. Tasks with priorities above the band
+ * preempt EDF tasks, tasks below the band run only when no EDF task is READY.
+ *
+ * Absolute deadline of first job is the moment of creation plus rel_deadline.
+ * For periodic EDF tasks os_task_wait_next_period() sets the deadline of each
+ * next job as its release plus rel_deadline, aperiodic tasks may use
+ * os_task_edf_deadline_set().
+ *
+ * @param task pointer to task structure (TCB)
+ * @param stack pointer to stack memory
+ * @param stack_size size of stack
+ * @param proc task entry point
+ * @param param parameter passed to task entry point
+ * @param rel_deadline relative deadline in ticks, must be greater than 0 and
+ *        lower than half of os_ticks_t range
+ *
+ * @pre same as for os_task_create()
+ */
+void os_task_create_edf(
+   os_task_t *task,
+   void *stack,
+   size_t stack_size,
+   os_taskproc_t proc,
+   void *param,
+   os_ticks_t rel_deadline);
+
+/**
+ * Function sets the absolute deadline of the current job of calling EDF task.
+ * Calling task may be preempted in case there is READY EDF task with earlier
+ * deadline.
+ *
+ * @param deadline absolute deadline (value of os_ticks_now() domain)
+ *
+ * @pre calling task must be created by os_task_create_edf()
+ * @pre this function cannot be called from ISR
+ */
+void os_task_edf_deadline_set(os_ticks_t deadline);
+#endif
+
 /**
  * By calling the function one task can wait until task given by parameter
  * will exit from its own entry point function. Return value from task entry
@@ -348,6 +529,147 @@ int os_task_join(os_task_t *task);
  */
 void os_yield(void);
 
+/**
+ * Function suspends the calling task until system tick counter will reach the
+ * given deadline. Since deadline is absolute, periodic loops which add the
+ * constant period to previous deadline are released at exact tick boundaries
+ * without accumulating the drift.
+ *
+ * @param deadline value of system tick counter (as returned by os_ticks_now())
+ *        at which task will be woken up. In case deadline was already reached
+ *        (or it is more than half of os_ticks_t range ahead) function returns
+ *        immediately.
+ *
+ * @pre this function cannot be called from ISR
+ * @pre this function cannot be called from idle task
+ */
+void os_task_sleep_until(os_ticks_t deadline);
+
+/**
+ * Function suspends the calling task for given number of ticks. Task is parked
+ * only on its block timer, without any synchronization object.
+ *
+ * @param timeout_ticks number of ticks to sleep, must be greater than 0 and
+ *        lower than OS_TIMEOUT_INFINITE
+ *
+ * @pre this function cannot be called from ISR
+ * @pre this function cannot be called from idle task
+ */
+void os_task_sleep(os_ticks_t timeout_ticks);
+
+#ifdef OS_CONFIG_TIMERSLACK
+/**
+ * Function sets the slack for timeouts of all blocking functions called by the
+ * calling task (including os_task_sleep()). Such timeouts may burn off up to
+ * slack ticks later, so they can be batched with other timers, as described
+ * for os_timer_create_slack(). Timeouts never burn off earlier. Slack of new
+ * tasks is 0.
+ *
+ * @param slack_ticks maximal allowed delay of timeouts in ticks
+ *
+ * @pre this function cannot be called from ISR
+ */
+void os_task_timerslack_set(os_ticks_t slack_ticks);
+#endif
+
+#ifdef OS_CONFIG_PREEMPTTHRESHOLD
+/**
+ * Function sets the preemption threshold of the task. Task is scheduled
+ * according to its priority, but once it runs it can be preempted only by tasks
+ * with priority above the threshold. This way tasks with priorities between
+ * priority and threshold of the task do not preempt each other, so they may
+ * share the data without mutexes, while they still can be preempted by more
+ * urgent tasks. In case the task was preempted, it resumes before any task with
+ * priority lower or equal to its threshold. Time slicing and os_yield() switch
+ * only to tasks above the threshold.
+ *
+ * @param task pointer to task
+ * @param threshold preemption threshold, must be greater or equal to priority
+ *        of the task and lower than OS_CONFIG_PRIOCNT. 0 disables the
+ *        threshold
+ *
+ * @pre this function cannot be called from ISR
+ * @note threshold is not lowered while task is demoted due exhausted budget
+ */
+void os_task_threshold_set(os_task_t *task, uint_fast8_t threshold);
+#endif
+
+#ifdef OS_CONFIG_BUDGET
+/**
+ * Function limits the execution time of the task (sporadic server with single
+ * replenishment). Each tick at which the task is running consumes one tick of
+ * its budget. Replenishment period starts at the first tick consumed from the
+ * full budget, at its end the budget is restored. When task exhausts its budget
+ * before the replenishment, it is either demoted to bg_prio, so it runs only in
+ * case no other task with higher priority is READY, or it is suspended until
+ * replenishment. This way misbehaving task cannot starve the tasks with lower
+ * priority for more than budget ticks in each period.
+ *
+ * @param task pointer to task
+ * @param budget execution budget in ticks, 0 removes the limit
+ * @param period replenishment period in ticks, must be greater than budget
+ * @param bg_prio priority used while budget is exhausted, must be lower than
+ *        task priority. 0 means that task will be suspended instead.
+ *
+ * @pre this function cannot be called from ISR
+ * @note budget is enforced at the tick, in case task locks the scheduler the
+ *       suspension is postponed until the first tick after scheduler unlock.
+ *       The same applies to task which owns mutex or rwlock, it overruns its
+ *       budget until the first tick after it releases all of them, so its
+ *       waiters are not blocked until replenishment. Priority inheritance may
+ *       still temporary boost the demoted task.
+ */
+void os_task_budget_set(
+   os_task_t *task,
+   os_ticks_t budget,
+   os_ticks_t period,
+   uint_fast8_t bg_prio);
+#endif
+
+#ifdef OS_CONFIG_HRTIMER
+/**
+ * Function suspends the calling task for given number of nanoseconds. Wakeup
+ * is done by hrtimer, so it is not quantized to system ticks.
+ *
+ * @param timeout_ns time to sleep in nanoseconds, must be greater than 0
+ *
+ * @pre this function cannot be called from ISR
+ * @pre this function cannot be called from idle task
+ */
+void os_task_sleep_ns(uint64_t timeout_ns);
+#endif
+
+#ifdef OS_CONFIG_TASKPERIODIC
+/**
+ * Function makes the calling task periodic. First release of the task is the
+ * moment of the call, so first os_task_wait_next_period() will suspend the task
+ * until os_ticks_now() + period. Function may be called again to change the
+ * period, this also resets the phase and overrun counter.
+ *
+ * @param period period of the task in ticks, must be greater than 0 and lower
+ *        than half of os_ticks_t range
+ *
+ * @pre this function cannot be called from ISR nor idle task
+ */
+void os_task_periodic_init(os_ticks_t period);
+
+/**
+ * Function suspends the calling periodic task until its next release. Releases
+ * are computed from the previous release (not from the moment of the call), so
+ * they do not drift. In case the task finished its job after the next release
+ * already passed (overrun), all missed releases are skipped so the task keeps
+ * its phase, and the number of skipped releases is accumulated in the
+ * period_overruns field of the task.
+ *
+ * @pre os_task_periodic_init() must be called before by the same task
+ * @pre this function cannot be called from ISR nor idle task
+ *
+ * @return number of releases missed since previous call, 0 in case the task
+ *         finished its job on time
+ */
+uint_fast16_t os_task_wait_next_period(void);
+#endif
+
 /**
  * Function verify if task stack was not overflowed
  *
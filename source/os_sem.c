@@ -32,6 +32,10 @@
 #include "os_private.h"
 
 /* private function forward declarations */
+static os_retcode_t os_sem_down_internal(
+   os_sem_t *sem,
+   os_ticks_t timeout_ticks,
+   bool until);
 static void os_sem_timerclbck(void *param);
 
 /* --- public functions --- */
@@ -46,6 +50,9 @@ void os_sem_create(
 
    memset(sem, 0, sizeof(os_sem_t));
    os_taskqueue_init(&(sem->task_queue));
+#ifdef OS_CONFIG_WAITANY
+   list_init(&(sem->waitany_list.list));
+#endif
    sem->value = init_value;
 }
 
@@ -65,6 +72,10 @@ void os_sem_destroy(os_sem_t *sem)
       task->block_code = OS_DESTROYED;
       os_task_makeready(task);
    }
+#ifdef OS_CONFIG_WAITANY
+   /* the same for tasks suspended in os_wait_any() */
+   while (os_waitany_wakeup(&(sem->waitany_list), NULL, OS_DESTROYED));
+#endif
    /* destroy all semaphore data, this can create problems if semaphore is used
     * in interrupt context (feel warned) */
    memset(sem, 0, sizeof(os_sem_t));
@@ -78,62 +89,51 @@ void os_sem_destroy(os_sem_t *sem)
 
 os_retcode_t OS_WARN_UNUSEDRET os_sem_down(
    os_sem_t *sem,
-   uint_fast16_t timeout_ticks)
+   os_ticks_t timeout_ticks)
+{
+   return os_sem_down_internal(sem, timeout_ticks, false);
+}
+
+os_retcode_t OS_WARN_UNUSEDRET os_sem_down_until(
+   os_sem_t *sem,
+   os_ticks_t deadline)
+{
+   return os_sem_down_internal(sem, deadline, true);
+}
+
+#ifdef OS_CONFIG_HRTIMER
+os_retcode_t OS_WARN_UNUSEDRET os_sem_down_ns(
+   os_sem_t *sem,
+   uint64_t timeout_ns)
 {
    os_retcode_t ret;
-   os_timer_t timer;
+   os_hrtimer_t timer;
    arch_criticalstate_t cristate;
 
    OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
    OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
    OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
-   /* calling of blocking function while holding mtx will cause priority inversion */
    OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
 
-   /* critical section needed because of timers and other ISRs which might call
-    * sem_up() while we operate on sem->task_queue and task_queue */
    arch_critical_enter(cristate);
-   do {
-      if (sem->value > 0) {
-         /* in case sem->value is not zero, we do not have to block, just to
-          * consume one from sem->value */
-         /* /TODO in future try to implement the "condition and decrement" as a
-          * CAS operation and move it before critical section, this will
-          * increase performance (something like os_atomic_cas() */
-         --(sem->value);
-         ret = OS_OK;
-         break;
-      }
-
-      /* sem->value == 0, need to block the calling task */
-      if (OS_TIMEOUT_TRY == timeout_ticks) {
-         /* task request to bail out in case operation would block */
-         ret = OS_WOULDBLOCK;
-         break;
-      }
-
-      /* does task request timeout guard for operation? */
-      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
-         /* we will get callback to os_sem_timerclbck() in case of timeout */
-         os_blocktimer_create(&timer, os_sem_timerclbck, timeout_ticks);
-      }
-
-      /* now block and switch the context */
+   if (sem->value > 0) {
+      --(sem->value);
+      ret = OS_OK;
+   } else if (0 == timeout_ns) {
+      ret = OS_WOULDBLOCK;
+   } else {
+      /* same as in os_sem_down(), only the timeout is guarded by hrtimer */
+      os_hrblocktimer_create(&timer, os_sem_timerclbck, timeout_ns);
       os_task_block_switch(&(sem->task_queue), OS_TASKBLOCK_SEM);
-
-      /* we return here once other task call os_sem_up() or timeout burs off
-       * cleanup, destroy timeout associated with task if it was created */
       os_blocktimer_destroy(task_current);
-
-      /* check the block_code, it was set in os_sem_destroy(), timer callback or
-       * in os_sem_up() */
       ret = task_current->block_code;
-
-   } while (0);
+   }
    arch_critical_exit(cristate);
 
    return ret;
 }
+#endif
 
 /* Copy from semaphore description
  * semaphores allow for single signalization per os_sem_up(). Defining API which
@@ -149,6 +149,7 @@ void os_sem_up_sync(
 {
    arch_criticalstate_t cristate;
    os_task_t *task;
+   bool awoken = false;
 
    /* \TODO implement nbr in function param so we can increase the semaphore
     * number more than once. To make it work in this way we have also to wake
@@ -167,7 +168,14 @@ void os_sem_up_sync(
    OS_ASSERT(sem->value < (ARCH_ATOMIC_MAX - 1));
 
    /* check if there are some suspended tasks on this sem */
-   task = os_taskqueue_dequeue(&(sem->task_queue));
+   task = os_taskqueue_peek(&(sem->task_queue));
+#ifdef OS_CONFIG_WAITANY
+   /* tasks suspended in os_wait_any() compete with tasks from task_queue, the
+    * most prioritized one consumes the signal */
+   if (os_waitany_wakeup(&(sem->waitany_list), task, OS_OK)) {
+      awoken = true;
+   } else
+#endif
    if (!task) {
       /* there was no suspended tasks, in this case just increment the sem value */
       ++(sem->value);
@@ -175,11 +183,15 @@ void os_sem_up_sync(
       /* there is suspended task, we need to wake it up
        * we need to destroy the guard timer of this task, because otherwise it
        * may fire right after we leave the critical section */
+      os_taskqueue_unlink(task);
       os_blocktimer_destroy(task);
 
       task->block_code = OS_OK; /* set the block code to NORMAL WAKEUP */
       os_task_makeready(task);
+      awoken = true;
+   }
 
+   if (awoken) {
       /* do not call schedule() if user requested sync mode.
        * User code may call some other OS function right away which will trigger
        * the os_schedule(). Parameter 'sync' is used for such optimization
@@ -195,6 +207,81 @@ void os_sem_up_sync(
 
 /* --- private functions --- */
 
+/**
+ * Common implementation of os_sem_down() and os_sem_down_until(). If until is
+ * true, the timeout_ticks is an absolute deadline.
+ */
+static os_retcode_t os_sem_down_internal(
+   os_sem_t *sem,
+   os_ticks_t timeout_ticks,
+   bool until)
+{
+   os_retcode_t ret;
+   os_timer_t timer;
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   /* calling of blocking function while holding mtx or rwlock will cause
+    * priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   /* critical section needed because of timers and other ISRs which might call
+    * sem_up() while we operate on sem->task_queue and task_queue */
+   arch_critical_enter(cristate);
+   do {
+      if (sem->value > 0) {
+         /* in case sem->value is not zero, we do not have to block, just to
+          * consume one from sem->value */
+         /* /TODO in future try to implement the "condition and decrement" as a
+          * CAS operation and move it before critical section, this will
+          * increase performance (something like os_atomic_cas() */
+         --(sem->value);
+         ret = OS_OK;
+         break;
+      }
+
+      /* sem->value == 0, need to block the calling task */
+      if (until) {
+         /* convert the deadline in the same critical section in which we arm
+          * the timer, so the release happens exactly at deadline tick */
+         timeout_ticks = os_ticks_until(timeout_ticks);
+         if (0 == timeout_ticks) {
+            ret = OS_TIMEOUT;
+            break;
+         }
+      }
+      if (OS_TIMEOUT_TRY == timeout_ticks) {
+         /* task request to bail out in case operation would block */
+         ret = OS_WOULDBLOCK;
+         break;
+      }
+
+      /* does task request timeout guard for operation? */
+      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+         /* we will get callback to os_sem_timerclbck() in case of timeout */
+         os_blocktimer_create(&timer, os_sem_timerclbck, timeout_ticks);
+      }
+
+      /* now block and switch the context */
+      os_task_block_switch(&(sem->task_queue), OS_TASKBLOCK_SEM);
+
+      /* we return here once other task call os_sem_up() or timeout burs off
+       * cleanup, destroy timeout associated with task if it was created */
+      os_blocktimer_destroy(task_current);
+
+      /* check the block_code, it was set in os_sem_destroy(), timer callback or
+       * in os_sem_up() */
+      ret = task_current->block_code;
+
+   } while (0);
+   arch_critical_exit(cristate);
+
+   return ret;
+}
+
 /**
  * Function called by timers module. Used for timeout of os_sem_down().
  * Callback to this function are done from contxt of timer_trigger().
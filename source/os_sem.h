@@ -68,6 +68,12 @@ typedef struct os_sem_tag {
    /* Semaphore value, os_atomit_c since semaphores can be incremented from ISR */
    arch_atomic_t value;
 
+#ifdef OS_CONFIG_WAITANY
+   /** list of os_wait_any() nodes suspended on this semaphore, sorted by
+    * priority of tasks */
+   listprio_t waitany_list;
+#endif
+
 } os_sem_t;
 
 /**
@@ -142,7 +148,47 @@ void os_sem_destroy(os_sem_t *sem);
  */
 os_retcode_t OS_WARN_UNUSEDRET os_sem_down(
    os_sem_t *sem,
-   uint_fast16_t timeout_ticks);
+   os_ticks_t timeout_ticks);
+
+/**
+ * Function works as os_sem_down() but timeout is given as absolute deadline
+ * (value of os_ticks_now()) instead of relative number of ticks. This allows
+ * retry loops and periodic tasks to wait for exact tick without accumulating
+ * the drift while recalculating the remaining time.
+ *
+ * @param sem pointer to semaphore
+ * @param deadline value of system tick counter at which operation will time
+ *        out. Deadline which was already reached (or which is more than half of
+ *        os_ticks_t range ahead) causes immediate OS_TIMEOUT in case semaphore
+ *        does not contain any signals.
+ *
+ * @pre same as for os_sem_down()
+ *
+ * @return OS_OK, OS_DESTROYED or OS_TIMEOUT with the same meaning as for
+ *         os_sem_down()
+ */
+os_retcode_t OS_WARN_UNUSEDRET os_sem_down_until(
+   os_sem_t *sem,
+   os_ticks_t deadline);
+
+#ifdef OS_CONFIG_HRTIMER
+/**
+ * Function works as os_sem_down() but timeout is given in nanoseconds and it is
+ * guarded by hrtimer, so it is not quantized to system ticks.
+ *
+ * @param sem pointer to semaphore
+ * @param timeout_ns time in nanoseconds before operation will time out. 0 has
+ *        the same meaning as OS_TIMEOUT_TRY for os_sem_down(). For infinite
+ *        timeout use os_sem_down()
+ *
+ * @pre same as for os_sem_down()
+ *
+ * @return same as for os_sem_down()
+ */
+os_retcode_t OS_WARN_UNUSEDRET os_sem_down_ns(
+   os_sem_t *sem,
+   uint64_t timeout_ns);
+#endif
 
 /**
  * Function signalizes the semaphore
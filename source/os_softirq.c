@@ -0,0 +1,117 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_SOFTIRQ
+
+/** Definition of softirq registration entry */
+typedef struct {
+   os_softirq_handler_t handler;
+   void *param;
+} os_softirq_t;
+
+/** Mask of pending softirqs, bit number is the softirq number */
+volatile arch_bitmask_t softirq_pending = 0;
+
+/** Registered softirq handlers */
+static os_softirq_t softirq_tab[OS_CONFIG_SOFTIRQCNT];
+
+/* --- public functions --- */
+/* all public functions are documented in os_softirq.h file */
+
+void os_softirq_register(
+   uint_fast8_t nr,
+   os_softirq_handler_t handler,
+   void *param)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(nr < OS_CONFIG_SOFTIRQCNT);
+
+   arch_critical_enter(cristate);
+   softirq_tab[nr].handler = handler;
+   softirq_tab[nr].param = param;
+   arch_critical_exit(cristate);
+}
+
+void os_softirq_raise(uint_fast8_t nr)
+{
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(isr_nesting > 0); /* only ISR can raise the softirq */
+   OS_ASSERT(nr < OS_CONFIG_SOFTIRQCNT);
+
+   /* nested ISR may modify the mask in the middle of read-modify-write */
+   arch_critical_enter(cristate);
+   arch_bitmask_set(softirq_pending, nr);
+   arch_critical_exit(cristate);
+}
+
+void os_softirq_run(void)
+{
+   uint_fast8_t nr;
+   os_softirq_t *softirq;
+
+   /* only most outer ISR runs the softirqs, nested ISRs only raise them and
+    * leave, so handlers are never nested */
+   OS_ASSERT(1 == isr_nesting);
+   OS_SELFCHECK_ASSERT(arch_is_dint());
+
+   /* always take the most prioritized pending softirq, since nested ISR may
+    * raise the softirq with higher priority than those which left */
+   while (0 != (nr = arch_bitmask_fls(softirq_pending))) {
+      --nr;
+      arch_bitmask_clear(softirq_pending, nr);
+      softirq = &softirq_tab[nr];
+
+      if (OS_LIKELY(softirq->handler)) {
+         arch_eint();
+         softirq->handler(softirq->param);
+         arch_dint();
+      }
+   }
+
+   /* tasks could be woken up by nested ISRs, which cannot switch the tasks
+    * (see os_schedule()). Check now since we are still at nesting level 1 */
+   os_schedule(1);
+}
+
+/* --- protected functions --- */
+
+void os_softirq_init(void)
+{
+   softirq_pending = 0;
+   memset(softirq_tab, 0, sizeof(softirq_tab));
+}
+
+#endif
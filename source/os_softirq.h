@@ -0,0 +1,111 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_SOFTIRQ_
+#define __OS_SOFTIRQ_
+
+#ifdef OS_CONFIG_SOFTIRQ
+
+/**
+ * Softirq is the bottom half of interrupt handler. ISR (top half) does only
+ * the time critical part of work (like acknowledging the HW and reading the
+ * data register) and raises the softirq to do the rest. Softirqs have
+ * following characteristics:
+ * - there are OS_CONFIG_SOFTIRQCNT softirqs, the number of softirq is also its
+ *   priority (higher number runs first)
+ * - raising is cheap, it only sets the bit in pending mask. Multiple raises
+ *   before the handler runs are batched into single handler call
+ * - pending softirqs are run at exit of most outer ISR (from
+ *   arch_contextrestore_i), with interrupts enabled but before any task
+ *   resumes. Softirq handlers run in context of ISR, so they can use only
+ *   those OS functions which can be called from ISR, and they can be
+ *   preempted by nested interrupts but never by tasks nor other softirqs
+ */
+
+/** Softirq handler, called with param given in os_softirq_register() */
+typedef void (*os_softirq_handler_t)(void *param);
+
+/* needs to be visible to user because of arch_contextrestore_i macros */
+extern volatile arch_bitmask_t softirq_pending;
+
+/**
+ * Function registers the handler for softirq
+ *
+ * @param nr number of softirq, also its priority, must be <
+ *        OS_CONFIG_SOFTIRQCNT. OS_CONFIG_ISRPOST_SOFTIRQ is reserved for kernel
+ *        in case OS_CONFIG_ISRPOST is enabled
+ * @param handler softirq handler, NULL unregisters the handler
+ * @param param parameter passed to handler
+ *
+ * @pre this function cannot be called from ISR
+ */
+void os_softirq_register(
+   uint_fast8_t nr,
+   os_softirq_handler_t handler,
+   void *param);
+
+/**
+ * Function marks the softirq as pending. Handler will be called at exit of
+ * most outer ISR.
+ *
+ * @param nr number of softirq, must be < OS_CONFIG_SOFTIRQCNT
+ *
+ * @pre this function can be called ONLY from ISR (including softirq handlers)
+ */
+void os_softirq_raise(uint_fast8_t nr);
+
+/**
+ * Function runs all pending softirqs. This function is called by
+ * arch_contextrestore_i at exit of most outer ISR, it should not be called
+ * directly by user code.
+ *
+ * @pre this function can be called only from ISR at nesting level 1 with
+ *      interrupts disabled
+ * @post interrupts are disabled at return
+ */
+void os_softirq_run(void);
+
+/** Called by arch_contextrestore_i before the context of task is restored */
+#define os_softirq_isrexit() \
+   do { \
+      if ((1 == isr_nesting) && (0 != softirq_pending)) \
+         os_softirq_run(); \
+   } while (0)
+
+#else
+
+#define os_softirq_isrexit() \
+   do { \
+   } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_STREAM
+
+/* private function forward declarations */
+static void os_stream_wakeup(os_stream_t *stream);
+static void os_stream_timerclbck(void *param);
+
+/* --- public functions --- */
+/* all public functions are documented in os_stream.h file */
+
+void os_stream_create(
+   os_stream_t *stream,
+   void *mem,
+   arch_ridx_t size,
+   arch_ridx_t trigger)
+{
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   /* free running indexes require power of 2 size which is at most half of
+    * index range */
+   OS_ASSERT((size > 0) && (0 == (size & (size - 1))));
+   OS_ASSERT(size <= (ARCH_RIDX_MAX / 2 + 1));
+   OS_ASSERT((trigger > 0) && (trigger <= size));
+
+   memset(stream, 0, sizeof(os_stream_t));
+   os_taskqueue_init(&(stream->task_queue));
+   stream->mem = (uint8_t*)mem;
+   stream->size = size;
+   stream->trigger = trigger;
+}
+
+void os_stream_destroy(os_stream_t *stream)
+{
+   arch_criticalstate_t cristate;
+   os_task_t *task;
+
+   OS_ASSERT(0 == isr_nesting);     /* cannot call from ISR */
+   OS_ASSERT(!waitqueue_current);   /* cannot call after os_waitqueue_prepare() */
+
+   arch_critical_enter(cristate);
+
+   /* wake up the consumer if it is suspended */
+   while ((task = os_taskqueue_dequeue(&(stream->task_queue)))) {
+      os_blocktimer_destroy(task); /* destroy the tasks timer */
+      task->block_code = OS_DESTROYED;
+      os_task_makeready(task);
+   }
+   memset(stream, 0, sizeof(os_stream_t));
+
+   /* schedule to make context switch in case os_stream_destroy() was called
+    * by lower priority task than consumer */
+   os_schedule(1);
+
+   arch_critical_exit(cristate);
+}
+
+void os_stream_set_trigger(
+   os_stream_t *stream,
+   arch_ridx_t trigger)
+{
+   arch_criticalstate_t cristate;
+
+   /* tasks cannot call any OS functions if they are 'prepared' to suspend on
+    * wait_queue, with exception to ISR's */
+   OS_ASSERT((isr_nesting > 0) || (!waitqueue_current));
+   OS_ASSERT((trigger > 0) && (trigger <= stream->size));
+
+   arch_critical_enter(cristate);
+   stream->trigger = trigger;
+   /* lowered trigger level may be already reached */
+   os_stream_wakeup(stream);
+   arch_critical_exit(cristate);
+}
+
+arch_ridx_t os_stream_count(os_stream_t *stream)
+{
+   return (arch_ridx_t)(os_atomic_load(&(stream->wr)) -
+                        os_atomic_load(&(stream->rd)));
+}
+
+arch_ridx_t os_stream_write_acquire(
+   os_stream_t *stream,
+   uint8_t **ptr)
+{
+   arch_ridx_t wr = stream->wr; /* only producer modifies the wr */
+   arch_ridx_t pos = wr & (stream->size - 1);
+   arch_ridx_t len;
+
+   /* free space, limited by the end of ring memory */
+   len = stream->size - (arch_ridx_t)(wr - os_atomic_load(&(stream->rd)));
+   if (len > stream->size - pos)
+      len = stream->size - pos;
+
+   *ptr = stream->mem + pos;
+   return len;
+}
+
+void os_stream_write_commit(
+   os_stream_t *stream,
+   arch_ridx_t len)
+{
+   arch_criticalstate_t cristate;
+
+   /* tasks cannot call any OS functions if they are 'prepared' to suspend on
+    * wait_queue, with exception to ISR's */
+   OS_ASSERT((isr_nesting > 0) || (!waitqueue_current));
+   OS_ASSERT(len <= stream->size - os_stream_count(stream));
+
+   /* publish the data, consumer checks the wr in critical section before it
+    * suspends, so after this store we either see the consumer on task_queue or
+    * consumer will see the data */
+   os_atomic_store(&(stream->wr), (arch_ridx_t)(stream->wr + len));
+
+   if (OS_LIKELY(0 == stream->task_queue.mask))
+      return;
+
+   arch_critical_enter(cristate);
+   os_stream_wakeup(stream);
+   arch_critical_exit(cristate);
+}
+
+arch_ridx_t os_stream_read_acquire(
+   os_stream_t *stream,
+   const uint8_t **ptr,
+   os_ticks_t timeout_ticks)
+{
+   os_timer_t timer;
+   arch_criticalstate_t cristate;
+   arch_ridx_t rd;
+   arch_ridx_t pos;
+   arch_ridx_t len;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(!waitqueue_current); /* cannot call after os_waitqueue_prepare() */
+   /* calling of blocking function while holding mtx or rwlock will cause
+    * priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   /* fast path, check without critical section */
+   if ((OS_TIMEOUT_TRY != timeout_ticks) &&
+       (os_stream_count(stream) < stream->trigger)) {
+      arch_critical_enter(cristate);
+      /* check again in critical section, producer may be in ISR */
+      if (os_stream_count(stream) < stream->trigger) {
+         OS_ASSERT(0 == stream->task_queue.mask); /* only one consumer */
+
+         /* does task request timeout guard for operation? */
+         if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+            /* we will get callback to os_stream_timerclbck() in case of
+             * timeout */
+            os_blocktimer_create(&timer, os_stream_timerclbck, timeout_ticks);
+         }
+
+         os_task_block_switch(&(stream->task_queue), OS_TASKBLOCK_STREAM);
+
+         /* we return here either after os_stream_write_commit(), destroy or
+          * timeout. Destroy the timeout guard if it was created */
+         os_blocktimer_destroy(task_current);
+
+         if (OS_DESTROYED == task_current->block_code) {
+            arch_critical_exit(cristate);
+            return 0;
+         }
+      }
+      arch_critical_exit(cristate);
+   }
+
+   /* in case of timeout we return whatever is available */
+   rd = stream->rd; /* only consumer modifies the rd */
+   pos = rd & (stream->size - 1);
+   len = (arch_ridx_t)(os_atomic_load(&(stream->wr)) - rd);
+   if (len > stream->size - pos)
+      len = stream->size - pos;
+
+   *ptr = stream->mem + pos;
+   return len;
+}
+
+void os_stream_read_release(
+   os_stream_t *stream,
+   arch_ridx_t len)
+{
+   OS_ASSERT(len <= os_stream_count(stream));
+
+   /* after this store producer can overwrite the released data */
+   os_atomic_store(&(stream->rd), (arch_ridx_t)(stream->rd + len));
+}
+
+/**
+ * Function wakes up the consumer in case it is suspended and trigger level was
+ * reached. Must be called from critical section.
+ */
+static void os_stream_wakeup(os_stream_t *stream)
+{
+   os_task_t *task;
+
+   if ((0 != stream->task_queue.mask) &&
+       (os_stream_count(stream) >= stream->trigger)) {
+      task = os_taskqueue_dequeue(&(stream->task_queue));
+      /* we need to destroy the timer here, because otherwise it may fire
+       * right after we leave the critical section */
+      os_blocktimer_destroy(task);
+      task->block_code = OS_OK; /* set the block code to NORMAL WAKEUP */
+      os_task_makeready(task);
+
+      /* switch to more prioritized READY task, if there is such (1 as param
+       * in os_schedule() means just that */
+      os_schedule(1);
+   }
+}
+
+/**
+ * Function called by timers module. Used for timeout of
+ * os_stream_read_acquire(). Callback to this function are done from context of
+ * timer_trigger().
+ */
+static void os_stream_timerclbck(void *param)
+{
+   /* single timer has param in os_blocktimer_create() as pointer to task
+    * structure */
+   os_task_t *task = (os_task_t*)param;
+
+   OS_SELFCHECK_ASSERT(TASKSTATE_WAIT == task->state);
+
+   /* remove task from stream buffer task_queue */
+   os_taskqueue_unlink(task);
+   task->block_code = OS_TIMEOUT;
+   os_task_makeready(task);
+   /* we do not call the os_schedule() here, because this will be done at the
+    * end of timer_trigger() */
+}
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_STREAM_
+#define __OS_STREAM_
+
+#ifdef OS_CONFIG_STREAM
+
+/**
+ * Stream buffer is a byte ring for single producer and single consumer, like
+ * UART driver and protocol parser task. It has following characteristics:
+ * - producer and consumer work directly on ring memory. Producer gets the
+ *   contiguous free region by os_stream_write_acquire(), fills it (for
+ *   instance by DMA) and publishes the data by os_stream_write_commit().
+ *   Consumer gets the contiguous region of data by os_stream_read_acquire(),
+ *   scans it in place and frees it by os_stream_read_release()
+ * - ring is indexed by free running arch_ridx_t indexes. Write index is
+ *   modified only by producer and read index only by consumer, so the data
+ *   path is lock-free. Kernel is entered only when consumer needs to wait
+ * - consumer waits until the number of bytes in ring will reach the trigger
+ *   level or until timeout. This allows to wake up the task once per packet
+ *   or burst instead of each byte
+ * - producer can be ISR or task, it never blocks. In case ring is full the
+ *   acquired region has 0 length
+ * - contiguous region ends at the end of ring memory. In case data wraps
+ *   around, os_stream_read_acquire() returns less than available, next call
+ *   with OS_TIMEOUT_TRY returns the rest
+ */
+
+/** Definition of stream buffer structure */
+typedef struct {
+   /** queue of tasks suspended in os_stream_read_acquire(), since there is
+    * only one consumer it may contain at most one task */
+   os_taskqueue_t task_queue;
+
+   /** ring memory */
+   uint8_t *mem;
+
+   /** size of ring memory, power of 2 */
+   arch_ridx_t size;
+
+   /** free running write index, modified only by producer */
+   arch_ridx_t wr;
+
+   /** free running read index, modified only by consumer */
+   arch_ridx_t rd;
+
+   /** number of bytes which wakes up the consumer */
+   arch_ridx_t trigger;
+
+} os_stream_t;
+
+/**
+ * Function creates the stream buffer
+ *
+ * @param stream pointer to stream buffer
+ * @param mem pointer to ring memory
+ * @param size size of ring memory, must be power of 2 and <=
+ *        (ARCH_RIDX_MAX / 2 + 1)
+ * @param trigger number of bytes for which consumer waits, must be > 0 and
+ *        <= @param size
+ */
+void os_stream_create(
+   os_stream_t *stream,
+   void *mem,
+   arch_ridx_t size,
+   arch_ridx_t trigger);
+
+/**
+ * Function destroys the stream buffer
+ *
+ * @param stream pointer to stream buffer
+ *
+ * @pre this function cannot be called from ISR
+ *
+ * @post consumer suspended in os_stream_read_acquire() will be released with
+ *       0 bytes. The same race conditions as described for os_sem_destroy()
+ *       apply here.
+ */
+void os_stream_destroy(os_stream_t *stream);
+
+/**
+ * Function changes the trigger level of stream buffer. Producer can use it to
+ * flush the tail of data, like at the end of packet or on UART idle line.
+ *
+ * @param stream pointer to stream buffer
+ * @param trigger number of bytes for which consumer waits, must be > 0 and
+ *        <= stream size
+ *
+ * @pre this function CAN be called from ISR
+ *
+ * @post this function may cause preemption since it can wake up consumer in
+ *       case new trigger level is already reached
+ */
+void os_stream_set_trigger(
+   os_stream_t *stream,
+   arch_ridx_t trigger);
+
+/**
+ * Function returns the number of bytes stored in stream buffer
+ *
+ * @pre this function CAN be called from ISR
+ */
+arch_ridx_t os_stream_count(os_stream_t *stream);
+
+/**
+ * Function returns the contiguous free region of ring
+ *
+ * @param stream pointer to stream buffer
+ * @param ptr pointer to variable where the beginning of region will be stored
+ *
+ * @pre this function CAN be called from ISR
+ * @pre only the producer can call this function
+ *
+ * @return length of free region, 0 if the ring is full
+ */
+arch_ridx_t os_stream_write_acquire(
+   os_stream_t *stream,
+   uint8_t **ptr);
+
+/**
+ * Function publishes the data written into region returned by
+ * os_stream_write_acquire(). Consumer is woken up in case trigger level was
+ * reached.
+ *
+ * @param stream pointer to stream buffer
+ * @param len number of bytes written, must be <= length of acquired region
+ *
+ * @pre this function CAN be called from ISR
+ * @pre only the producer can call this function
+ *
+ * @post this function may cause preemption since it can wake up task with
+ *       higher priority than caller task
+ */
+void os_stream_write_commit(
+   os_stream_t *stream,
+   arch_ridx_t len);
+
+/**
+ * Function returns the contiguous region of data. In case the number of bytes
+ * in stream is below trigger level, function suspends the calling task until
+ * trigger level will be reached or timeout will burn off.
+ *
+ * @param stream pointer to stream buffer
+ * @param ptr pointer to variable where the beginning of region will be stored
+ * @param timeout_ticks number of jiffies (os_tick() call count) before
+ *        operation will time out. OS_TIMEOUT_INFINITE has the same meaning as
+ *        for os_sem_down(). OS_TIMEOUT_TRY returns available data without
+ *        checking the trigger level.
+ *
+ * @pre this function cannot be used from ISR nor idle task
+ * @pre only the consumer can call this function
+ *
+ * @return length of data region. It may be smaller than trigger level in case
+ *         of timeout or OS_TIMEOUT_TRY, 0 in case there is no data or stream
+ *         was destroyed
+ */
+arch_ridx_t os_stream_read_acquire(
+   os_stream_t *stream,
+   const uint8_t **ptr,
+   os_ticks_t timeout_ticks);
+
+/**
+ * Function frees the data consumed from region returned by
+ * os_stream_read_acquire()
+ *
+ * @param stream pointer to stream buffer
+ * @param len number of bytes consumed, must be <= length of acquired region
+ *
+ * @pre only the consumer can call this function
+ */
+void os_stream_read_release(
+   os_stream_t *stream,
+   arch_ridx_t len);
+
+#endif
+
+#endif
@@ -36,10 +36,11 @@
  * For more info look at timer_tick_unsynch */
 #define OS_TIMER_UNSYNCH_MAX ((os_ticks_t)1024)
 
-/** Prevent from creating timer with to big timeout, even if timeout will fit
- * into timeout datatype, it could create problems with high
- * OS_TIMER_UNSYNCH_MAX */
-#define OS_TIMER_TICKSREM_MAX ((os_ticks_t)(UINT16_MAX - OS_TIMER_UNSYNCH_MAX))
+/** Maximal value of ticks_rem. Since ticks_rem is increased by
+ * timer_tick_unsynch, we need to leave the headroom to prevent from overflow.
+ * Longer timeouts are cascaded by ticks_ext */
+#define OS_TIMER_TICKSREM_MAX \
+   ((os_ticks_t)(OS_TICKS_MAX - OS_TIMER_UNSYNCH_MAX - 1))
 
 #define OS_TIMER_MAGIC1 ((uint_fast16_t)0xAABB)
 #define OS_TIMER_MAGIC2 ((uint_fast16_t)0xCCDD)
@@ -47,6 +48,11 @@
 /** Global monotonic counter of system ticks */
 os_ticks_t ticks_cnt = 0;
 
+#if OS_TICKS_WIDTH < 64
+/** Number of ticks_cnt overflows, extends ticks_cnt to 64 bits */
+static uint64_t ticks_epoch = 0;
+#endif
+
 /** Global list of all timers. Timers are sorted by time which remain until
  *  burnoff */
 static list_t timer_list;
@@ -63,6 +69,56 @@ static list_t timer_list;
  * OS_TIMER_UNSYNCH_MAX */
 static os_ticks_t timer_tick_unsynch = 0;
 
+#ifdef OS_CONFIG_TIMERDAEMON
+/** List of expired timers, waiting for the daemon to call their callbacks */
+static list_t timer_pending;
+
+/** Timer daemon task */
+static os_task_t timer_daemon_task;
+
+/** Stack of timer daemon task */
+static OS_TASKSTACK timer_daemon_stack[OS_CONFIG_TIMERDAEMON_STACKSIZE];
+#endif
+
+/** Function initializes the timer and adds it to the timer list */
+static void timer_create(
+   os_timer_t *timer,
+   timer_proc_t clbck,
+   void *param,
+   os_ticks_t timeout_ticks,
+   os_ticks_t reload_ticks,
+   os_ticks_t slack_ticks,
+   bool daemon);
+
+/** Function sets the remaining time of timer. Timeouts which does not fit into
+ * ticks_rem are cascaded, the rest is kept in ticks_ext and timer is rearmed
+ * with it by this function when ticks_rem burns off */
+static void timer_cascade(
+   os_timer_t *timer,
+   os_ticks_t ticks)
+{
+   if (ticks > OS_TIMER_TICKSREM_MAX) {
+      timer->ticks_rem = OS_TIMER_TICKSREM_MAX;
+      timer->ticks_ext = ticks - OS_TIMER_TICKSREM_MAX;
+   } else {
+      timer->ticks_rem = ticks;
+      timer->ticks_ext = 0;
+   }
+}
+
+/** Function arms the timer for given timeout (or reload period). Slack is
+ * added only here, not in cascade of the timeout */
+static void timer_arm(
+   os_timer_t *timer,
+   os_ticks_t ticks)
+{
+#ifdef OS_CONFIG_TIMERSLACK
+   /* timer is armed for the end of its slack window */
+   ticks += timer->slack;
+#endif
+   timer_cascade(timer, ticks);
+}
+
 /** Function add the timer to the timer list. Function keeps the timer list
  * sorted by remaining burn off time of the timers. */
 static void timer_add(os_timer_t *add_timer)
@@ -90,6 +146,9 @@ static void OS_NOINLINE timer_trigger(void)
    list_t *itr;
    os_timer_t *itr_timer;
    list_t list_autoreload;
+#ifdef OS_CONFIG_TIMERSLACK
+   bool burnoff = false;
+#endif
 
    /* for auto reloaded timers use temporary list */
    list_init(&list_autoreload);
@@ -99,40 +158,130 @@ static void OS_NOINLINE timer_trigger(void)
       /* the list will be modified, calculate  pointer the next element */
       itr = itr->next;
       if ((itr_timer->ticks_rem -= timer_tick_unsynch) > 0) {
+#ifdef OS_CONFIG_TIMERSLACK
+         /* Timer which slack window already started is batched with timers
+          * which burn off at this tick. Since the list is sorted by the end of
+          * window this happens only after some timer burned off */
+         if (burnoff && (0 == itr_timer->ticks_ext) &&
+             (itr_timer->ticks_rem <= itr_timer->slack)) {
+            itr_timer->ticks_rem = 0;
+         } else
+#endif
          /* This timer did not timeout (this means that following will not
-          * either). From now on we will hit this condition and only update the
-          * ticks_rem of all remaining timers on the list */
+          * either, beside the timers with slack). From now on we will hit this
+          * condition and only update the ticks_rem of all remaining timers on
+          * the list */
          continue;
       }
 
       /* this timer has timed out, remove timer from list of active timers */
       list_unlink(&(itr_timer->list));
+#ifdef OS_CONFIG_TIMERSLACK
+      burnoff = true;
+#endif
+
+      if (OS_UNLIKELY(itr_timer->ticks_ext > 0)) {
+         /* only the first part of cascaded timeout burned off, rearm with
+          * the rest */
+         timer_cascade(itr_timer, itr_timer->ticks_ext);
+         list_append(&list_autoreload, &(itr_timer->list));
+         continue;
+      }
 
-      /* call the timer callback. Keep in mind that from this callback it is
-       * allowed to call the os_timer_destroy() */
-      itr_timer->clbck(itr_timer->param);
+#ifdef OS_CONFIG_TIMERDAEMON
+      if (itr_timer->daemon) {
+         /* callback will be called by daemon, queue the timer only in case it
+          * is not already queued (auto reload timer which expired again) */
+         if (list_is_empty(&(itr_timer->pending)))
+            list_append(&timer_pending, &(itr_timer->pending));
+      } else
+#endif
+      {
+         /* call the timer callback. Keep in mind that from this callback it is
+          * allowed to call the os_timer_destroy() */
+         itr_timer->clbck(itr_timer->param);
+      }
 
       if (itr_timer->ticks_reload > 0) {
          /* seems that timer callback does not destroyed the timer and it is
           * (still) marked as auto-reload. We cannot imidiatelly add this timer
           * back on to timer list. We need to use temporary list */
+         timer_arm(itr_timer, itr_timer->ticks_reload);
          list_append(&list_autoreload, &(itr_timer->list));
       }
    }
 
    timer_tick_unsynch = 0;
 
-   /* Now re-add all auto reload timers from temporary list.
+   /* Now re-add all auto reload and cascaded timers from temporary list.
     * We need a temporary list because we keep all timers sorted, and we cannot
     * figure out the position of timers which we auto reload until we finish
     * processing of timer list */
    while ((itr = list_detachfirst(&list_autoreload))) {
       itr_timer = os_container_of(itr, os_timer_t, list);
-      itr_timer->ticks_rem = itr_timer->ticks_reload;
       timer_add(itr_timer); /* add timer at the proper place at the list */
    }
+
+#ifdef OS_CONFIG_TIMERDAEMON
+   /* wake up the daemon if there is some work for it, context switch will be
+    * done at the end of os_tick(). Daemon may be also blocked inside of
+    * callback, then it will check the pending list once callback returns */
+   if ((!list_is_empty(&timer_pending)) &&
+       (TASKSTATE_WAIT == timer_daemon_task.state) &&
+       (OS_TASKBLOCK_TIMERDAEMON == timer_daemon_task.block_type)) {
+      os_task_makeready(&timer_daemon_task);
+   }
+#endif
+}
+
+#ifdef OS_CONFIG_TIMERDAEMON
+/** Timer daemon task procedure, calls the callbacks of expired timers */
+static int timer_daemon(void *OS_UNUSED(param))
+{
+   arch_criticalstate_t cristate;
+   list_t *itr;
+   os_timer_t *timer;
+   timer_proc_t clbck;
+   void *clbck_param;
+
+   arch_critical_enter(cristate);
+   while (1) {
+      itr = list_detachfirst(&timer_pending);
+      if (!itr) {
+         /* nothing to do, suspend until os_tick() will queue some timers */
+         os_task_block_switch(NULL, OS_TASKBLOCK_TIMERDAEMON);
+         continue;
+      }
+      timer = os_container_of(itr, os_timer_t, pending);
+      clbck = timer->clbck;
+      clbck_param = timer->param;
+
+      /* call the callback with interrupts enabled. Keep in mind that from
+       * this callback it is allowed to call the os_timer_destroy() */
+      arch_critical_exit(cristate);
+      clbck(clbck_param);
+      arch_critical_enter(cristate);
+   }
+
+   return 0;
 }
 
+/** Function creates the timer daemon task, can be called only from os_init() */
+void OS_COLD os_timers_daemon_init(void)
+{
+   list_init(&timer_pending);
+   os_task_create(
+      &timer_daemon_task, OS_CONFIG_TIMERDAEMON_PRIO,
+      timer_daemon_stack, sizeof(timer_daemon_stack),
+      timer_daemon, NULL);
+#ifdef OS_CONFIG_PARTITION
+   /* daemon calls the callbacks of timers from all partitions, it cannot
+    * wait for background window */
+   os_partition_systask_set(&timer_daemon_task);
+#endif
+}
+#endif
+
 /** Module initialization function, can be called only from os_start() */
 void OS_COLD os_timers_init(void)
 {
@@ -145,13 +294,52 @@ void os_timer_create(
    void *param,
    os_ticks_t timeout_ticks,
    os_ticks_t reload_ticks)
+{
+   /* application timers are handled by daemon if it is enabled */
+   timer_create(timer, clbck, param, timeout_ticks, reload_ticks, 0, true);
+}
+
+#ifdef OS_CONFIG_TIMERSLACK
+void os_timer_create_slack(
+   os_timer_t *timer,
+   timer_proc_t clbck,
+   void *param,
+   os_ticks_t timeout_ticks,
+   os_ticks_t reload_ticks,
+   os_ticks_t slack_ticks)
+{
+   timer_create(
+      timer, clbck, param, timeout_ticks, reload_ticks, slack_ticks, true);
+}
+#endif
+
+void os_timer_create_direct(
+   os_timer_t *timer,
+   timer_proc_t clbck,
+   void *param,
+   os_ticks_t timeout_ticks,
+   os_ticks_t slack_ticks)
+{
+   timer_create(timer, clbck, param, timeout_ticks, 0, slack_ticks, false);
+}
+
+static void timer_create(
+   os_timer_t *timer,
+   timer_proc_t clbck,
+   void *param,
+   os_ticks_t timeout_ticks,
+   os_ticks_t reload_ticks,
+   os_ticks_t slack_ticks,
+   bool daemon)
 {
    arch_criticalstate_t cristate;
 
    /* timeout must be at least 1 tick in future */
    OS_ASSERT(timeout_ticks > 0);
-   /* and cannot be to high, or it will create problems with unsynch ticks */
-   OS_ASSERT(timeout_ticks < OS_TIMER_TICKSREM_MAX);
+   /* OS_TIMEOUT_INFINITE does not make sense for timers, the end of slack
+    * window has to fit into os_ticks_t too */
+   OS_ASSERT(timeout_ticks < (OS_TICKS_MAX - slack_ticks));
+   OS_ASSERT(reload_ticks < (OS_TICKS_MAX - slack_ticks));
    /* prevent from double usage of already initialized timer */
    OS_ASSERT(timer->magic != OS_TIMER_MAGIC1);
 
@@ -160,10 +348,21 @@ void os_timer_create(
 
    //memset(timer, 0, sizeof(os_timer_t));
    list_init(&(timer->list));
-   timer->ticks_rem = timeout_ticks;
+#ifdef OS_CONFIG_TIMERSLACK
+   timer->slack = slack_ticks;
+#else
+   (void)slack_ticks;
+#endif
+   timer_arm(timer, timeout_ticks);
    timer->ticks_reload = reload_ticks;
    timer->clbck = clbck;
    timer->param = param;
+#ifdef OS_CONFIG_TIMERDAEMON
+   list_init(&(timer->pending));
+   timer->daemon = daemon;
+#else
+   (void)daemon;
+#endif
 #ifdef OS_CONFIG_APICHECK
    timer->magic = OS_TIMER_MAGIC1;
 #endif
@@ -203,6 +402,12 @@ void os_timer_destroy(os_timer_t *timer)
       timer->ticks_reload = 0;
    }
 
+#ifdef OS_CONFIG_TIMERDAEMON
+   /* remove from pending list in case timer expired but daemon did not call
+    * the callback yet (safe also for timers which are not queued) */
+   list_unlink(&(timer->pending));
+#endif
+
 #ifdef OS_CONFIG_APICHECK
    /* obstruct magic, mark that this timer was successfully destroyed
     * \note this function is designed in way, that ss long as the memory for
@@ -232,7 +437,26 @@ void OS_HOT os_tick(void)
    /* Increment system global monotonic ticks counter.
     * Overflow scenario for this counter are handled by usage os_ticks_now()
     * and os_ticks_diff() */
+#if OS_TICKS_WIDTH < 64
+   if (OS_UNLIKELY(0 == ++ticks_cnt))
+      ++ticks_epoch;
+#else
    ++ticks_cnt;
+#endif
+
+#ifdef OS_CONFIG_PARTITION
+   os_partition_tick();
+#endif
+
+#ifdef OS_CONFIG_CYCLIC
+   os_cyclic_tick();
+#endif
+
+#ifdef OS_CONFIG_BUDGET
+   /* charge the interrupted task before timers are processed, replenishment
+    * timer armed here already counts this tick */
+   os_task_budget_charge();
+#endif
 
    if (!list_is_empty(&timer_list)) {
 
@@ -241,8 +465,8 @@ void OS_HOT os_tick(void)
       /* Perform iteration over timer list only in following cases:
        * - timeout of first timer (only than following could possibly timeout
        *   too)
-       * - since timeout fields (os_ticks_t) is limited in size (16 bits) we
-       *   need to synch from time to time
+       * - since timeout fields (os_ticks_t) are limited in size we need to
+       *   synch from time to time
        * */
       head_timer = os_container_of(
          list_peekfirst(&timer_list), os_timer_t, list);
@@ -261,21 +485,44 @@ void OS_HOT os_tick(void)
 
 os_ticks_t os_ticks_now(void)
 {
+#if OS_TICKS_WIDTH > ARCH_TICKS_WIDTH
+   arch_criticalstate_t cristate;
+   os_ticks_t ret;
+
+   /* counter is wider than arch can read atomically */
+   arch_critical_enter(cristate);
+   ret = ticks_cnt;
+   arch_critical_exit(cristate);
+
+   return ret;
+#else
    return os_atomic_load(&ticks_cnt);
+#endif
 }
 
-/* \TODO unit test missing */
-os_ticks_t os_ticks_diff(
-   os_ticks_t ticks_start,
-   os_ticks_t ticks_end)
+uint64_t os_ticks_now64(void)
 {
-   os_ticks_t ret;
+#if OS_TICKS_WIDTH < 64
+   arch_criticalstate_t cristate;
+   uint64_t ret;
 
-   if (ticks_start > ticks_end)
-      ret = OS_TICKS_MAX - ticks_start + 1 + ticks_end;
-   else
-      ret = ticks_end - ticks_start;
+   /* epoch and counter must be consistent */
+   arch_critical_enter(cristate);
+   ret = (ticks_epoch << OS_TICKS_WIDTH) | ticks_cnt;
+   arch_critical_exit(cristate);
 
    return ret;
+#else
+   return os_ticks_now();
+#endif
+}
+
+os_ticks_t os_ticks_diff(
+   os_ticks_t ticks_start,
+   os_ticks_t ticks_end)
+{
+   /* counter wraps around at type boundary so unsigned arithmetic handles
+    * the overflow */
+   return (os_ticks_t)(ticks_end - ticks_start);
 }
 
@@ -46,6 +46,18 @@
  * - number of system tick which will be used as next timeout in case of user
  *   would like to use auto-reload functionality (need to be 0 in case of single
  *   shot timers
+ *
+ * By default callbacks are called from os_tick(), so from ISR with interrupts
+ * disabled. In case OS_CONFIG_TIMERDAEMON is defined, callbacks of timers
+ * created by os_timer_create() are called from timer daemon task with
+ * OS_CONFIG_TIMERDAEMON_PRIO priority instead. os_tick() only moves expired
+ * timers to pending list and wakes up the daemon, so its run time does not
+ * depend on callbacks. Such callbacks run in task context, so they can call
+ * blocking functions (which delays other pending callbacks). In case auto
+ * reload timer expires again before daemon called its callback, callback is
+ * called only once. Keep in mind that callback may be already in flight when
+ * os_timer_destroy() is called from task with priority equal or higher than
+ * daemon.
  */
 
 /** No-Timeout specifier used for semaphores and wait-queues. Use it for
@@ -68,9 +80,19 @@ typedef void (*timer_proc_t)(void *param);
 typedef struct {
    list_t list;               /**< list header used for ordering timers */
    os_ticks_t ticks_rem;      /**< remaining ticks before burn off */
+   os_ticks_t ticks_ext;      /**< ticks remaining after ticks_rem burns off,
+                                   used for cascading of long timeouts */
    os_ticks_t ticks_reload;   /**< reload value in case of auto reload */
+#ifdef OS_CONFIG_TIMERSLACK
+   os_ticks_t slack;          /**< number of ticks the timer may burn off
+                                   after its timeout */
+#endif
    timer_proc_t clbck;        /**< timeout callback function pointer */
    void *param;               /**< parameter for timeout callback */
+#ifdef OS_CONFIG_TIMERDAEMON
+   list_t pending;            /**< list header used for daemon pending list */
+   bool daemon;               /**< callback is called by timer daemon */
+#endif
 #ifdef OS_CONFIG_APICHECK
    uint_fast16_t magic;       /**< timer sanitization canary */
 #endif
@@ -112,7 +134,9 @@ void OS_HOT os_tick(void);
  * @param timer pointer to timer
  * @param clbck timeout callback function which will be called on timeout
  * @param param parameter which will be passed to callback function
- * @param timeout_ticks number of system ticks until timeout
+ * @param timeout_ticks number of system ticks until timeout, must be smaller
+ *        than OS_TICKS_MAX. Timeouts which does not fit into single pass of
+ *        timer list are internally cascaded
  * @param reload_ticks number of system tick which will be used as next timeout
  *        for auto-reload timers. User should use 0 in case of normal and != 0
  *        in case of request for creation of auto-reload timer
@@ -127,6 +151,34 @@ void os_timer_create(
    os_ticks_t timeout_ticks,
    os_ticks_t reload_ticks);
 
+#ifdef OS_CONFIG_TIMERSLACK
+/** Function creates the timer with slack
+ *
+ * Same as os_timer_create(), but timer is allowed to burn off anywhere between
+ * timeout_ticks and timeout_ticks + slack_ticks. The timer is armed for the
+ * end of this window, but it will burn off earlier together with any other
+ * timer which burns off inside of the window. This way timers which do not
+ * require precise timing (like heartbeats) are batched and each of batches
+ * costs only single wakeup. Timer is never called before its timeout. Same
+ * applies to each reload of auto-reload timers.
+ *
+ * @param timer pointer to timer
+ * @param clbck timeout callback function which will be called on timeout
+ * @param param parameter which will be passed to callback function
+ * @param timeout_ticks same as for os_timer_create()
+ * @param reload_ticks same as for os_timer_create()
+ * @param slack_ticks maximal delay of timer expiration which is allowed for
+ *        batching, 0 means the same behaviour as os_timer_create()
+ */
+void os_timer_create_slack(
+   os_timer_t *timer,
+   timer_proc_t clbck,
+   void *param,
+   os_ticks_t timeout_ticks,
+   os_ticks_t reload_ticks,
+   os_ticks_t slack_ticks);
+#endif
+
 /** Function destroys the timer
  *
  * Function stops the timer. Internally, this function removes the timer from
@@ -148,8 +200,9 @@ void os_timer_destroy(os_timer_t *timer);
  *
  * This function may be used to calculate the time difference between two
  * execution points.
- * Range of os_ticks_t is defined by architecture. Its size takes into account
- * the limitation of the CPU word size to minimize the cycle count required for
+ * Range of os_ticks_t is defined by architecture (ARCH_TICKS_WIDTH) and may be
+ * changed by OS_CONFIG_TICKS_WIDTH. Its default size takes into account the
+ * limitation of the CPU word size to minimize the cycle count required for
  * execution of os_tick(). Therefore user should take into account the overflow
  * of system tick counter. For easy calculation of time differences, use
  * os_ticks_diff() which takes the overflow scenario into account. The maximal
@@ -159,9 +212,21 @@ void os_timer_destroy(os_timer_t *timer);
  */
 os_ticks_t os_ticks_now(void);
 
+/** Function return value of monotonic system tick counter extended to 64 bits.
+ *
+ * Unlike os_ticks_now() the returned value does not overflow in any practical
+ * time. On architectures with narrower os_ticks_t the counter is extended by
+ * the number of os_ticks_t overflows, therefore the read is done in critical
+ * section.
+ *
+ * @return current value of 64 bit monotonic system tick counter
+ */
+uint64_t os_ticks_now64(void);
+
 /** Function returns the time interval between two system ticks
  *
- * To get the current value of system tick counter, use the os_ticks_now()
+ * To get the current value of system tick counter, use the os_ticks_now().
+ * Single overflow of the counter between start and end is handled properly.
  *
  * @param ticks_start The system tick counter value at the start of interval
  * @param ticks_now The system tick counter value at the end of interval
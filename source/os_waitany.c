@@ -0,0 +1,264 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "os_private.h"
+
+#ifdef OS_CONFIG_WAITANY
+
+/** Definition of wait set, it is allocated on the stack of os_wait_any() */
+typedef struct os_waitany_tag {
+   /** private task_queue on which the calling task is suspended. It allows to
+    * use the regular blocking code, while task->task_queue allows to find the
+    * wait set from the task (for instance in timer callback) */
+   os_taskqueue_t task_queue;
+
+   /** array of nodes given by user */
+   os_waitnode_t *nodes;
+
+   /** number of nodes */
+   uint_fast8_t cnt;
+
+   /** index of node which was signalized */
+   uint_fast8_t idx;
+
+} os_waitany_t;
+
+/* private function forward declarations */
+static void os_waitany_timerclbck(void *param);
+
+/* --- private functions --- */
+
+/**
+ * Function returns the waitany_list of object referred by node
+ */
+static listprio_t *os_waitany_list(os_waitnode_t *node)
+{
+#ifdef OS_CONFIG_WAITQUEUE
+   if (OS_WAITNODE_WAITQUEUE == node->type)
+      return &(node->queue->waitany_list);
+#endif
+   return &(node->sem->waitany_list);
+}
+
+/**
+ * Function removes all nodes of wait set from objects and wakes up the task
+ * suspended on wait set
+ */
+static void os_waitany_finish(
+   os_waitany_t *set,
+   os_retcode_t block_code)
+{
+   os_task_t *task;
+   uint_fast8_t i;
+
+   for (i = 0; i < set->cnt; i++)
+      list_unlink(&(set->nodes[i].listh.list));
+
+   task = os_taskqueue_dequeue(&(set->task_queue));
+   OS_SELFCHECK_ASSERT(task && (TASKSTATE_WAIT == task->state));
+   task->block_code = block_code;
+   os_task_makeready(task);
+}
+
+/* --- protected functions --- */
+
+/**
+ * Function wakes up the most prioritized task suspended in os_wait_any() on
+ * given object, but only in case it has higher priority than @param task.
+ *
+ * @param list waitany_list of object
+ * @param task most prioritized task suspended on object by regular call (or
+ *        NULL if there is no such task)
+ * @param block_code code which will be returned by os_wait_any()
+ *
+ * @return true in case the task was woken up
+ */
+bool os_waitany_wakeup(
+   listprio_t *list,
+   os_task_t *task,
+   os_retcode_t block_code)
+{
+   list_t *first;
+   os_waitnode_t *node;
+   os_waitany_t *set;
+
+   first = list_peekfirst(&(list->list));
+   if (!first)
+      return false;
+
+   node = os_container_of(first, os_waitnode_t, listh.list);
+   if (task && (node->listh.prio <= task->prio_current))
+      return false;
+
+   set = node->set;
+   set->idx = node - set->nodes;
+
+   /* we need to destroy the timer here, because otherwise it may fire right
+    * after we leave the critical section */
+   os_blocktimer_destroy(os_taskqueue_peek(&(set->task_queue)));
+   os_waitany_finish(set, block_code);
+
+   return true;
+}
+
+/* --- public functions --- */
+/* all public functions are documented in os_waitany.h file */
+
+os_retcode_t OS_WARN_UNUSEDRET os_wait_any(
+   os_waitnode_t *nodes,
+   uint_fast8_t cnt,
+   os_ticks_t timeout_ticks,
+   uint_fast8_t *idx)
+{
+   os_retcode_t ret;
+   os_timer_t timer;
+   os_waitany_t set;
+   arch_criticalstate_t cristate;
+   uint_fast8_t i;
+   bool prepared = false;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current != &task_idle); /* idle task cannot block */
+   OS_ASSERT(cnt > 0);
+   /* calling of blocking function while holding mtx or rwlock will cause
+    * priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   arch_critical_enter(cristate);
+   do {
+#ifdef OS_CONFIG_WAITQUEUE
+      /* check if we were called after os_waitqueue_prepare(), scheduler
+       * may be also locked by the os_scheduler_lock() of the caller */
+      if (waitqueue_prepared) {
+         prepared = true;
+
+         /* prepared wait_queue must be one of the nodes */
+         for (i = 0; i < cnt; i++) {
+            if ((OS_WAITNODE_WAITQUEUE == nodes[i].type) &&
+                (waitqueue_prepared == nodes[i].queue))
+               break;
+         }
+         OS_ASSERT(i < cnt);
+         waitqueue_prepared = NULL;
+
+         /* unlock scheduler without schedule() after that (see
+          * os_waitqueue_wait()) */
+         sched_lock--;
+
+         /* check if we are still in 'prepared' state, if not than it means
+          * that we were woken up by ISR in the mean time */
+         if (!waitqueue_current) {
+            *idx = i;
+            ret = OS_OK;
+            break;
+         }
+         waitqueue_current = NULL;
+      }
+#endif
+
+      /* consume the signal from first semaphore which has any */
+      for (i = 0; i < cnt; i++) {
+         if ((OS_WAITNODE_SEM == nodes[i].type) && (nodes[i].sem->value > 0))
+            break;
+      }
+      if (i < cnt) {
+         --(nodes[i].sem->value);
+         *idx = i;
+         ret = OS_OK;
+         break;
+      }
+
+      if (OS_TIMEOUT_TRY == timeout_ticks) {
+         /* task request to bail out in case operation would block */
+         ret = OS_WOULDBLOCK;
+         break;
+      }
+
+      /* link the nodes to all objects, priority of task_current will not
+       * change while suspended since it does not own any mtx */
+      os_taskqueue_init(&(set.task_queue));
+      set.nodes = nodes;
+      set.cnt = cnt;
+      set.idx = cnt; /* stays out of range in case of timeout */
+      for (i = 0; i < cnt; i++) {
+         nodes[i].set = &set;
+         nodes[i].listh.prio = task_current->prio_current;
+         listprio_append(os_waitany_list(&nodes[i]), &(nodes[i].listh));
+      }
+
+      /* does task request timeout guard for operation? */
+      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+         /* we will get callback to os_waitany_timerclbck() in case of
+          * timeout */
+         os_blocktimer_create(&timer, os_waitany_timerclbck, timeout_ticks);
+      }
+
+      os_task_block_switch(&(set.task_queue), OS_TASKBLOCK_WAITANY);
+
+      /* we return here once any of objects was signalized, destroyed or
+       * timeout burns off. All nodes are already unlinked */
+      os_blocktimer_destroy(task_current);
+
+      ret = task_current->block_code;
+      *idx = set.idx;
+
+   } while (0);
+
+   /* in case we were prepared and did not suspend, ISR may woke up some higher
+    * priority task in the meantime */
+   if (prepared)
+      os_schedule(1);
+
+   arch_critical_exit(cristate);
+
+   return ret;
+}
+
+/**
+ * Function called by timers module. Used for timeout of os_wait_any()
+ * Callback to this function are done from context of timer_trigger().
+ */
+static void os_waitany_timerclbck(void *param)
+{
+   /* single timer has param in os_blocktimer_create() as pointer to task
+    * structure */
+   os_task_t *task = (os_task_t*)param;
+
+   OS_SELFCHECK_ASSERT(TASKSTATE_WAIT == task->state);
+
+   /* unlink nodes and wake up the task, we do not call the os_schedule() here,
+    * because this will be done at the end of timer_trigger() */
+   os_waitany_finish(
+      os_container_of(task->task_queue, os_waitany_t, task_queue), OS_TIMEOUT);
+}
+
+#endif
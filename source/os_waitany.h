@@ -0,0 +1,164 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_WAITANY_
+#define __OS_WAITANY_
+
+#ifdef OS_CONFIG_WAITANY
+
+/**
+ * os_wait_any() allows the task to suspend on multiple semaphores and
+ * wait_queues at once, for instance "data on wait_queue A or command on
+ * semaphore B or timeout". Without it application would have to poll or
+ * dedicate the separate task for each of sources.
+ *
+ * Following template of code is used:
+ * 0: os_waitnode_t nodes[2];
+ *
+ * 1: os_waitnode_sem(&nodes[0], &sem);
+ * 2: os_waitnode_waitqueue(&nodes[1], &waitqueue);
+ * 3: ret = os_wait_any(nodes, 2, timeout, &idx);
+ * 4: if (OS_OK == ret) { ... nodes[idx] was signalized ... }
+ *
+ * os_wait_any() has following characteristics:
+ * - task is linked to each object by separate node (os_waitnode_t) provided by
+ *   caller. Node memory must stay valid until os_wait_any() returns (usually
+ *   it is allocated on the stack of calling task).
+ * - task is woken up by the first signaller. All nodes are removed from other
+ *   objects in the same critical section, so task consumes exactly one signal
+ *   (it never steals the signals from other objects).
+ * - semaphores are checked in the order of nodes before task suspends. First
+ *   semaphore with value > 0 is consumed and os_wait_any() returns
+ *   immediately.
+ * - wait_queues keep their usual semantics, wakeups posted before the task
+ *   suspends are lost. To close the race between condition check and suspend,
+ *   task may call os_waitqueue_prepare() for one of wait_queues (it must be
+ *   referred by one of the nodes) and then call os_wait_any() instead of
+ *   os_waitqueue_wait(). If this wait_queue was signalized in the meantime
+ *   os_wait_any() returns immediately with index of its node.
+ * - for each object, tasks suspended in os_wait_any() and tasks suspended by
+ *   regular calls (os_sem_down(), os_waitqueue_wait()) are woken up in
+ *   priority order (for the same priority tasks suspended by regular calls are
+ *   preferred).
+ */
+
+/** Type of object referred by os_waitnode_t */
+typedef enum {
+   OS_WAITNODE_SEM = 0,    /**< node refers to os_sem_t */
+   OS_WAITNODE_WAITQUEUE   /**< node refers to os_waitqueue_t */
+} os_waitnode_type_t;
+
+/** Definition of node which links the task to single object during
+ * os_wait_any() call */
+typedef struct {
+   /** list link which allows to place the node on object waitany_list, prio
+    * field is used for sorting of suspended tasks */
+   listprio_t listh;
+
+   /** pointer to set of nodes which the node belongs to, valid only during
+    * os_wait_any() call */
+   struct os_waitany_tag *set;
+
+   /** type of object */
+   os_waitnode_type_t type;
+
+   /** object on which task waits */
+   union {
+      os_sem_t *sem;
+#ifdef OS_CONFIG_WAITQUEUE
+      os_waitqueue_t *queue;
+#endif
+   };
+} os_waitnode_t;
+
+/**
+ * Function initializes the node which refers to semaphore
+ *
+ * @param node pointer to node
+ * @param sem pointer to semaphore
+ */
+static inline void os_waitnode_sem(
+   os_waitnode_t *node,
+   os_sem_t *sem)
+{
+   node->type = OS_WAITNODE_SEM;
+   node->sem = sem;
+}
+
+#ifdef OS_CONFIG_WAITQUEUE
+/**
+ * Function initializes the node which refers to wait_queue
+ *
+ * @param node pointer to node
+ * @param queue pointer to wait_queue
+ */
+static inline void os_waitnode_waitqueue(
+   os_waitnode_t *node,
+   os_waitqueue_t *queue)
+{
+   node->type = OS_WAITNODE_WAITQUEUE;
+   node->queue = queue;
+}
+#endif
+
+/**
+ * Function suspends the calling task on all objects given by @param nodes
+ * until first of them will be signalized or until timeout will burn off.
+ *
+ * @param nodes array of nodes initialized by os_waitnode_x() functions
+ * @param cnt number of nodes in @param nodes, must be > 0
+ * @param timeout_ticks number of jiffies (os_tick() call count) before
+ *        operation will time out. OS_TIMEOUT_INFINITE and OS_TIMEOUT_TRY have
+ *        the same meaning as for os_sem_down().
+ * @param idx pointer to variable where the index of signalized node is
+ *        stored. Valid only in case of OS_OK and OS_DESTROYED return codes
+ *
+ * @pre objects must be initialized prior call of this function
+ * @pre this function cannot be used from ISR nor idle task
+ * @pre the same object cannot be referred by more than one node
+ *
+ * @return OS_OK in case one of objects was signalized
+ *         OS_WOULDBLOCK in case none of semaphores contained any signals and
+ *         @param timeout was OS_TIMEOUT_TRY
+ *         OS_TIMEOUT in case operation timeout expired
+ *         OS_DESTROYED in case one of objects was destroyed while calling task
+ *         was suspended
+ * @note user code should always check the return code of os_wait_any()
+ */
+os_retcode_t OS_WARN_UNUSEDRET os_wait_any(
+   os_waitnode_t *nodes,
+   uint_fast8_t cnt,
+   os_ticks_t timeout_ticks,
+   uint_fast8_t *idx);
+
+#endif
+
+#endif
@@ -40,7 +40,16 @@
  */
 os_waitqueue_t *waitqueue_current = NULL;
 
+/** Pointer to wait_queue given to os_waitqueue_prepare(). Unlike
+ * waitqueue_current it is not cleared by wakeup from ISR, so it tells whether
+ * task_current called os_waitqueue_prepare() and which wait_queue it was. It is
+ * cleared by os_waitqueue_break(), os_waitqueue_wait() and os_wait_any() */
+os_waitqueue_t *waitqueue_prepared = NULL;
+
 /* private function forward declarations */
+static os_retcode_t os_waitqueue_wait_internal(
+   os_ticks_t timeout_ticks,
+   bool until);
 static void os_waitqueue_timerclbck(void *param);
 
 /* --- public functions --- */
@@ -52,6 +61,9 @@ void os_waitqueue_create(os_waitqueue_t *queue)
 
    memset(queue, 0, sizeof(os_waitqueue_t));
    os_taskqueue_init(&(queue->task_queue));
+#ifdef OS_CONFIG_WAITANY
+   list_init(&(queue->waitany_list.list));
+#endif
 }
 
 void os_waitqueue_destroy(os_waitqueue_t *queue)
@@ -69,6 +81,10 @@ void os_waitqueue_destroy(os_waitqueue_t *queue)
       task->block_code = OS_DESTROYED;
       os_task_makeready(task);
    }
+#ifdef OS_CONFIG_WAITANY
+   /* the same for tasks suspended in os_wait_any() */
+   while (os_waitany_wakeup(&(queue->waitany_list), NULL, OS_DESTROYED));
+#endif
 
    /* destroy all wait queue data, this can create problems if this wait_queue
     * was also used from interrupt context (feel warned) */
@@ -85,8 +101,10 @@ void os_waitqueue_prepare(os_waitqueue_t *queue)
 {
    OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
    OS_ASSERT(task_current != &task_idle); /* IDLE task cannot block */
-   /* calling of blocking function while holding mtx will cause priority inversion */
+   /* calling of blocking function while holding mtx or rwlock will cause
+    * priority inversion */
    OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
    /* check if task is not already subscribed on other wait_queue
     * currently we do not support waiting on multiple wait queues
     * Warning: only test, due race condition this may not always work */
@@ -94,6 +112,7 @@ void os_waitqueue_prepare(os_waitqueue_t *queue)
 
    /* disable preemption */
    os_scheduler_lock();
+   waitqueue_prepared = queue;
 
    /* mark that we are prepared to suspend on wait_queue
     * some CPU platforms might not have atomic pointer association ops so we use
@@ -106,6 +125,7 @@ void os_waitqueue_break(void)
    OS_ASSERT(0 == isr_nesting); /* cannot call os_waitqueue_finish() from ISR */
 
    os_atomic_store(&waitqueue_current, (os_waitqueue_t*)NULL);
+   waitqueue_prepared = NULL;
    /* unlock scheduler with NOSYNC, means schedule() to higher prio READY task
     * (if pressent) immediately */
    os_scheduler_unlock(false);
@@ -113,51 +133,14 @@ void os_waitqueue_break(void)
 
 os_retcode_t OS_WARN_UNUSEDRET os_waitqueue_wait(os_ticks_t timeout_ticks)
 {
-   os_retcode_t ret;
-   os_timer_t timer;
-   os_waitqueue_t *wait_queue;
-   arch_criticalstate_t cristate;
-
-   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
-   OS_ASSERT(task_current != &task_idle); /* IDLE task cannot block */
    OS_ASSERT(timeout_ticks > OS_TIMEOUT_TRY); /* timeout must be either specific or infinite */
-   /* calling of blocking function while holding mtx will cause priority inversion */
-   OS_ASSERT(list_is_empty(&task_current->mtx_list));
-
-   /* we need to disable the interrupts since wait_queue may be signalized from
-    * ISR (we need to add task to wait_queue->task_queue in atomic manner) there
-    * is no sense to make some critical section optimizations here since this is
-    * slow patch function (task decided to suspend) */
-   arch_critical_enter(cristate);
-
-   /* unlock scheduler without schedule() after that */
-   sched_lock--;
-
-   /* check if we are still in 'prepared' state
-    * if not than it means that we were woken up by ISR in the mean time */
-   if (waitqueue_current) {
-
-      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
-         os_blocktimer_create(&timer, os_waitqueue_timerclbck, timeout_ticks);
-      }
-
-      /* clear global 'prepare' flag since we will switch the context */
-      wait_queue = waitqueue_current;
-      waitqueue_current = NULL;
-      os_task_block_switch(&(wait_queue->task_queue), OS_TASKBLOCK_WAITQUEUE);
-
-      /* cleanup after return, destroy timeout if it was created */
-      os_blocktimer_destroy(task_current);
-   }
-
-   /* the block code is either OS_OK (set in os_waitqueue_wakeup_sync()) or
-    * OS_TIMEOUT (set in os_waitqueue_timerclbck()) or OS_DESTROYED (set in
-    * os_waitqueue_destroy()), we just need to pick it up and return */
-   ret = task_current->block_code;
 
-   arch_critical_exit(cristate);
+   return os_waitqueue_wait_internal(timeout_ticks, false);
+}
 
-   return ret;
+os_retcode_t OS_WARN_UNUSEDRET os_waitqueue_wait_until(os_ticks_t deadline)
+{
+   return os_waitqueue_wait_internal(deadline, true);
 }
 
 void os_waitqueue_wakeup_sync(
@@ -168,6 +151,7 @@ void os_waitqueue_wakeup_sync(
    arch_criticalstate_t cristate;
    os_task_t *task;
    bool awoken = false;
+   bool prepared = false;
 
    /* tasks cannot call any OS functions if they are are 'prepared' to suspend
     * on wait_queue, with exception to ISR's which can interrupt task_current.
@@ -181,40 +165,49 @@ void os_waitqueue_wakeup_sync(
    arch_critical_enter(cristate);
 
    /* check if we are in ISR but we interrupted the task which is prepared to
-    * suspend on the same wait_queue which we will signalize */
-   if ((isr_nesting > 0) && (waitqueue_current == queue)) {
-      /* We are trying to wake up the task_current from ISR.
-       * task_current is in 'prepared' state and it is not pushed to any
-       * task_queue. The only action which we need to do is communicate with
-       * task_current that the suspend on wait_queue should not be done. We will
-       * make this by clearing out the 'prepared' state */
-      waitqueue_current = NULL;
-
-      /* since we theoretically prevented from sleep one task, now we have one
-       * task less to wake up */
-      if (OS_WAITQUEUE_ALL != wakeup_cnt)
-         --wakeup_cnt;
-
-      /* \TODO \FIXME consider that task_current may be less prioritized than
-       * tasks in wait_queue->task_queue, so preventing it from sleep is not
-       * fair in scope of scheduling (to some degree). There may be some more
-       * prioritized task which should be woken up first, while this task maybe
-       * should go to sleep. This is even more important in case parameter
-       * wakeup_cnt = 1.
-       * The most fair approach would be to peek the wait_queue->task_queue and
-       * compare the priorities. In case peeked task would be higher prioritized
-       * then we should allow task_current to suspend on wait_queue->task_queue
-       * and wakeup the most prioritized one */
-   }
+    * suspend on the same wait_queue which we will signalize. In this case
+    * task_current is one of candidates for wakeup, even if it is not pushed to
+    * any task_queue */
+   if ((isr_nesting > 0) && (waitqueue_current == queue))
+      prepared = true;
 
    while ((OS_WAITQUEUE_ALL == wakeup_cnt) || (wakeup_cnt-- > 0)) {
       /* chose most prioritized task from wait_queue->task_queue (for task with
        * equal priority threat them in FIFO manner) */
-      task = os_taskqueue_dequeue(&(queue->task_queue));
+      task = os_taskqueue_peek(&(queue->task_queue));
+
+      /* To be fair in scope of scheduling, task_current which is in 'prepared'
+       * state competes with suspended tasks by its priority. In case there is
+       * a suspended task with higher priority we wake it up first, while
+       * task_current remains 'prepared' and will suspend in
+       * os_waitqueue_wait(). For equal priorities we prefer task_current since
+       * this saves the context switch */
+      if (prepared &&
+          (!task || (task->prio_current <= task_current->prio_current)))
+         task = task_current;
+#ifdef OS_CONFIG_WAITANY
+      /* tasks suspended in os_wait_any() compete with tasks from task_queue */
+      if (os_waitany_wakeup(&(queue->waitany_list), task, OS_OK)) {
+         awoken = true;
+         continue;
+      }
+#endif
       if (!task) {
          /* there will be no more task to wake up, stop spinning */
          break;
       }
+      if (task == task_current) {
+         /* task_current is not pushed to any task_queue. The only action which
+          * we need to do is communicate with task_current that the suspend on
+          * wait_queue should not be done. We will make this by clearing out
+          * the 'prepared' state. block_code may still hold the result of
+          * previous block, so set it as for any other awoken task */
+         waitqueue_current = NULL;
+         task_current->block_code = OS_OK;
+         prepared = false;
+         continue;
+      }
+      os_taskqueue_unlink(task);
 
       /* we need to destroy the timer here, because otherwise it may fire right
        * after we leave the critical section */
@@ -241,6 +234,76 @@ void os_waitqueue_wakeup_sync(
 
 /* --- private functions --- */
 
+/**
+ * Common implementation of os_waitqueue_wait() and os_waitqueue_wait_until().
+ * If until is true, the timeout_ticks is an absolute deadline.
+ */
+static os_retcode_t os_waitqueue_wait_internal(
+   os_ticks_t timeout_ticks,
+   bool until)
+{
+   os_retcode_t ret;
+   os_timer_t timer;
+   os_waitqueue_t *wait_queue;
+   arch_criticalstate_t cristate;
+
+   OS_ASSERT(0 == isr_nesting); /* cannot call from ISR */
+   OS_ASSERT(task_current != &task_idle); /* IDLE task cannot block */
+   /* calling of blocking function while holding mtx or rwlock will cause
+    * priority inversion */
+   OS_ASSERT(list_is_empty(&task_current->mtx_list));
+   OS_ASSERT(list_is_empty(&task_current->rwlock_list));
+
+   /* we need to disable the interrupts since wait_queue may be signalized from
+    * ISR (we need to add task to wait_queue->task_queue in atomic manner) there
+    * is no sense to make some critical section optimizations here since this is
+    * slow patch function (task decided to suspend) */
+   arch_critical_enter(cristate);
+
+   /* unlock scheduler without schedule() after that */
+   OS_ASSERT(waitqueue_prepared); /* os_waitqueue_prepare() must be called */
+   waitqueue_prepared = NULL;
+   sched_lock--;
+
+   /* check if we are still in 'prepared' state
+    * if not than it means that we were woken up by ISR in the mean time */
+   if (waitqueue_current && until) {
+      /* convert the deadline in the same critical section in which we arm the
+       * timer, so the release happens exactly at deadline tick */
+      timeout_ticks = os_ticks_until(timeout_ticks);
+      if (0 == timeout_ticks) {
+         /* deadline already passed, leave the 'prepared' state without
+          * suspending */
+         waitqueue_current = NULL;
+         task_current->block_code = OS_TIMEOUT;
+      }
+   }
+
+   if (waitqueue_current) {
+
+      if (OS_TIMEOUT_INFINITE != timeout_ticks) {
+         os_blocktimer_create(&timer, os_waitqueue_timerclbck, timeout_ticks);
+      }
+
+      /* clear global 'prepare' flag since we will switch the context */
+      wait_queue = waitqueue_current;
+      waitqueue_current = NULL;
+      os_task_block_switch(&(wait_queue->task_queue), OS_TASKBLOCK_WAITQUEUE);
+
+      /* cleanup after return, destroy timeout if it was created */
+      os_blocktimer_destroy(task_current);
+   }
+
+   /* the block code is either OS_OK (set in os_waitqueue_wakeup_sync()) or
+    * OS_TIMEOUT (set in os_waitqueue_timerclbck()) or OS_DESTROYED (set in
+    * os_waitqueue_destroy()), we just need to pick it up and return */
+   ret = task_current->block_code;
+
+   arch_critical_exit(cristate);
+
+   return ret;
+}
+
 /**
  * Function called by timers module. Used for timeout of os_waitqueue_wait()
  * Callback to this function are done from context of timer_trigger().
@@ -97,6 +97,11 @@
  *   cause preemption to higher prio task. Instead higher prio task will be
  *   executed only after task_current call os_waitqueue_wait() or
  *   os_waitqueue_break()
+ * - if ISR signalizes the wait_queue on which task_current is prepared to
+ *   suspend, task_current competes with already suspended tasks by its
+ *   priority. Suspended tasks with higher priority are woken up first, in such
+ *   case task_current will still suspend in os_waitqueue_wait() if wakeup
+ *   count was exhausted.
  * - the notifier wakeups all suspended tasks before allowing for schedule().
  *   As opposite to semaphore usage this guaranties that suspended tasks will be
  *   scheduled() exactly once per each suspend-wakeup pair. (For semaphores if
@@ -132,6 +137,12 @@ typedef struct os_waitqueue_tag {
    /** Queue of tasks suspended on this wait_queue. */
    os_taskqueue_t task_queue;
 
+#ifdef OS_CONFIG_WAITANY
+   /** list of os_wait_any() nodes suspended on this wait_queue, sorted by
+    * priority of tasks */
+   listprio_t waitany_list;
+#endif
+
 } os_waitqueue_t;
 
 /**
@@ -248,6 +259,25 @@ void os_waitqueue_break(void);
  */
 os_retcode_t OS_WARN_UNUSEDRET os_waitqueue_wait(os_ticks_t timeout_ticks);
 
+/**
+ * Function works as os_waitqueue_wait() but timeout is given as absolute
+ * deadline (value of os_ticks_now()) instead of relative number of ticks.
+ * Intended for loops which re-check the condition after spurious wakeup, since
+ * there is no need to recalculate the remaining time.
+ *
+ * @param deadline value of system tick counter at which operation will time
+ *        out. In case deadline was already reached (or it is more than half of
+ *        os_ticks_t range ahead) function leaves the 'prepared' state and
+ *        returns OS_TIMEOUT without suspending.
+ *
+ * @pre same as for os_waitqueue_wait()
+ *
+ * @post same as for os_waitqueue_wait()
+ *
+ * @return same as for os_waitqueue_wait()
+ */
+os_retcode_t OS_WARN_UNUSEDRET os_waitqueue_wait_until(os_ticks_t deadline);
+
 /**
  * Function wakes up tasks suspended on wait_queue.
  *
@@ -0,0 +1,201 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test of task execution budgets
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_RUNTICKS ((os_ticks_t)100)
+#define TEST_PERIOD ((os_ticks_t)10)
+
+static os_task_t task_coordinator;
+static os_task_t task_hog;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK hog_stack[OS_STACK_MINSIZE];
+
+static os_mtx_t test_mtx;
+static volatile bool test_stop;
+static volatile bool test_exited;
+static volatile bool test_unlocked;
+static volatile os_ticks_t hog_ticks;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Task which never blocks. Ticks are generated only by running task, so each
+ * tick generated by this task is charged to its budget
+ */
+static int hog_proc(void *OS_UNUSED(param))
+{
+   while (!test_stop) {
+      test_reqtick();
+      ++hog_ticks;
+   }
+   test_exited = true;
+   return 0;
+}
+
+/**
+ * Same as hog_proc(), but it holds the mutex for more ticks than its budget
+ */
+static int hog_mtx_proc(void *param)
+{
+   os_ticks_t i;
+
+   test_assert(OS_OK == os_mtx_lock(&test_mtx));
+   for (i = 0; i < (os_ticks_t)(uintptr_t)param; i++) {
+      test_reqtick();
+      ++hog_ticks;
+   }
+   test_unlocked = true;
+   os_mtx_unlock(&test_mtx);
+
+   return hog_proc(NULL);
+}
+
+static void test_hog_start(
+   os_taskproc_t proc,
+   void *param,
+   os_ticks_t budget,
+   uint_fast8_t bg_prio)
+{
+   hog_ticks = 0;
+   test_stop = false;
+   test_exited = false;
+   os_scheduler_lock();
+   os_task_create(
+      &task_hog, OS_CONFIG_PRIOCNT - 1, hog_stack, sizeof(hog_stack),
+      proc, param);
+   os_task_budget_set(&task_hog, budget, TEST_PERIOD, bg_prio);
+   os_scheduler_unlock(false);
+}
+
+static void test_hog_stop(void)
+{
+   test_stop = true;
+   /* suspended task needs ticks for replenishment */
+   while (!test_exited)
+      test_reqtick();
+   os_task_join(&task_hog);
+}
+
+/**
+ * Test coordinator, runs all test in unit. It runs below the hog priority,
+ * without budgets it would never run
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   os_ticks_t start;
+
+/* scenario 1 */
+   /* task is suspended after it consumes its budget, coordinator gets the rest
+    * of each period */
+   test_hog_start(hog_proc, NULL, 2, 0);
+   start = os_ticks_now();
+   while (os_ticks_diff(start, os_ticks_now()) < TEST_RUNTICKS)
+      test_reqtick();
+   test_assert(hog_ticks >= 18);
+   test_assert(hog_ticks <= 22);
+   test_hog_stop();
+
+/* scenario 2 */
+   /* task is demoted below coordinator after it consumes its budget */
+   test_hog_start(hog_proc, NULL, 3, 1);
+   start = os_ticks_now();
+   while (os_ticks_diff(start, os_ticks_now()) < TEST_RUNTICKS)
+      test_reqtick();
+   test_assert(hog_ticks >= 28);
+   test_assert(hog_ticks <= 33);
+
+   /* demoted task still runs in background, and its priority is restored
+    * at replenishment, so it does not lose any throughput */
+   hog_ticks = 0;
+   os_task_sleep(TEST_RUNTICKS);
+   test_assert(hog_ticks >= TEST_RUNTICKS - 1);
+   test_hog_stop();
+
+/* scenario 3 */
+   /* removing the budget wakes up the suspended task, which then preempts the
+    * coordinator */
+   test_hog_start(hog_proc, NULL, 2, 0);
+   test_assert(2 == task_hog.budget);
+   test_assert(TASKSTATE_WAIT == task_hog.state);
+   test_stop = true;
+   os_task_budget_set(&task_hog, 0, 0, 0);
+   test_assert(test_exited);
+   test_assert(2 == hog_ticks);
+   os_task_join(&task_hog);
+
+/* scenario 4 */
+   /* owner of mutex is not suspended, it overruns the budget until it unlocks
+    * the mutex, so coordinator is not blocked until replenishment */
+   os_mtx_create(&test_mtx);
+   test_unlocked = false;
+   test_hog_start(hog_mtx_proc, (void*)(uintptr_t)5, 2, 0);
+   test_assert(test_unlocked);
+   test_assert(5 == hog_ticks);
+   test_assert(OS_OK == os_mtx_lock(&test_mtx));
+   os_mtx_unlock(&test_mtx);
+   test_hog_stop();
+   os_mtx_destroy(&test_mtx);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 2,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Budget");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
@@ -0,0 +1,390 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os buffer routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <time.h>
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_BUFS ((size_t)16)
+#define TEST_PAYLOAD ((size_t)1024)
+#define TEST_QUEUE ((size_t)4)
+#define TEST_BENCH_PKTS ((unsigned long)20000)
+#define TEST_BENCH_LEN ((size_t)512)
+#define TEST_HDR_SRC ((size_t)4)
+#define TEST_HDR_PROTO ((size_t)8)
+
+/** simple single producer single consumer queue of pointers */
+typedef struct {
+   os_sem_t items;
+   os_sem_t slots;
+   void *ring[TEST_QUEUE];
+   size_t in;
+   size_t out;
+} test_queue_t;
+
+static os_task_t task_worker[4];
+static OS_TASKSTACK task_stack[4][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_pool_t test_pool;
+static uint8_t test_mem[TEST_BUFS][OS_BUF_BLOCKSIZE(TEST_PAYLOAD)]
+   __attribute__ ((aligned(sizeof(void*))));
+static test_queue_t test_queue[3];
+static bool test_bench_copy;
+static unsigned long test_bench_copied;
+static unsigned long test_bench_rcv;
+static os_buf_t *volatile isr_unref_buf;
+static volatile sig_atomic_t isr_alloc_req;
+static os_buf_t *volatile isr_alloc_buf;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+static void test_queue_create(test_queue_t *queue)
+{
+   os_sem_create(&(queue->items), 0);
+   os_sem_create(&(queue->slots), TEST_QUEUE);
+   queue->in = 0;
+   queue->out = 0;
+}
+
+static void test_queue_destroy(test_queue_t *queue)
+{
+   os_sem_destroy(&(queue->items));
+   os_sem_destroy(&(queue->slots));
+}
+
+static void test_queue_put(test_queue_t *queue, void *ptr)
+{
+   os_retcode_t ret;
+
+   ret = os_sem_down(&(queue->slots), OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+   queue->ring[queue->in++ % TEST_QUEUE] = ptr;
+   os_sem_up(&(queue->items));
+}
+
+static void *test_queue_get(test_queue_t *queue)
+{
+   os_retcode_t ret;
+   void *ptr;
+
+   ret = os_sem_down(&(queue->items), OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+   ptr = queue->ring[queue->out++ % TEST_QUEUE];
+   os_sem_up(&(queue->slots));
+
+   return ptr;
+}
+
+/**
+ * Function returns number of free blocks in pool
+ */
+static size_t test_pool_free(void)
+{
+   void *block[TEST_BUFS];
+   size_t cnt = 0;
+   size_t i;
+
+   while ((cnt < TEST_BUFS) && (block[cnt] = os_pool_alloc(&test_pool)))
+      ++cnt;
+   for (i = 0; i < cnt; i++)
+      os_pool_free(&test_pool, block[i]);
+
+   return cnt;
+}
+
+/**
+ * Tick callback, releases and allocates buffers from ISR on request
+ */
+static void test_tick(void)
+{
+   os_buf_t *buf;
+
+   if (isr_unref_buf) {
+      os_buf_unref(isr_unref_buf);
+      isr_unref_buf = NULL;
+   }
+   if (isr_alloc_req) {
+      isr_alloc_req = 0;
+      buf = os_buf_alloc(&test_pool, TEST_HDR_SRC);
+      if (buf)
+         *os_buf_put(buf, 1) = 0xAA;
+      isr_alloc_buf = buf;
+   }
+}
+
+/**
+ * Pipeline stage helper, in copy mode it simulates the usual approach where
+ * each stage copies the payload into its own buffer
+ */
+static os_buf_t *test_bench_copy_stage(os_buf_t *buf, size_t headroom)
+{
+   os_buf_t *copy;
+
+   if (!test_bench_copy)
+      return buf;
+
+   copy = os_buf_alloc_wait(&test_pool, headroom, OS_TIMEOUT_INFINITE);
+   test_assert(copy);
+   memcpy(os_buf_put(copy, buf->len), os_buf_data(buf), buf->len);
+   test_bench_copied += buf->len;
+   os_buf_unref(buf);
+
+   return copy;
+}
+
+/**
+ * Test scenario:
+ * Pipeline source -> parser -> protocol -> logger. Source creates packets with
+ * own header, parser strips it, protocol prepends its own header and logger
+ * verifies and releases the packets. In zero-copy mode the same buffer is
+ * passed by pointer through all stages.
+ */
+int test_bench_source(void *OS_UNUSED(param))
+{
+   os_buf_t *buf;
+   unsigned long i;
+
+   for (i = 0; i < TEST_BENCH_PKTS; i++) {
+      buf = os_buf_alloc_wait(&test_pool, TEST_HDR_SRC + TEST_HDR_PROTO,
+                              OS_TIMEOUT_INFINITE);
+      test_assert(buf);
+      memset(os_buf_put(buf, TEST_BENCH_LEN), (uint8_t)i, TEST_BENCH_LEN);
+      memcpy(os_buf_push(buf, TEST_HDR_SRC), &i, TEST_HDR_SRC);
+      test_queue_put(&test_queue[0], buf);
+   }
+   test_queue_put(&test_queue[0], NULL);
+
+   return 0;
+}
+
+int test_bench_parser(void *OS_UNUSED(param))
+{
+   os_buf_t *buf;
+
+   while ((buf = (os_buf_t*)test_queue_get(&test_queue[0]))) {
+      buf = test_bench_copy_stage(buf, TEST_HDR_SRC + TEST_HDR_PROTO);
+      os_buf_pull(buf, TEST_HDR_SRC);
+      test_queue_put(&test_queue[1], buf);
+   }
+   test_queue_put(&test_queue[1], NULL);
+
+   return 0;
+}
+
+int test_bench_protocol(void *OS_UNUSED(param))
+{
+   os_buf_t *buf;
+
+   while ((buf = (os_buf_t*)test_queue_get(&test_queue[1]))) {
+      buf = test_bench_copy_stage(buf, TEST_HDR_PROTO);
+      memset(os_buf_push(buf, TEST_HDR_PROTO), 0x55, TEST_HDR_PROTO);
+      test_queue_put(&test_queue[2], buf);
+   }
+   test_queue_put(&test_queue[2], NULL);
+
+   return 0;
+}
+
+int test_bench_logger(void *OS_UNUSED(param))
+{
+   os_buf_t *buf;
+   uint8_t *data;
+
+   while ((buf = (os_buf_t*)test_queue_get(&test_queue[2]))) {
+      buf = test_bench_copy_stage(buf, 0);
+      test_assert(TEST_HDR_PROTO + TEST_BENCH_LEN == buf->len);
+      data = os_buf_data(buf);
+      test_assert(0x55 == data[0]);
+      test_assert((uint8_t)test_bench_rcv == data[buf->len - 1]);
+      ++test_bench_rcv;
+      os_buf_unref(buf);
+   }
+
+   return 0;
+}
+
+static unsigned long test_nsec(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static void test_bench_run(bool copy)
+{
+   const os_taskproc_t proc[] = {
+      test_bench_source, test_bench_parser,
+      test_bench_protocol, test_bench_logger };
+   unsigned long t_start;
+   size_t i;
+
+   test_bench_copy = copy;
+   test_bench_copied = 0;
+   test_bench_rcv = 0;
+   for (i = 0; i < 3; i++)
+      test_queue_create(&test_queue[i]);
+
+   t_start = test_nsec();
+   for (i = 0; i < 4; i++) {
+      os_task_create(
+         &task_worker[i], 1,
+         task_stack[i], sizeof(task_stack[i]),
+         proc[i], NULL);
+   }
+   for (i = 0; i < 4; i++)
+      os_task_join(&task_worker[i]);
+
+   test_debug("%s: %lu packets, %lu us, %lu bytes copied",
+              copy ? "copy" : "zero-copy", test_bench_rcv,
+              (test_nsec() - t_start) / 1000, test_bench_copied);
+   test_assert(TEST_BENCH_PKTS == test_bench_rcv);
+   test_assert(TEST_BUFS == test_pool_free());
+
+   for (i = 0; i < 3; i++)
+      test_queue_destroy(&test_queue[i]);
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   os_buf_t *buf[3];
+   uint8_t data[8];
+   uint8_t *p;
+   size_t i;
+
+   os_pool_create(&test_pool, test_mem, sizeof(test_mem[0]), TEST_BUFS);
+
+/* scenario 1 */
+   /* headroom, push, pull, put and trim */
+   buf[0] = os_buf_alloc(&test_pool, 16);
+   test_assert(buf[0]);
+   test_assert(1 == buf[0]->refcnt);
+   test_assert(TEST_PAYLOAD <= buf[0]->size);
+   test_assert(16 == os_buf_headroom(buf[0]));
+   test_assert(buf[0]->size - 16 == os_buf_tailroom(buf[0]));
+   p = os_buf_put(buf[0], 4);
+   test_assert(p == os_buf_data(buf[0]));
+   memcpy(p, "\x01\x02\x03\x04", 4);
+   p = os_buf_push(buf[0], 2);
+   test_assert(14 == os_buf_headroom(buf[0]));
+   test_assert(6 == buf[0]->len);
+   memcpy(p, "\xA1\xA2", 2);
+   test_assert(p + 2 == os_buf_pull(buf[0], 2));
+   test_assert(0x01 == os_buf_data(buf[0])[0]);
+   os_buf_trim(buf[0], 3);
+   test_assert(3 == os_buf_chain_len(buf[0]));
+   os_buf_unref(buf[0]);
+   test_assert(TEST_BUFS == test_pool_free());
+
+/* scenario 2 */
+   /* chains and reference counting */
+   for (i = 0; i < 3; i++) {
+      buf[i] = os_buf_alloc_wait(&test_pool, 0, OS_TIMEOUT_TRY);
+      test_assert(buf[i]);
+      memset(os_buf_put(buf[i], 3), '0' + i, 3);
+   }
+   os_buf_chain(buf[0], buf[1]);
+   os_buf_chain(buf[0], buf[2]);
+   test_assert(9 == os_buf_chain_len(buf[0]));
+   test_assert(6 == os_buf_chain_len(buf[1]));
+   test_assert(5 == os_buf_copyout(buf[0], 2, data, 5));
+   test_assert(0 == memcmp(data, "01112", 5));
+   test_assert(2 == os_buf_copyout(buf[0], 7, data, sizeof(data)));
+   /* tail of chain is referenced also from elsewhere */
+   os_buf_ref(buf[2]);
+   os_buf_unref(buf[0]);
+   test_assert(TEST_BUFS - 1 == test_pool_free());
+   test_assert(1 == buf[2]->refcnt);
+   os_buf_unref(buf[2]);
+   test_assert(TEST_BUFS == test_pool_free());
+
+/* scenario 3 */
+   /* release and allocation from ISR */
+   test_setuptick(test_tick, 0);
+   buf[0] = os_buf_alloc(&test_pool, 0);
+   os_buf_ref(buf[0]);
+   isr_unref_buf = buf[0];
+   test_reqtick();
+   test_assert(NULL == isr_unref_buf);
+   test_assert(TEST_BUFS - 1 == test_pool_free());
+   isr_unref_buf = buf[0];
+   test_reqtick();
+   test_assert(TEST_BUFS == test_pool_free());
+   isr_alloc_req = 1;
+   test_reqtick();
+   test_assert(isr_alloc_buf);
+   test_assert(0xAA == os_buf_data(isr_alloc_buf)[0]);
+   os_buf_unref(isr_alloc_buf);
+   test_assert(TEST_BUFS == test_pool_free());
+
+/* scenario 4 */
+   test_bench_run(true);
+   test_bench_run(false);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Buf");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
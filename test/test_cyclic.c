@@ -0,0 +1,202 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test of cyclic executive
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_TASKCNT ((size_t)3)
+#define TEST_HYPERPERIOD ((os_ticks_t)10)
+#define TEST_RUNTICKS (4 * TEST_HYPERPERIOD)
+#define TEST_LONGJOB ((os_ticks_t)12)
+#define TEST_RELEASEMAX ((size_t)16)
+
+typedef struct {
+   os_ticks_t period;   /**< distance between releases in table */
+   os_ticks_t offset;   /**< offset of first release in table */
+   bool longjob;        /**< first job overruns the next release */
+   size_t releases;     /**< number of releases */
+   os_ticks_t release[TEST_RELEASEMAX]; /**< ticks of releases */
+} test_cyclic_t;
+
+static os_task_t task_coordinator;
+static os_task_t task_worker[TEST_TASKCNT];
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK worker_stack[TEST_TASKCNT][OS_STACK_MINSIZE];
+
+static test_cyclic_t test_job[TEST_TASKCNT] = {
+   { .period = 5, .offset = 0 },
+   { .period = 10, .offset = 3 },
+   { .period = 10, .offset = 7, .longjob = true },
+};
+
+static const os_cyclic_entry_t test_table[] = {
+   { .offset = 0, .task = &task_worker[0] },
+   { .offset = 3, .task = &task_worker[1] },
+   { .offset = 5, .task = &task_worker[0] },
+   { .offset = 7, .task = &task_worker[2] },
+};
+
+static const os_cyclic_entry_t test_table_short[] = {
+   { .offset = 0, .task = &task_worker[0] },
+};
+
+static os_ticks_t test_start;
+static unsigned test_overruns;
+static os_task_t *test_overrun_task;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+static void test_overrun(os_task_t *task)
+{
+   ++test_overruns;
+   test_overrun_task = task;
+}
+
+/**
+ * Task released by cyclic table. Ticks are generated only by running task, so
+ * the tick counter read right after the release gives the exact release time
+ */
+static int worker_proc(void *param)
+{
+   test_cyclic_t *job = (test_cyclic_t*)param;
+   os_ticks_t i;
+
+   while (OS_OK == os_cyclic_wait()) {
+      test_assert(job->releases < TEST_RELEASEMAX);
+      /* first offset is released at first tick after os_cyclic_start() */
+      job->release[job->releases++] =
+         os_ticks_diff(test_start, os_ticks_now()) - 1;
+      if (job->longjob && (1 == job->releases)) {
+         for (i = 0; i < TEST_LONGJOB; i++)
+            test_reqtick();
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit. It runs with lower priority than
+ * workers and generates the ticks while workers wait for release
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   size_t i, j;
+
+/* scenario 1 */
+   /* wait without running table does not suspend the task */
+   test_assert(OS_DESTROYED == os_cyclic_wait());
+
+/* scenario 2 */
+   /* jobs are released exactly at their offsets in each hyperperiod, first
+    * long job misses its next release */
+   test_start = os_ticks_now();
+   os_cyclic_start(
+      test_table, sizeof(test_table) / sizeof(test_table[0]),
+      TEST_HYPERPERIOD, test_overrun);
+   /* workers preempt the coordinator and wait for release, first release is
+    * at the next tick */
+   for (i = 0; i < TEST_TASKCNT; i++) {
+      os_task_create(
+         &task_worker[i], 3, worker_stack[i], sizeof(worker_stack[i]),
+         worker_proc, &test_job[i]);
+      test_assert(TASKSTATE_WAIT == task_worker[i].state);
+   }
+   while (os_ticks_diff(test_start, os_ticks_now()) < TEST_RUNTICKS)
+      test_reqtick();
+
+   for (i = 0; i < TEST_TASKCNT; i++) {
+      for (j = 0; j < test_job[i].releases; j++) {
+         test_assert(test_job[i].offset ==
+                     (test_job[i].release[j] % test_job[i].period));
+      }
+   }
+   test_assert(test_job[0].releases >= (TEST_RUNTICKS / 5) - 1);
+   test_assert(test_job[1].releases >= (TEST_RUNTICKS / 10) - 1);
+   /* release at offset 7 of second hyperperiod is skipped */
+   test_assert(1 == test_overruns);
+   test_assert(&task_worker[2] == test_overrun_task);
+   test_assert(test_job[2].releases >= (TEST_RUNTICKS / 10) - 2);
+   test_assert(17 != test_job[2].release[1]);
+
+/* scenario 3 */
+   /* replacement of the table wakes up waiting tasks which are not in new
+    * table, the rest is released from new table */
+   j = test_job[0].releases;
+   test_start = os_ticks_now();
+   os_cyclic_start(
+      test_table_short, sizeof(test_table_short) / sizeof(test_table_short[0]),
+      TEST_HYPERPERIOD / 2, NULL);
+   os_task_join(&task_worker[1]);
+   os_task_join(&task_worker[2]);
+   test_assert(TASKSTATE_WAIT == task_worker[0].state);
+   while (os_ticks_diff(test_start, os_ticks_now()) < TEST_HYPERPERIOD)
+      test_reqtick();
+   test_assert(j + 2 == test_job[0].releases);
+
+/* scenario 4 */
+   /* stop of the table wakes up waiting tasks */
+   os_cyclic_stop();
+   os_task_join(&task_worker[0]);
+   test_assert(OS_DESTROYED == os_cyclic_wait());
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, 1, coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Cyclic");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
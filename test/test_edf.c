@@ -0,0 +1,239 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test of earliest deadline first scheduling band
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_TASKCNT ((size_t)3)
+#define TEST_HYPERPERIOD ((os_ticks_t)60)
+#define TEST_RUNTICKS (10 * TEST_HYPERPERIOD)
+
+typedef struct {
+   os_ticks_t wcet;     /**< execution time of each job in ticks */
+   os_ticks_t period;   /**< period and relative deadline */
+   unsigned jobs;       /**< number of finished jobs */
+   char id;             /**< identifier used in order checks */
+} test_edf_t;
+
+static os_task_t task_coordinator;
+static os_task_t task_worker[TEST_TASKCNT];
+static os_task_t task_hi;
+static os_task_t task_lo;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK worker_stack[TEST_TASKCNT][OS_STACK_MINSIZE];
+static OS_TASKSTACK hi_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK lo_stack[OS_STACK_MINSIZE];
+
+/* utilization 1/3 + 2/10 + 5/12 = 95%, this set is not schedulable by rate
+ * monotonic priorities (last task would miss its deadline) */
+static test_edf_t test_set[TEST_TASKCNT] = {
+   { .wcet = 1, .period = 3, .id = 'a' },
+   { .wcet = 2, .period = 10, .id = 'b' },
+   { .wcet = 5, .period = 12, .id = 'c' },
+};
+
+static os_sem_t test_sem;
+static volatile bool test_stop;
+static volatile unsigned test_exited;
+static char test_order[8];
+static unsigned test_order_idx;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+static void test_record(char id)
+{
+   test_assert(test_order_idx < sizeof(test_order));
+   test_order[test_order_idx++] = id;
+}
+
+/**
+ * Periodic EDF task, each job consumes wcet ticks of CPU. Ticks are generated
+ * only by running task, so tick counter advances only while task executes
+ * (coordinator generates the ticks while all EDF tasks wait, which emulates
+ * the idle time)
+ */
+static int edf_periodic(void *param)
+{
+   test_edf_t *edf = (test_edf_t*)param;
+   os_ticks_t i;
+
+   os_task_periodic_init(edf->period);
+   while (!test_stop) {
+      for (i = 0; i < edf->wcet; i++)
+         test_reqtick();
+
+      /* job has to finish before its deadline */
+      test_assert(os_ticks_diff(os_ticks_now(), task_current->edf_deadline) <=
+                  (OS_TICKS_MAX / 2));
+      ++(edf->jobs);
+
+      /* no release can be missed */
+      test_assert(0 == os_task_wait_next_period());
+   }
+
+   ++test_exited;
+   return 0;
+}
+
+/**
+ * EDF task which waits on semaphore
+ */
+static int edf_waiter(void *param)
+{
+   test_assert(OS_OK == os_sem_down(&test_sem, OS_TIMEOUT_INFINITE));
+   test_record(*(char*)param);
+   return 0;
+}
+
+static int regular_proc(void *param)
+{
+   test_record(*(char*)param);
+   return 0;
+}
+
+/**
+ * EDF task which creates the regular tasks above and below the band
+ */
+static int edf_creator(void *OS_UNUSED(param))
+{
+   static char id_hi = 'H';
+   static char id_lo = 'L';
+
+   os_task_create(
+      &task_hi, OS_CONFIG_EDF_PRIO + 1, hi_stack, sizeof(hi_stack),
+      regular_proc, &id_hi);
+   test_record('E');
+   os_task_create(
+      &task_lo, OS_CONFIG_EDF_PRIO - 1, lo_stack, sizeof(lo_stack),
+      regular_proc, &id_lo);
+   test_record('E');
+   return 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit. It runs below the EDF band
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   static char ids[TEST_TASKCNT] = { 'x', 'y', 'z' };
+   os_ticks_t start;
+   size_t i;
+
+   os_sem_create(&test_sem, 0);
+
+/* scenario 1 */
+   /* task set with 95% utilization meets all deadlines */
+   os_scheduler_lock();
+   for (i = 0; i < TEST_TASKCNT; i++) {
+      os_task_create_edf(
+         &task_worker[i], worker_stack[i], sizeof(worker_stack[i]),
+         edf_periodic, &test_set[i], test_set[i].period);
+   }
+   os_scheduler_unlock(false);
+
+   /* coordinator runs only in idle time */
+   start = os_ticks_now();
+   while (os_ticks_diff(start, os_ticks_now()) < TEST_RUNTICKS)
+      test_reqtick();
+
+   test_stop = true;
+   while (test_exited < TEST_TASKCNT)
+      test_reqtick();
+   for (i = 0; i < TEST_TASKCNT; i++) {
+      os_task_join(&task_worker[i]);
+      test_assert(test_set[i].jobs >= (TEST_RUNTICKS / test_set[i].period));
+   }
+
+/* scenario 2 */
+   /* EDF tasks suspended on semaphore are woken up in deadline order */
+   test_order_idx = 0;
+   os_task_create_edf(
+      &task_worker[0], worker_stack[0], sizeof(worker_stack[0]),
+      edf_waiter, &ids[2], 30);
+   os_task_create_edf(
+      &task_worker[1], worker_stack[1], sizeof(worker_stack[1]),
+      edf_waiter, &ids[0], 10);
+   os_task_create_edf(
+      &task_worker[2], worker_stack[2], sizeof(worker_stack[2]),
+      edf_waiter, &ids[1], 20);
+   for (i = 0; i < TEST_TASKCNT; i++)
+      os_sem_up(&test_sem);
+   for (i = 0; i < TEST_TASKCNT; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(0 == memcmp(test_order, "xyz", 3));
+
+/* scenario 3 */
+   /* regular tasks above the band preempt EDF tasks, tasks below the band
+    * wait until band is empty */
+   test_order_idx = 0;
+   os_task_create_edf(
+      &task_worker[0], worker_stack[0], sizeof(worker_stack[0]),
+      edf_creator, NULL, 5);
+   os_task_join(&task_worker[0]);
+   os_task_join(&task_hi);
+   os_task_join(&task_lo);
+   test_assert(0 == memcmp(test_order, "HEEL", 4));
+
+   os_sem_destroy(&test_sem);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_EDF_PRIO - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Edf");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
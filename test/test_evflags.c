@@ -0,0 +1,257 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os event flags routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+static os_task_t task_worker[5];
+static OS_TASKSTACK task_stack[5][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_evflags_t test_evflags;
+static volatile sig_atomic_t test_wakeups[5];
+static volatile sig_atomic_t isr_set;
+
+typedef struct {
+   uint32_t mask;
+   uint_fast8_t opt;
+   uint32_t expected;
+   os_retcode_t ret;
+} test_waitparam_t;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Tick callback, sets the flags from ISR on request
+ */
+static void test_tick(void)
+{
+   if (isr_set) {
+      isr_set = 0;
+      (void)os_evflags_set(&test_evflags, 0x80);
+   }
+}
+
+/**
+ * Waiter task used by scenarios 2 and 3, suspends single time with wait
+ * condition given in parameter and counts the wakeups
+ */
+int test_waiter(void *param)
+{
+   os_retcode_t ret;
+   uint32_t flags;
+   const test_waitparam_t *p = (const test_waitparam_t*)param;
+
+   ret = os_evflags_wait(&test_evflags, p->mask, p->opt,
+                         OS_TIMEOUT_INFINITE, &flags);
+   test_assert(p->ret == ret);
+   if (OS_OK == ret)
+      test_assert(p->expected == flags);
+   test_wakeups[task_current - task_worker]++;
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Tasks with various wait conditions are suspended on the same event flags
+ * group. Lower prio task sets the flags one by one and checks that only tasks
+ * with satisfied wait condition were woken up (each wake up preempts the
+ * setter since waiters have higher prio)
+ */
+static const test_waitparam_t scen2_param[] = {
+   { 0x3, OS_EVFLAGS_ALL, 0x3, OS_OK },
+   { 0x4, OS_EVFLAGS_ANY, 0x7, OS_OK },
+   { 0x1, OS_EVFLAGS_ANY | OS_EVFLAGS_CLEAR, 0x1, OS_OK },
+   { 0x1, OS_EVFLAGS_ALL | OS_EVFLAGS_CLEAR, 0x1, OS_OK },
+};
+
+int test_scen2_setter(void *OS_UNUSED(param))
+{
+   /* both auto clear tasks woken by single set, flag cleared after the pass */
+   test_assert(0x0 == os_evflags_set(&test_evflags, 0x1));
+   test_assert(0 == test_wakeups[0]);
+   test_assert(0 == test_wakeups[1]);
+   test_assert(1 == test_wakeups[2]);
+   test_assert(1 == test_wakeups[3]);
+
+   /* nobody waits for single 0x2 */
+   test_assert(0x2 == os_evflags_set(&test_evflags, 0x2));
+   test_assert(0 == test_wakeups[0]);
+   test_assert(0 == test_wakeups[1]);
+
+   /* now condition of task 0 is satisfied */
+   test_assert(0x3 == os_evflags_set(&test_evflags, 0x1));
+   test_assert(1 == test_wakeups[0]);
+   test_assert(0 == test_wakeups[1]);
+
+   test_assert(0x7 == os_evflags_set(&test_evflags, 0x4));
+   test_assert(1 == test_wakeups[1]);
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Destroy of event flags group releases the suspended tasks. Task is created
+ * after the waiter with the same prio, so waiter is already suspended
+ */
+int test_scen3_destroyer(void *OS_UNUSED(param))
+{
+   test_assert(0 == test_wakeups[0]);
+   /* waiter has the same prio so it was not scheduled yet */
+   os_evflags_destroy(&test_evflags);
+   test_assert(0 == test_wakeups[0]);
+
+   return 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   os_retcode_t ret;
+   uint32_t flags;
+   uint16_t i;
+   os_ticks_t ticks_start;
+
+/* scenario 1 */
+   /* wait conditions satisfied without suspend */
+   os_evflags_create(&test_evflags, 0x1);
+   ret = os_evflags_wait(&test_evflags, 0x3, OS_EVFLAGS_ANY,
+                         OS_TIMEOUT_TRY, &flags);
+   test_assert(OS_OK == ret);
+   test_assert(0x1 == flags);
+   ret = os_evflags_wait(&test_evflags, 0x3, OS_EVFLAGS_ALL,
+                         OS_TIMEOUT_TRY, &flags);
+   test_assert(OS_WOULDBLOCK == ret);
+   test_assert(0x3 == os_evflags_set(&test_evflags, 0x2));
+   ret = os_evflags_wait(&test_evflags, 0x3,
+                         OS_EVFLAGS_ALL | OS_EVFLAGS_CLEAR,
+                         OS_TIMEOUT_INFINITE, NULL);
+   test_assert(OS_OK == ret);
+   test_assert(0x0 == os_evflags_get(&test_evflags));
+   test_assert(0x30 == os_evflags_set(&test_evflags, 0x30));
+   test_assert(0x30 == os_evflags_clear(&test_evflags, 0x10));
+   test_assert(0x20 == os_evflags_get(&test_evflags));
+   os_evflags_destroy(&test_evflags);
+
+/* scenario 2 */
+   os_evflags_create(&test_evflags, 0);
+   for (i = 0; i < 4; i++) {
+      test_wakeups[i] = 0;
+      os_task_create(
+         &task_worker[i], 2 + (i % 2),
+         task_stack[i], sizeof(task_stack[i]),
+         test_waiter, (void*)&scen2_param[i]);
+   }
+   os_task_create(
+      &task_worker[4], 1,
+      task_stack[4], sizeof(task_stack[4]),
+      test_scen2_setter, NULL);
+   for (i = 0; i < 5; i++)
+      os_task_join(&task_worker[i]);
+   for (i = 0; i < 4; i++)
+      test_assert(1 == test_wakeups[i]);
+   os_evflags_destroy(&test_evflags);
+
+/* scenario 3 */
+   static const test_waitparam_t scen3_param = {
+      0x1, OS_EVFLAGS_ALL, 0x0, OS_DESTROYED };
+   os_evflags_create(&test_evflags, 0);
+   test_wakeups[0] = 0;
+   os_task_create(
+      &task_worker[0], 1,
+      task_stack[0], sizeof(task_stack[0]),
+      test_waiter, (void*)&scen3_param);
+   os_task_create(
+      &task_worker[1], 1,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen3_destroyer, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(1 == test_wakeups[0]);
+
+/* scenario 4 */
+   /* suspend with timeout, nobody will set the flags */
+   os_evflags_create(&test_evflags, 0);
+   test_setuptick(test_tick, 1000000);
+   ticks_start = os_ticks_now();
+   ret = os_evflags_wait(&test_evflags, 0x80, OS_EVFLAGS_ANY, 5, NULL);
+   test_assert(OS_TIMEOUT == ret);
+   test_assert(os_ticks_diff(ticks_start, os_ticks_now()) >= 4);
+
+   /* flags set from ISR */
+   isr_set = 1;
+   ret = os_evflags_wait(&test_evflags, 0x80,
+                         OS_EVFLAGS_ALL | OS_EVFLAGS_CLEAR,
+                         OS_TIMEOUT_INFINITE, &flags);
+   test_assert(OS_OK == ret);
+   test_assert(0x80 == flags);
+   test_assert(0 == isr_set);
+   test_assert(0x0 == os_evflags_get(&test_evflags));
+   os_evflags_destroy(&test_evflags);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Evflags");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
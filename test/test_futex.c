@@ -0,0 +1,259 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os futex routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_LOOPS ((uint16_t)1000)
+
+static os_task_t task_worker[5];
+static OS_TASKSTACK task_stack[5][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+/* futex words, first and last one most probably share the same hash bucket */
+static arch_atomic_t test_word[OS_CONFIG_FUTEX_HASHSIZE + 1];
+static volatile sig_atomic_t test_atomic[2];
+static volatile sig_atomic_t test_order[4];
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Simple lock build on top of futex, 0 - unlocked, 1 - locked, 2 - locked
+ * with possible waiters (see os_futex.h)
+ */
+static void test_futex_lock(arch_atomic_t *word)
+{
+   arch_atomic_t c = 0;
+   os_retcode_t ret;
+
+   if (os_atomic_cmp_exch(word, &c, 1)) {
+      if (2 != c)
+         c = os_atomic_exch(word, 2);
+      while (0 != c) {
+         ret = os_futex_wait(word, 2, OS_TIMEOUT_INFINITE);
+         test_assert((OS_OK == ret) || (OS_WOULDBLOCK == ret));
+         c = os_atomic_exch(word, 2);
+      }
+   }
+}
+
+static void test_futex_unlock(arch_atomic_t *word)
+{
+   if (2 == os_atomic_exch(word, 0))
+      (void)os_futex_wake(word, 1);
+}
+
+/**
+ * Test scenario:
+ * Critical section protected by futex based lock. Implementation will be
+ * validated by checking shared variable state with forced preemption
+ */
+int test_scen1_worker(void *param)
+{
+   uint16_t i;
+   uintptr_t task_idx = (uintptr_t)param;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      test_futex_lock(&test_word[0]);
+
+      test_assert(0 == test_atomic[0]);
+      test_assert(-1 == test_atomic[1]);
+      test_atomic[0]++;
+      test_atomic[1] = task_idx;
+
+      /* force task switch to check if lock properly secures the critical
+       * section */
+      test_reqtick();
+
+      test_assert(1 == test_atomic[0]);
+      test_assert(task_idx == (uintptr_t)(test_atomic[1]));
+
+      --test_atomic[0];
+      test_atomic[1] = -1;
+      test_futex_unlock(&test_word[0]);
+
+      /* add randomness to test, force task switch with 50% of probability */
+      if (0 == (rand() % 2)) test_reqtick();
+   }
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Tasks with different priorities suspend on two futex words. Waker task wakes
+ * them one by one and checks that only tasks suspended on given futex word are
+ * woken up and that they are woken up in priority order
+ */
+int test_scen2_waiter(void *param)
+{
+   int ret;
+   uintptr_t word_idx = (uintptr_t)param;
+
+   ret = os_futex_wait(&test_word[word_idx], 0, OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   test_order[test_atomic[0]++] = task_current->prio_base;
+
+   return 0;
+}
+
+int test_scen2_waker(void *OS_UNUSED(param))
+{
+   /* all waiters have higher prio or were created before us, so all of them
+    * are suspended now */
+   test_assert(0 == test_atomic[0]);
+
+   /* wake single task, we should be preempted by most prioritized one */
+   test_assert(1 == os_futex_wake(&test_word[0], 1));
+   test_assert(1 == test_atomic[0]);
+   test_assert(3 == test_order[0]);
+
+   test_assert(1 == os_futex_wake(&test_word[0], 1));
+   test_assert(2 == test_atomic[0]);
+   test_assert(2 == test_order[1]);
+
+   /* task suspended on other futex word (most probably in the same bucket) */
+   test_assert(1 == os_futex_wake(&test_word[OS_CONFIG_FUTEX_HASHSIZE],
+                                  OS_FUTEX_ALL));
+   test_assert(3 == test_atomic[0]);
+   test_assert(3 == test_order[2]);
+
+   /* the last task has the same prio as us so there is no preemption */
+   test_assert(1 == os_futex_wake(&test_word[0], OS_FUTEX_ALL));
+   test_assert(3 == test_atomic[0]);
+
+   /* nobody is waiting any more */
+   test_assert(0 == os_futex_wake(&test_word[0], OS_FUTEX_ALL));
+
+   return 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   int ret;
+   uint16_t i;
+   os_ticks_t ticks_start;
+
+/* scenario 1 */
+   test_word[0] = 0;
+   test_atomic[0] = 0;
+   test_atomic[1] = -1;
+   for (i = 0; i < 4; i++) {
+      /* created task will be not scheduled because current task has the highest
+       * available priority */
+      os_task_create(
+         &task_worker[i], 1,
+         task_stack[i], sizeof(task_stack[i]),
+         test_scen1_worker, (void*)(uintptr_t)i);
+   }
+   /* scheduler will kick in after following call */
+   for (i = 0; i < 4; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(0 == test_word[0]);
+
+/* scenario 2 */
+   const uint_fast8_t scen2_prio[] = { 1, 2, 3, 3 };
+   const uintptr_t scen2_word[] = { 0, 0, 0, OS_CONFIG_FUTEX_HASHSIZE };
+   test_word[0] = 0;
+   test_word[OS_CONFIG_FUTEX_HASHSIZE] = 0;
+   test_atomic[0] = 0;
+   for (i = 0; i < 4; i++) {
+      os_task_create(
+         &task_worker[i], scen2_prio[i],
+         task_stack[i], sizeof(task_stack[i]),
+         test_scen2_waiter, (void*)scen2_word[i]);
+   }
+   os_task_create(
+      &task_worker[4], 1,
+      task_stack[4], sizeof(task_stack[4]),
+      test_scen2_waker, NULL);
+   for (i = 0; i < 5; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(4 == test_atomic[0]);
+   test_assert(1 == test_order[3]);
+
+/* scenario 3 */
+   /* futex word differs from expected value, task should not suspend */
+   test_word[0] = 1;
+   ret = os_futex_wait(&test_word[0], 0, OS_TIMEOUT_INFINITE);
+   test_assert(OS_WOULDBLOCK == ret);
+
+   /* try without suspend */
+   ret = os_futex_wait(&test_word[0], 1, OS_TIMEOUT_TRY);
+   test_assert(OS_WOULDBLOCK == ret);
+
+   /* suspend with timeout, nobody will wake us */
+   test_setuptick(NULL, 1000000);
+   ticks_start = os_ticks_now();
+   ret = os_futex_wait(&test_word[0], 1, 5);
+   test_assert(OS_TIMEOUT == ret);
+   test_assert(os_ticks_diff(ticks_start, os_ticks_now()) >= 4);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Futex");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
@@ -0,0 +1,358 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os heap routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_LOOPS ((uint16_t)2000)
+#define TEST_SLOTS ((size_t)32)
+#define TEST_MAXALLOC ((size_t)512)
+#define TEST_BENCH_SLOTS ((size_t)256)
+#define TEST_BENCH_OPS ((unsigned long)200000)
+
+static os_task_t task_worker[4];
+static OS_TASKSTACK task_stack[4][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_heap_t test_heap;
+static uint8_t test_mem[256 * 1024];
+static void *test_bench_slot[TEST_BENCH_SLOTS];
+static volatile sig_atomic_t isr_stress;
+static volatile sig_atomic_t isr_allocs;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Function fills the block with owner marker
+ */
+static void test_block_fill(void *block, size_t size, uint8_t marker)
+{
+   memset(block, marker, size);
+}
+
+/**
+ * Function checks if block still contain the owner marker
+ */
+static void test_block_check(void *block, size_t size, uint8_t marker)
+{
+   uint8_t *p = (uint8_t*)block;
+   size_t i;
+
+   for (i = 0; i < size; i++)
+      test_assert(marker == p[i]);
+}
+
+/**
+ * Function verifies that heap does not contain any allocated block and that
+ * free blocks were merged into single one
+ */
+static void test_heap_check_empty(void)
+{
+   os_heap_stats_t stats;
+
+   os_heap_stats(&test_heap, &stats);
+   test_assert(0 == stats.used);
+   test_assert(0 == stats.used_blocks);
+   test_assert(1 == stats.free_blocks);
+   test_assert(stats.size == stats.free);
+   test_assert(stats.size == stats.free_largest);
+   test_assert(0 == stats.fragmentation);
+}
+
+/**
+ * Tick callback, allocates and frees the block from ISR during stress test
+ */
+static void test_tick(void)
+{
+   void *block;
+   size_t size;
+
+   if (isr_stress) {
+      /* rand() takes the libc lock so it cannot be used from ISR */
+      size = 1 + (isr_allocs * 37) % TEST_MAXALLOC;
+      block = os_heap_alloc(&test_heap, size);
+      if (block) {
+         test_block_fill(block, size, 0xFF);
+         test_block_check(block, size, 0xFF);
+         os_heap_free(&test_heap, block);
+         isr_allocs++;
+      }
+   }
+}
+
+/**
+ * Test scenario:
+ * Task allocates blocks and checks per task accounting
+ */
+int test_scen2_worker(void *OS_UNUSED(param))
+{
+   void *block[3];
+
+   test_assert(0 == task_current->heap_used);
+   block[0] = os_heap_alloc(&test_heap, 100);
+   block[1] = os_heap_alloc(&test_heap, 1000);
+   block[2] = os_heap_alloc(&test_heap, 1);
+   test_assert(block[0] && block[1] && block[2]);
+   test_assert(task_current->heap_used >= 1101);
+   test_assert(task_current->heap_used == task_current->heap_peak);
+   os_heap_free(&test_heap, block[1]);
+   test_assert(task_current->heap_used < 1000);
+   test_assert(task_current->heap_peak >= 1101);
+   os_heap_free(&test_heap, block[0]);
+   /* block[2] is freed by coordinator, accounting follows the owner */
+
+   return (uintptr_t)block[2] - (uintptr_t)test_mem;
+}
+
+/**
+ * Test scenario:
+ * Tasks and ISR allocate and free random size blocks with forced preemption.
+ * Each owner fills the block with its marker and checks that memory was not
+ * overwritten by other owner
+ */
+int test_scen3_worker(void *param)
+{
+   void *block[TEST_SLOTS] = { NULL };
+   size_t size[TEST_SLOTS];
+   uint8_t marker = (uint8_t)(uintptr_t)param;
+   uint16_t i;
+   size_t slot;
+   /* rand() takes the libc lock, so it cannot be used while tick may preempt
+    * the task in middle of it */
+   unsigned int seed = marker;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      slot = rand_r(&seed) % TEST_SLOTS;
+      if (block[slot]) {
+         test_block_check(block[slot], size[slot], marker);
+         os_heap_free(&test_heap, block[slot]);
+         block[slot] = NULL;
+      } else {
+         size[slot] = 1 + rand_r(&seed) % TEST_MAXALLOC;
+         block[slot] = os_heap_alloc(&test_heap, size[slot]);
+         test_assert(block[slot]);
+         test_assert(0 == ((uintptr_t)block[slot] % (2 * sizeof(void*))));
+         test_block_fill(block[slot], size[slot], marker);
+      }
+
+      if (0 == (rand_r(&seed) % 4)) test_reqtick();
+   }
+
+   for (slot = 0; slot < TEST_SLOTS; slot++) {
+      if (block[slot]) {
+         test_block_check(block[slot], size[slot], marker);
+         os_heap_free(&test_heap, block[slot]);
+      }
+   }
+   test_assert(0 == task_current->heap_used);
+
+   return 0;
+}
+
+static unsigned long test_nsec(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+/**
+ * Test scenario:
+ * Benchmark of os_heap against glibc malloc. The same sequence of random
+ * alloc/free operations is executed by both allocators, total time and the
+ * worst single operation time are reported. Results are informative only.
+ * Keep in mind that on linux port each os_heap operation includes critical
+ * section which costs two sigprocmask() syscalls.
+ */
+static void test_scen5_run(bool use_malloc)
+{
+   unsigned long i, t, t_start, t_total = 0, t_worst = 0;
+   size_t slot, size;
+   void **p;
+
+   srand(5);
+   memset(test_bench_slot, 0, sizeof(test_bench_slot));
+   for (i = 0; i < TEST_BENCH_OPS + TEST_BENCH_SLOTS; i++) {
+      /* at the end free all blocks */
+      slot = (i < TEST_BENCH_OPS) ?
+         (size_t)rand() % TEST_BENCH_SLOTS : i - TEST_BENCH_OPS;
+      size = 1 + rand() % 1024;
+      p = &test_bench_slot[slot];
+      if ((i >= TEST_BENCH_OPS) && !*p)
+         continue;
+
+      t_start = test_nsec();
+      if (*p) {
+         if (use_malloc)
+            free(*p);
+         else
+            os_heap_free(&test_heap, *p);
+         *p = NULL;
+      } else {
+         *p = use_malloc ? malloc(size) : os_heap_alloc(&test_heap, size);
+         test_assert(*p);
+      }
+      t = test_nsec() - t_start;
+
+      t_total += t;
+      if (t > t_worst)
+         t_worst = t;
+   }
+   test_debug("%s: %lu ops, total %lu us, worst op %lu ns",
+              use_malloc ? "glibc malloc" : "os_heap",
+              TEST_BENCH_OPS, t_total / 1000, t_worst);
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   os_heap_stats_t stats;
+   void *block[16];
+   size_t i;
+   int ret;
+
+/* scenario 1 */
+   os_heap_create(&test_heap, test_mem, sizeof(test_mem));
+   test_heap_check_empty();
+   test_assert(NULL == os_heap_alloc(&test_heap, 0));
+   test_assert(NULL == os_heap_alloc(&test_heap, sizeof(test_mem)));
+   for (i = 0; i < 16; i++) {
+      block[i] = os_heap_alloc(&test_heap, 1 + i * 300);
+      test_assert(block[i]);
+      test_assert(0 == ((uintptr_t)block[i] % (2 * sizeof(void*))));
+      test_block_fill(block[i], 1 + i * 300, i);
+   }
+   for (i = 0; i < 16; i++)
+      test_block_check(block[i], 1 + i * 300, i);
+   /* free in mixed order to check merging with both neighbours */
+   for (i = 0; i < 16; i += 2)
+      os_heap_free(&test_heap, block[i]);
+   for (i = 1; i < 16; i += 2)
+      os_heap_free(&test_heap, block[i]);
+   test_heap_check_empty();
+   /* whole free block can be allocated back */
+   os_heap_stats(&test_heap, &stats);
+   block[0] = os_heap_alloc(&test_heap, stats.free_largest / 2);
+   test_assert(block[0]);
+   os_heap_free(&test_heap, block[0]);
+   test_heap_check_empty();
+
+/* scenario 2 */
+   os_task_create(
+      &task_worker[0], 1,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen2_worker, NULL);
+   ret = os_task_join(&task_worker[0]);
+   test_assert(task_worker[0].heap_used > 0);
+   os_heap_free(&test_heap, test_mem + ret);
+   test_assert(0 == task_worker[0].heap_used);
+   test_assert(task_worker[0].heap_peak >= 1101);
+   test_heap_check_empty();
+
+/* scenario 4 */
+   /* fragmentation report */
+   for (i = 0; i < 16; i++)
+      block[i] = os_heap_alloc(&test_heap, 64);
+   for (i = 0; i < 16; i += 2)
+      os_heap_free(&test_heap, block[i]);
+   os_heap_stats(&test_heap, &stats);
+   test_assert(8 == stats.used_blocks);
+   test_assert(8 + 1 == stats.free_blocks);
+   test_assert(stats.fragmentation > 0);
+   test_assert(stats.used_peak >= 16 * 64);
+   test_debug("fragmentation %u%% free %u largest %u blocks %u",
+              (unsigned)stats.fragmentation, (unsigned)stats.free,
+              (unsigned)stats.free_largest, (unsigned)stats.free_blocks);
+   for (i = 1; i < 16; i += 2)
+      os_heap_free(&test_heap, block[i]);
+   test_heap_check_empty();
+
+/* scenario 5 */
+   /* benchmark runs before the tick is started to decrease the noise */
+   test_scen5_run(false);
+   test_heap_check_empty();
+   test_scen5_run(true);
+
+/* scenario 3 */
+   test_setuptick(test_tick, 100000);
+   isr_stress = 1;
+   for (i = 0; i < 4; i++) {
+      os_task_create(
+         &task_worker[i], 1,
+         task_stack[i], sizeof(task_stack[i]),
+         test_scen3_worker, (void*)(i + 1));
+   }
+   for (i = 0; i < 4; i++)
+      os_task_join(&task_worker[i]);
+   isr_stress = 0;
+   test_debug("ISR allocations %u", (unsigned)isr_allocs);
+   test_heap_check_empty();
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Heap");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
@@ -0,0 +1,240 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test of high resolution timers
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_NSEC_PER_USEC ((uint64_t)1000)
+#define TEST_PERIODIC_CNT ((unsigned)50)
+#define TEST_HEAP_CNT ((unsigned)16)
+
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_hrtimer_t timers[3];
+static os_sem_t test_sem;
+static volatile unsigned test_order[3];
+static volatile unsigned test_order_idx;
+static volatile unsigned test_periodic_cnt;
+static os_hrtimer_t timers_heap[TEST_HEAP_CNT];
+static volatile unsigned test_heap_order[TEST_HEAP_CNT];
+static volatile unsigned test_heap_idx;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+static void timer_order_clbck(void *param)
+{
+   test_assert(isr_nesting > 0);
+   test_order[test_order_idx++] = (unsigned)(uintptr_t)param;
+   os_sem_up(&test_sem);
+}
+
+static void timer_periodic_clbck(void *param)
+{
+   if (++test_periodic_cnt >= TEST_PERIODIC_CNT) {
+      /* callback is allowed to cancel its own timer */
+      os_hrtimer_cancel((os_hrtimer_t*)param);
+      os_sem_up(&test_sem);
+   }
+}
+
+static void timer_fail_clbck(void *OS_UNUSED(param))
+{
+   test_assert(0);
+}
+
+static void timer_heap_clbck(void *param)
+{
+   test_heap_order[test_heap_idx++] = (unsigned)(uintptr_t)param;
+   if (TEST_HEAP_CNT == test_heap_idx)
+      os_sem_up(&test_sem);
+}
+
+/**
+ * Timeout of timers in scenario 7, timeouts are shuffled and some of them are
+ * equal
+ */
+static uint64_t test_heap_timeout(unsigned i)
+{
+   return (100 + (((i * 7) % 5) * 50)) * TEST_NSEC_PER_USEC;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   uint64_t start;
+   uint64_t elapsed;
+   os_retcode_t ret;
+   unsigned i, a, b;
+
+   os_sem_create(&test_sem, 0);
+
+/* scenario 1 */
+   /* timers expire in order of deadlines, not in order of start */
+   start = os_hrtimer_now();
+   os_hrtimer_start(
+      &timers[0], timer_order_clbck, (void*)0, 300 * TEST_NSEC_PER_USEC, 0);
+   os_hrtimer_start(
+      &timers[1], timer_order_clbck, (void*)1, 100 * TEST_NSEC_PER_USEC, 0);
+   os_hrtimer_start(
+      &timers[2], timer_order_clbck, (void*)2, 200 * TEST_NSEC_PER_USEC, 0);
+   ret = os_sem_down(&test_sem, OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+   ret = os_sem_down(&test_sem, OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+   ret = os_sem_down(&test_sem, OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+   elapsed = os_hrtimer_now() - start;
+   test_assert(elapsed >= 300 * TEST_NSEC_PER_USEC);
+   test_assert(1 == test_order[0]);
+   test_assert(2 == test_order[1]);
+   test_assert(0 == test_order[2]);
+
+/* scenario 2 */
+   /* periodic timer with 10us period, reloads do not drift */
+   start = os_hrtimer_now();
+   os_hrtimer_start(
+      &timers[0], timer_periodic_clbck, &timers[0],
+      10 * TEST_NSEC_PER_USEC, 10 * TEST_NSEC_PER_USEC);
+   ret = os_sem_down(&test_sem, OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+   elapsed = os_hrtimer_now() - start;
+   test_assert(elapsed >= TEST_PERIODIC_CNT * 10 * TEST_NSEC_PER_USEC);
+   test_assert(TEST_PERIODIC_CNT == test_periodic_cnt);
+
+/* scenario 3 */
+   /* canceled timer does not expire (checked by sleep in next scenario) */
+   os_hrtimer_start(
+      &timers[1], timer_fail_clbck, NULL, 1000 * TEST_NSEC_PER_USEC, 0);
+   os_hrtimer_cancel(&timers[1]);
+   os_hrtimer_cancel(&timers[1]); /* double cancel is allowed */
+
+/* scenario 4 */
+   /* sleep with nanosecond resolution */
+   start = os_hrtimer_now();
+   os_task_sleep_ns(2000 * TEST_NSEC_PER_USEC);
+   elapsed = os_hrtimer_now() - start;
+   test_assert(elapsed >= 2000 * TEST_NSEC_PER_USEC);
+
+/* scenario 5 */
+   /* nanosecond timeout of semaphore */
+   ret = os_sem_down_ns(&test_sem, 0);
+   test_assert(OS_WOULDBLOCK == ret);
+   start = os_hrtimer_now();
+   ret = os_sem_down_ns(&test_sem, 200 * TEST_NSEC_PER_USEC);
+   test_assert(OS_TIMEOUT == ret);
+   elapsed = os_hrtimer_now() - start;
+   test_assert(elapsed >= 200 * TEST_NSEC_PER_USEC);
+
+   /* semaphore signaled before timeout, timeout hrtimer is canceled */
+   test_order_idx = 0;
+   os_hrtimer_start(
+      &timers[0], timer_order_clbck, (void*)0, 100 * TEST_NSEC_PER_USEC, 0);
+   ret = os_sem_down_ns(&test_sem, 100000 * TEST_NSEC_PER_USEC);
+   test_assert(OS_OK == ret);
+   test_assert(NULL == task_current->hrtimer);
+
+/* scenario 6 */
+   /* restart of active timer replaces its deadline and callback, it expires
+    * only once */
+   test_order_idx = 0;
+   os_hrtimer_start(
+      &timers[1], timer_fail_clbck, NULL, 100 * TEST_NSEC_PER_USEC, 0);
+   os_hrtimer_start(
+      &timers[2], timer_order_clbck, (void*)2, 200 * TEST_NSEC_PER_USEC, 0);
+   start = os_hrtimer_now();
+   os_hrtimer_start(
+      &timers[1], timer_order_clbck, (void*)1, 300 * TEST_NSEC_PER_USEC, 0);
+   ret = os_sem_down(&test_sem, OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+   ret = os_sem_down(&test_sem, OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+   elapsed = os_hrtimer_now() - start;
+   test_assert(elapsed >= 300 * TEST_NSEC_PER_USEC);
+   test_assert(2 == test_order[0]);
+   test_assert(1 == test_order[1]);
+   os_task_sleep_ns(500 * TEST_NSEC_PER_USEC);
+   test_assert(2 == test_order_idx);
+
+/* scenario 7 */
+   /* many timers started in shuffled order expire in order of deadlines,
+    * timers with equal timeouts expire in order of start */
+   for (i = 0; i < TEST_HEAP_CNT; i++) {
+      os_hrtimer_start(
+         &timers_heap[i], timer_heap_clbck, (void*)(uintptr_t)i,
+         test_heap_timeout(i), 0);
+   }
+   ret = os_sem_down(&test_sem, OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+   for (i = 1; i < TEST_HEAP_CNT; i++) {
+      a = test_heap_order[i - 1];
+      b = test_heap_order[i];
+      test_assert((test_heap_timeout(a) < test_heap_timeout(b)) ||
+                  ((test_heap_timeout(a) == test_heap_timeout(b)) && (a < b)));
+   }
+
+   os_sem_destroy(&test_sem);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Hrtimer");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
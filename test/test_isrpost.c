@@ -0,0 +1,189 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os deferred ISR post routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_LOOPS ((uint16_t)200)
+
+typedef enum {
+   TEST_MODE_NONE,
+   TEST_MODE_POST,
+   TEST_MODE_OVERFLOW,
+   TEST_MODE_WAKEUP,
+} test_mode_t;
+
+static os_task_t task_worker;
+static OS_TASKSTACK task_stack[OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_sem_t test_sem;
+static os_evflags_t test_evflags;
+static volatile test_mode_t test_mode;
+static volatile sig_atomic_t test_woken;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Tick callback, top half of interrupt handler which posts the operations
+ */
+static void test_tick(void)
+{
+   arch_atomic_t i;
+
+   switch (test_mode) {
+   case TEST_MODE_POST:
+      os_isrpost_sem_up(&test_sem);
+      os_isrpost(OS_ISRPOST_SEM_UP, &test_sem, 2);
+      os_isrpost_evflags_set(&test_evflags, 0x5);
+      os_isrpost_task_notify(&task_coordinator, 0x10);
+      /* posts are applied after top half, not in place */
+      test_assert(0 == test_sem.value);
+      test_assert(0 == os_evflags_get(&test_evflags));
+      break;
+
+   case TEST_MODE_OVERFLOW:
+      /* posts which do not fit into queue are applied in place */
+      for (i = 0; i < OS_CONFIG_ISRPOST_SIZE + 5; i++)
+         os_isrpost_sem_up(&test_sem);
+      test_assert(5 == test_sem.value);
+      break;
+
+   case TEST_MODE_WAKEUP:
+      os_isrpost_sem_up(&test_sem);
+      break;
+
+   default:
+      break;
+   }
+}
+
+/**
+ * Test scenario:
+ * Lower priority task triggers the interrupt which posts the semaphore.
+ * Higher priority task waiting on semaphore must run before the interrupted
+ * task resumes
+ */
+int test_scen3_worker(void *OS_UNUSED(param))
+{
+   test_mode = TEST_MODE_WAKEUP;
+   test_reqtick();
+   test_mode = TEST_MODE_NONE;
+   test_assert(test_woken);
+
+   return 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   uint32_t value;
+   uint16_t i;
+
+   os_sem_create(&test_sem, 0);
+   os_evflags_create(&test_evflags, 0);
+   test_setuptick(test_tick, 0);
+
+/* scenario 1 */
+   /* all posted operations are applied before task resumes */
+   test_mode = TEST_MODE_POST;
+   test_reqtick();
+   test_mode = TEST_MODE_NONE;
+   test_assert(3 == test_sem.value);
+   for (i = 0; i < 3; i++)
+      test_assert(OS_OK == os_sem_down(&test_sem, OS_TIMEOUT_TRY));
+   test_assert(0x5 == os_evflags_get(&test_evflags));
+   test_assert(OS_OK == os_task_notify_wait(UINT32_MAX, OS_TIMEOUT_TRY, &value));
+   test_assert(0x10 == value);
+
+/* scenario 2 */
+   /* queue overflow */
+   test_mode = TEST_MODE_OVERFLOW;
+   test_reqtick();
+   test_mode = TEST_MODE_NONE;
+   test_assert(OS_CONFIG_ISRPOST_SIZE + 5 == test_sem.value);
+   while (OS_OK == os_sem_down(&test_sem, OS_TIMEOUT_TRY));
+
+/* scenario 3 */
+   os_task_create(
+      &task_worker, 1,
+      task_stack, sizeof(task_stack),
+      test_scen3_worker, NULL);
+   test_assert(OS_OK == os_sem_down(&test_sem, OS_TIMEOUT_INFINITE));
+   test_woken = 1;
+   os_task_join(&task_worker);
+
+/* scenario 4 */
+   /* periodic interrupt posts the semaphore */
+   test_mode = TEST_MODE_WAKEUP;
+   test_setuptick(test_tick, 1000000);
+   for (i = 0; i < TEST_LOOPS; i++)
+      test_assert(OS_OK == os_sem_down(&test_sem, OS_TIMEOUT_INFINITE));
+   test_mode = TEST_MODE_NONE;
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Isrpost");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
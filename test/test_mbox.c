@@ -0,0 +1,263 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os mailbox routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_LOOPS ((uint16_t)1000)
+#define TEST_MSGCNT ((arch_ridx_t)4)
+
+typedef struct {
+   void *self;
+   uint16_t seq;
+   uint8_t data[50];
+} test_msg_t;
+
+static os_task_t task_worker[2];
+static OS_TASKSTACK task_stack[2][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_mbox_t test_mbox;
+static uint8_t test_mem[OS_MBOX_MEMSIZE(sizeof(test_msg_t), TEST_MSGCNT)]
+   __attribute__ ((aligned(sizeof(void*))));
+static volatile sig_atomic_t isr_commit;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Tick callback, sends the message from ISR on request
+ */
+static void test_tick(void)
+{
+   test_msg_t *msg;
+
+   if (isr_commit) {
+      isr_commit = 0;
+      msg = (test_msg_t*)os_mbox_reserve(&test_mbox, OS_TIMEOUT_TRY);
+      test_assert(msg);
+      msg->self = msg;
+      msg->seq = 0xBEEF;
+      os_mbox_commit(&test_mbox, msg);
+   }
+}
+
+/**
+ * Test scenario:
+ * Producer and consumer exchange messages. Depending on priorities messages are
+ * either handed over directly to suspended consumer or producer suspends on
+ * full mailbox. Consumer checks the order of messages and that it received the
+ * same slot which was filled by producer
+ */
+int test_scen2_producer(void *OS_UNUSED(param))
+{
+   test_msg_t *msg;
+   uint16_t i;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      msg = (test_msg_t*)os_mbox_reserve(&test_mbox, OS_TIMEOUT_INFINITE);
+      test_assert(msg);
+      msg->self = msg;
+      msg->seq = i;
+      memset(msg->data, (uint8_t)i, sizeof(msg->data));
+      os_mbox_commit(&test_mbox, msg);
+
+      if (0 == (rand() % 4)) test_reqtick();
+   }
+
+   return 0;
+}
+
+int test_scen2_consumer(void *OS_UNUSED(param))
+{
+   test_msg_t *msg;
+   uint16_t i;
+   size_t j;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      msg = (test_msg_t*)os_mbox_borrow(&test_mbox, OS_TIMEOUT_INFINITE);
+      test_assert(msg);
+      test_assert(msg->self == msg);
+      test_assert(i == msg->seq);
+      for (j = 0; j < sizeof(msg->data); j++)
+         test_assert((uint8_t)i == msg->data[j]);
+      os_mbox_release(&test_mbox, msg);
+
+      if (0 == (rand() % 4)) test_reqtick();
+   }
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Destroy of mailbox releases the suspended tasks. Destroyer is created after
+ * the waiter with the same prio, so waiter is already suspended
+ */
+int test_scen4_waiter(void *OS_UNUSED(param))
+{
+   test_assert(NULL == os_mbox_borrow(&test_mbox, OS_TIMEOUT_INFINITE));
+
+   return 0;
+}
+
+int test_scen4_destroyer(void *OS_UNUSED(param))
+{
+   os_mbox_destroy(&test_mbox);
+
+   return 0;
+}
+
+static void test_scen2_run(uint_fast8_t prod_prio, uint_fast8_t cons_prio)
+{
+   uint16_t i;
+
+   os_task_create(
+      &task_worker[0], prod_prio,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen2_producer, NULL);
+   os_task_create(
+      &task_worker[1], cons_prio,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen2_consumer, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(NULL == os_mbox_borrow(&test_mbox, OS_TIMEOUT_TRY));
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   test_msg_t *msg[TEST_MSGCNT];
+   os_ticks_t ticks_start;
+   arch_ridx_t i;
+
+   os_mbox_create(&test_mbox, test_mem, sizeof(test_msg_t), TEST_MSGCNT);
+
+/* scenario 1 */
+   /* messages are received in commit order, slots are not copied */
+   for (i = 0; i < TEST_MSGCNT; i++) {
+      msg[i] = (test_msg_t*)os_mbox_reserve(&test_mbox, OS_TIMEOUT_TRY);
+      test_assert(msg[i]);
+      test_assert((uint8_t*)msg[i] >= test_mem);
+      test_assert((uint8_t*)(msg[i] + 1) <= test_mem + sizeof(test_mem));
+      msg[i]->seq = i;
+   }
+   test_assert(NULL == os_mbox_reserve(&test_mbox, OS_TIMEOUT_TRY));
+   test_assert(NULL == os_mbox_borrow(&test_mbox, OS_TIMEOUT_TRY));
+   os_mbox_commit(&test_mbox, msg[2]);
+   os_mbox_commit(&test_mbox, msg[0]);
+   test_assert(msg[2] == os_mbox_borrow(&test_mbox, OS_TIMEOUT_TRY));
+   os_mbox_commit(&test_mbox, msg[1]);
+   test_assert(msg[0] == os_mbox_borrow(&test_mbox, OS_TIMEOUT_TRY));
+   test_assert(msg[1] == os_mbox_borrow(&test_mbox, OS_TIMEOUT_TRY));
+   test_assert(NULL == os_mbox_borrow(&test_mbox, OS_TIMEOUT_TRY));
+   /* release of borrowed messages and cancel of reserved one */
+   for (i = 0; i < TEST_MSGCNT; i++)
+      os_mbox_release(&test_mbox, msg[i]);
+
+/* scenario 2 */
+   test_scen2_run(1, 2);
+   test_scen2_run(2, 1);
+   test_scen2_run(1, 1);
+
+/* scenario 3 */
+   /* timeouts on empty and full mailbox */
+   test_setuptick(test_tick, 1000000);
+   ticks_start = os_ticks_now();
+   test_assert(NULL == os_mbox_borrow(&test_mbox, 5));
+   test_assert(os_ticks_diff(ticks_start, os_ticks_now()) >= 4);
+   for (i = 0; i < TEST_MSGCNT; i++)
+      msg[i] = (test_msg_t*)os_mbox_reserve(&test_mbox, 5);
+   ticks_start = os_ticks_now();
+   test_assert(NULL == os_mbox_reserve(&test_mbox, 5));
+   test_assert(os_ticks_diff(ticks_start, os_ticks_now()) >= 4);
+   for (i = 0; i < TEST_MSGCNT; i++)
+      os_mbox_release(&test_mbox, msg[i]);
+
+   /* commit from ISR */
+   isr_commit = 1;
+   msg[0] = (test_msg_t*)os_mbox_borrow(&test_mbox, OS_TIMEOUT_INFINITE);
+   test_assert(msg[0]);
+   test_assert(0 == isr_commit);
+   test_assert(msg[0]->self == msg[0]);
+   test_assert(0xBEEF == msg[0]->seq);
+   os_mbox_release(&test_mbox, msg[0]);
+
+/* scenario 4 */
+   os_task_create(
+      &task_worker[0], 1,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen4_waiter, NULL);
+   os_task_create(
+      &task_worker[1], 1,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen4_destroyer, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Mbox");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
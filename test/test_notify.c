@@ -0,0 +1,232 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os task notification routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_LOOPS ((uint16_t)1000)
+
+static os_task_t task_worker[2];
+static OS_TASKSTACK task_stack[2][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static volatile sig_atomic_t test_atomic;
+static volatile sig_atomic_t isr_notify;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Tick callback, notifies the coordinator task from ISR on request
+ */
+static void test_tick(void)
+{
+   if (isr_notify) {
+      isr_notify = 0;
+      os_task_notify(&task_coordinator, 0x80, OS_NOTIFY_SETBITS);
+   }
+}
+
+/**
+ * Test scenario:
+ * Higher prio task uses the notification word as counting semaphore. Lower
+ * prio task notifies it and checks that notified task preempts it immediately
+ */
+int test_scen2_receiver(void *OS_UNUSED(param))
+{
+   os_retcode_t ret;
+   uint32_t value;
+   uint16_t i;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      ret = os_task_notify_wait(UINT32_MAX, OS_TIMEOUT_INFINITE, &value);
+      test_assert(OS_OK == ret);
+      test_assert(1 == value);
+      test_atomic++;
+   }
+
+   return 0;
+}
+
+int test_scen2_sender(void *OS_UNUSED(param))
+{
+   uint16_t i;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      test_assert(i == test_atomic);
+      os_task_notify(&task_worker[0], 1, OS_NOTIFY_INCREMENT);
+      /* receiver has higher prio so it already consumed the notification */
+      test_assert(i + 1 == test_atomic);
+
+      /* add randomness to test, force task switch with 50% of probability */
+      if (0 == (rand() % 2)) test_reqtick();
+   }
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Two tasks with the same prio notify each other in ping-pong manner while
+ * forced preemption is ongoing. None of notifications can be lost
+ */
+int test_scen3_pingpong(void *param)
+{
+   os_retcode_t ret;
+   uint32_t value;
+   uint16_t i;
+   uintptr_t idx = (uintptr_t)param;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      if (0 == idx)
+         os_task_notify(&task_worker[1], i, OS_NOTIFY_OVERWRITE);
+
+      ret = os_task_notify_wait(UINT32_MAX, OS_TIMEOUT_INFINITE, &value);
+      test_assert(OS_OK == ret);
+      test_assert(i == value);
+
+      if (1 == idx)
+         os_task_notify(&task_worker[0], i, OS_NOTIFY_OVERWRITE);
+
+      if (0 == (rand() % 2)) test_reqtick();
+   }
+
+   return 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   os_retcode_t ret;
+   uint32_t value;
+   uint16_t i;
+   os_ticks_t ticks_start;
+
+/* scenario 1 */
+   /* notifications are accumulated until they will be consumed */
+   ret = os_task_notify_wait(0, OS_TIMEOUT_TRY, &value);
+   test_assert(OS_WOULDBLOCK == ret);
+   os_task_notify(task_current, 0x1, OS_NOTIFY_SETBITS);
+   os_task_notify(task_current, 0x6, OS_NOTIFY_SETBITS);
+   ret = os_task_notify_wait(0x1, OS_TIMEOUT_TRY, &value);
+   test_assert(OS_OK == ret);
+   test_assert(0x7 == value);
+   /* notification was consumed while bits from outside of clear_mask stay */
+   ret = os_task_notify_wait(0, OS_TIMEOUT_TRY, &value);
+   test_assert(OS_WOULDBLOCK == ret);
+   os_task_notify(task_current, 3, OS_NOTIFY_INCREMENT);
+   ret = os_task_notify_wait(0, OS_TIMEOUT_INFINITE, NULL);
+   test_assert(OS_OK == ret);
+   os_task_notify(task_current, 42, OS_NOTIFY_INCREMENT);
+   ret = os_task_notify_wait(UINT32_MAX, OS_TIMEOUT_INFINITE, &value);
+   test_assert(OS_OK == ret);
+   test_assert(0x6 + 3 + 42 == value);
+   os_task_notify(task_current, 0x55, OS_NOTIFY_OVERWRITE);
+   ret = os_task_notify_wait(UINT32_MAX, OS_TIMEOUT_TRY, &value);
+   test_assert(OS_OK == ret);
+   test_assert(0x55 == value);
+
+/* scenario 2 */
+   test_atomic = 0;
+   os_task_create(
+      &task_worker[0], 2,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen2_receiver, NULL);
+   os_task_create(
+      &task_worker[1], 1,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen2_sender, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(TEST_LOOPS == test_atomic);
+
+/* scenario 3 */
+   for (i = 0; i < 2; i++) {
+      os_task_create(
+         &task_worker[i], 1,
+         task_stack[i], sizeof(task_stack[i]),
+         test_scen3_pingpong, (void*)(uintptr_t)i);
+   }
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+
+/* scenario 4 */
+   /* suspend with timeout, nobody will notify us */
+   test_setuptick(test_tick, 1000000);
+   ticks_start = os_ticks_now();
+   ret = os_task_notify_wait(0, 5, &value);
+   test_assert(OS_TIMEOUT == ret);
+   test_assert(os_ticks_diff(ticks_start, os_ticks_now()) >= 4);
+
+   /* notification from ISR */
+   isr_notify = 1;
+   ret = os_task_notify_wait(UINT32_MAX, OS_TIMEOUT_INFINITE, &value);
+   test_assert(OS_OK == ret);
+   test_assert(0x80 == value);
+   test_assert(0 == isr_notify);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Notify");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
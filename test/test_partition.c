@@ -0,0 +1,215 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test of time partitions
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_TASKCNT ((size_t)2)
+#define TEST_MAJORFRAME ((os_ticks_t)6)
+#define TEST_RUNTICKS (10 * TEST_MAJORFRAME)
+
+static os_task_t task_coordinator;
+static os_task_t task_worker[TEST_TASKCNT];
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK worker_stack[TEST_TASKCNT][OS_STACK_MINSIZE];
+
+static os_partition_t test_partition[TEST_TASKCNT];
+static os_sem_t test_sem;
+static volatile bool test_stop;
+static volatile unsigned test_exited;
+static volatile os_ticks_t worker_ticks[TEST_TASKCNT];
+
+/* major frame with windows of both partitions and background window */
+static const os_partition_window_t test_table[] = {
+   { .partition = &test_partition[0], .duration = 3 },
+   { .partition = &test_partition[1], .duration = 2 },
+   { .partition = NULL, .duration = 1 },
+};
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Task which never blocks. Ticks are generated only by running task, so each
+ * tick generated by this task was spent in window of its partition
+ */
+static int worker_proc(void *param)
+{
+   size_t idx = (size_t)(uintptr_t)param;
+
+   while (!test_stop) {
+      test_reqtick();
+      /* task runs only inside of windows of its partition */
+      test_assert(&test_partition[idx] == os_partition_active());
+      ++worker_ticks[idx];
+   }
+   ++test_exited;
+   return 0;
+}
+
+/**
+ * Worker which spends whole time blocked, so its windows are slack
+ */
+static int waiter_proc(void *OS_UNUSED(param))
+{
+   test_assert(OS_OK == os_sem_down(&test_sem, OS_TIMEOUT_INFINITE));
+   test_assert(&test_partition[1] == os_partition_active());
+   ++test_exited;
+   return 0;
+}
+
+static void test_workers_stop(void)
+{
+   test_stop = true;
+   while (test_exited < TEST_TASKCNT)
+      test_reqtick();
+   os_partition_schedule(NULL, 0);
+   os_task_join(&task_worker[0]);
+   os_task_join(&task_worker[1]);
+}
+
+/**
+ * Test coordinator, runs all test in unit. It runs in background partition
+ * with priority higher than workers, so it can run only in background windows
+ * or slack of partitions
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   os_ticks_t start;
+   unsigned loops;
+   size_t i;
+
+   os_sem_create(&test_sem, 0);
+   for (i = 0; i < TEST_TASKCNT; i++)
+      os_partition_create(&test_partition[i]);
+
+/* scenario 1 */
+   /* each partition gets exactly its windows, regardless of priorities */
+   os_scheduler_lock();
+   for (i = 0; i < TEST_TASKCNT; i++) {
+      os_task_create(
+         &task_worker[i], 1, worker_stack[i], sizeof(worker_stack[i]),
+         worker_proc, (void*)(uintptr_t)i);
+      os_partition_assign(&test_partition[i], &task_worker[i]);
+   }
+   os_scheduler_unlock(false);
+   test_assert(NULL == os_partition_active());
+
+   loops = 0;
+   os_partition_schedule(
+      test_table, sizeof(test_table) / sizeof(test_table[0]));
+   /* coordinator continues inside of background window */
+   worker_ticks[0] = 0;
+   worker_ticks[1] = 0;
+   start = os_ticks_now();
+   while (os_ticks_diff(start, os_ticks_now()) < TEST_RUNTICKS) {
+      test_assert(NULL == os_partition_active());
+      test_reqtick();
+      ++loops;
+   }
+   test_assert(worker_ticks[0] >= 29);
+   test_assert(worker_ticks[0] <= 31);
+   test_assert(worker_ticks[1] >= 19);
+   test_assert(worker_ticks[1] <= 21);
+   test_assert(loops >= 9);
+   test_assert(loops <= 11);
+   test_workers_stop();
+
+/* scenario 2 */
+   /* windows of partition without READY task are used by background tasks */
+   test_stop = false;
+   test_exited = 0;
+   os_scheduler_lock();
+   os_task_create(
+      &task_worker[0], 1, worker_stack[0], sizeof(worker_stack[0]),
+      worker_proc, (void*)(uintptr_t)0);
+   os_partition_assign(&test_partition[0], &task_worker[0]);
+   os_task_create(
+      &task_worker[1], 1, worker_stack[1], sizeof(worker_stack[1]),
+      waiter_proc, NULL);
+   os_partition_assign(&test_partition[1], &task_worker[1]);
+   os_scheduler_unlock(false);
+
+   loops = 0;
+   os_partition_schedule(
+      test_table, sizeof(test_table) / sizeof(test_table[0]));
+   worker_ticks[0] = 0;
+   start = os_ticks_now();
+   while (os_ticks_diff(start, os_ticks_now()) < TEST_RUNTICKS) {
+      test_assert(&test_partition[0] != os_partition_active());
+      test_reqtick();
+      ++loops;
+   }
+   test_assert(worker_ticks[0] >= 29);
+   test_assert(worker_ticks[0] <= 31);
+   test_assert(loops >= 29);
+   test_assert(loops <= 31);
+
+   /* woken up task of inactive partition waits for its window */
+   os_sem_up(&test_sem);
+   test_assert((1 == test_exited) ==
+               (&test_partition[1] == os_partition_active()));
+   test_workers_stop();
+
+   os_sem_destroy(&test_sem);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 2,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Partition");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
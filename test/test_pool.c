@@ -0,0 +1,291 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os memory pool routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_LOOPS ((uint16_t)2000)
+#define TEST_BLOCKS ((size_t)8)
+#define TEST_BLOCKSIZE ((size_t)4 * sizeof(uintptr_t))
+
+static os_task_t task_worker[5];
+static OS_TASKSTACK task_stack[5][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_pool_t test_pool;
+static uintptr_t test_mem[TEST_BLOCKS][TEST_BLOCKSIZE / sizeof(uintptr_t)];
+static void *test_block[TEST_BLOCKS];
+static volatile sig_atomic_t isr_stress;
+static volatile sig_atomic_t isr_allocs;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Function fills the block with owner marker
+ */
+static void test_block_fill(void *block, uintptr_t marker)
+{
+   uintptr_t *p = (uintptr_t*)block;
+   size_t i;
+
+   for (i = 0; i < TEST_BLOCKSIZE / sizeof(uintptr_t); i++)
+      p[i] = marker;
+}
+
+/**
+ * Function checks if block still contain the owner marker
+ */
+static void test_block_check(void *block, uintptr_t marker)
+{
+   uintptr_t *p = (uintptr_t*)block;
+   size_t i;
+
+   for (i = 0; i < TEST_BLOCKSIZE / sizeof(uintptr_t); i++)
+      test_assert(marker == p[i]);
+}
+
+/**
+ * Tick callback, allocates and frees the block from ISR during stress test
+ */
+static void test_tick(void)
+{
+   void *block;
+
+   if (isr_stress) {
+      block = os_pool_alloc(&test_pool);
+      if (block) {
+         test_block_fill(block, (uintptr_t)-1);
+         test_block_check(block, (uintptr_t)-1);
+         os_pool_free(&test_pool, block);
+         isr_allocs++;
+      }
+   }
+}
+
+/**
+ * Test scenario:
+ * Tasks and ISR allocate and free blocks with forced preemption. Each owner
+ * fills the block with its marker and checks that nobody else got the same
+ * block in meantime
+ */
+int test_scen2_worker(void *param)
+{
+   void *block[2];
+   uint16_t i;
+   uintptr_t marker = (uintptr_t)param;
+   /* rand() takes the libc lock, so it cannot be used while tick may preempt
+    * the task in middle of it */
+   unsigned int seed = marker;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      block[0] = os_pool_alloc_wait(&test_pool, OS_TIMEOUT_INFINITE);
+      test_assert(block[0]);
+      test_block_fill(block[0], marker);
+      block[1] = os_pool_alloc(&test_pool);
+
+      /* force task switch to check if other owners will not get our block */
+      if (0 == (rand_r(&seed) % 2)) test_reqtick();
+
+      test_block_check(block[0], marker);
+      os_pool_free(&test_pool, block[0]);
+      if (block[1])
+         os_pool_free(&test_pool, block[1]);
+
+      if (0 == (rand_r(&seed) % 2)) test_reqtick();
+   }
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Higher prio task waits for free block, lower prio task frees the block which
+ * is handed over directly to waiter (preemption happens right away)
+ */
+int test_scen3_waiter(void *OS_UNUSED(param))
+{
+   void *block;
+
+   block = os_pool_alloc_wait(&test_pool, OS_TIMEOUT_INFINITE);
+   test_assert(test_block[0] == block);
+   test_block[0] = NULL;
+
+   return 0;
+}
+
+int test_scen3_freeer(void *OS_UNUSED(param))
+{
+   void *block = test_block[0];
+
+   os_pool_free(&test_pool, block);
+   /* waiter got the block and already run */
+   test_assert(NULL == test_block[0]);
+   test_assert(NULL == os_pool_alloc(&test_pool));
+   test_block[0] = block;
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Destroy of memory pool releases the suspended tasks. Destroyer is created
+ * after the waiter with the same prio, so waiter is already suspended
+ */
+int test_scen4_waiter(void *OS_UNUSED(param))
+{
+   test_assert(NULL == os_pool_alloc_wait(&test_pool, OS_TIMEOUT_INFINITE));
+
+   return 0;
+}
+
+int test_scen4_destroyer(void *OS_UNUSED(param))
+{
+   os_pool_destroy(&test_pool);
+
+   return 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   size_t i, j;
+   os_ticks_t ticks_start;
+
+/* scenario 1 */
+   /* allocate all blocks, each must be unique and inside of memory region */
+   os_pool_create(&test_pool, test_mem, TEST_BLOCKSIZE, TEST_BLOCKS);
+   for (i = 0; i < TEST_BLOCKS; i++) {
+      test_block[i] = os_pool_alloc(&test_pool);
+      test_assert(test_block[i]);
+      test_assert((uint8_t*)test_block[i] >= (uint8_t*)test_mem);
+      test_assert((uint8_t*)test_block[i] < (uint8_t*)test_mem + sizeof(test_mem));
+      for (j = 0; j < i; j++)
+         test_assert(test_block[i] != test_block[j]);
+      test_block_fill(test_block[i], i);
+   }
+   test_assert(NULL == os_pool_alloc(&test_pool));
+   test_assert(NULL == os_pool_alloc_wait(&test_pool, OS_TIMEOUT_TRY));
+   for (i = 0; i < TEST_BLOCKS; i++) {
+      test_block_check(test_block[i], i);
+      os_pool_free(&test_pool, test_block[i]);
+   }
+   /* free list is LIFO */
+   test_assert(test_block[TEST_BLOCKS - 1] == os_pool_alloc(&test_pool));
+   os_pool_free(&test_pool, test_block[TEST_BLOCKS - 1]);
+
+/* scenario 2 */
+   test_setuptick(test_tick, 100000);
+   isr_stress = 1;
+   for (i = 0; i < 5; i++) {
+      os_task_create(
+         &task_worker[i], 1,
+         task_stack[i], sizeof(task_stack[i]),
+         test_scen2_worker, (void*)(i + 1));
+   }
+   for (i = 0; i < 5; i++)
+      os_task_join(&task_worker[i]);
+   isr_stress = 0;
+   test_debug("ISR allocations %u", (unsigned)isr_allocs);
+   /* all blocks must be back on free list */
+   for (i = 0; i < TEST_BLOCKS; i++)
+      test_assert(os_pool_alloc(&test_pool));
+   test_assert(NULL == os_pool_alloc(&test_pool));
+   os_pool_destroy(&test_pool);
+
+/* scenario 3 */
+   os_pool_create(&test_pool, test_mem, TEST_BLOCKSIZE, 1);
+   test_block[0] = os_pool_alloc(&test_pool);
+   os_task_create(
+      &task_worker[0], 2,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen3_waiter, NULL);
+   os_task_create(
+      &task_worker[1], 1,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen3_freeer, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+
+   /* pool is empty, nobody will free the block */
+   ticks_start = os_ticks_now();
+   test_assert(NULL == os_pool_alloc_wait(&test_pool, 5));
+   test_assert(os_ticks_diff(ticks_start, os_ticks_now()) >= 4);
+
+/* scenario 4 */
+   os_task_create(
+      &task_worker[0], 1,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen4_waiter, NULL);
+   os_task_create(
+      &task_worker[1], 1,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen4_destroyer, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Pool");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
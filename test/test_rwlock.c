@@ -0,0 +1,564 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os rwlock routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_LOOPS ((uint16_t)1000)
+#define TEST_BENCH_TICKS ((os_ticks_t)500)
+#define TEST_BENCH_DATA ((uint_fast8_t)32)
+
+static os_task_t task_worker[4];
+static OS_TASKSTACK task_stack[4][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+static os_rwlock_t test_rwlock;
+static os_mtx_t test_mtx;
+static os_sem_t test_sem[3];
+
+static volatile sig_atomic_t test_atomic[2];
+static volatile unsigned long test_bench_ops[4];
+static volatile uint16_t test_bench_data[TEST_BENCH_DATA];
+static volatile bool test_bench_mtx;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Test scenario:
+ * Readers and writer with the same priority compete for rwlock with forced
+ * preemption inside of critical section. test_atomic[0] counts readers inside
+ * of the critical section while test_atomic[1] marks writer inside. Readers
+ * may share the critical section but never with writer.
+ */
+int test_scen1_reader(void *OS_UNUSED(param))
+{
+   int ret;
+   uint16_t i;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      ret = os_rwlock_rdlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+      test_assert(0 == ret);
+
+      test_assert(0 == test_atomic[1]);
+      test_atomic[0]++;
+
+      /* force task switch to check if rwlock properly secures the critical
+       * section */
+      test_reqtick();
+
+      test_assert(0 == test_atomic[1]);
+      test_atomic[0]--;
+      os_rwlock_unlock(&test_rwlock);
+
+      /* add randomness to test, force task switch with 50% of probability */
+      if (0 == (rand() % 2)) test_reqtick();
+   }
+
+   return 0;
+}
+
+int test_scen1_writer(void *OS_UNUSED(param))
+{
+   int ret;
+   uint16_t i;
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      ret = os_rwlock_wrlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+      test_assert(0 == ret);
+
+      test_assert(0 == test_atomic[0]);
+      test_assert(0 == test_atomic[1]);
+      test_atomic[1] = 1;
+
+      test_reqtick();
+
+      test_assert(0 == test_atomic[0]);
+      test_assert(1 == test_atomic[1]);
+      test_atomic[1] = 0;
+      os_rwlock_unlock(&test_rwlock);
+
+      if (0 == (rand() % 2)) test_reqtick();
+   }
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Shared access, writer preference and priority inheritance.
+ * Four tasks RH (prio 4), W (prio 3), RM (prio 3) and RL (prio 1).
+ * RL locks for read, then W suspends on write lock and boost the prio of RL.
+ * RH may still pass the waiting writer (it has higher prio) but RM cannot,
+ * since it has the same prio as the waiting writer. When RL unlocks, W is
+ * preferred over RM and RL gets back its original prio.
+ */
+int test_scen2_workerRH(void *OS_UNUSED(param))
+{
+   int ret;
+
+   ret = os_sem_down(&test_sem[1], OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   /* we should be woken up by RL */
+   test_assert(3 == test_atomic[0]);
+
+   /* RL still owns the rwlock, so we cannot get the exclusive access */
+   ret = os_rwlock_wrlock(&test_rwlock, OS_TIMEOUT_TRY);
+   test_assert(OS_WOULDBLOCK == ret);
+
+   /* but we can share the rwlock with RL even if W is waiting since we have
+    * higher prio than W */
+   ret = os_rwlock_rdlock(&test_rwlock, OS_TIMEOUT_TRY);
+   test_assert(0 == ret);
+   test_atomic[0] = 4;
+
+   /* no context switch, W is still blocked by RL */
+   os_rwlock_unlock(&test_rwlock);
+   test_assert(4 == test_atomic[0]);
+   test_atomic[0] = 5;
+
+   return 0;
+}
+
+int test_scen2_workerW(void *OS_UNUSED(param))
+{
+   int ret;
+
+   ret = os_sem_down(&test_sem[0], OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   test_assert(1 == test_atomic[0]);
+   test_atomic[0] = 2;
+
+   /* this will block and boost the prio of RL */
+   ret = os_rwlock_wrlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   /* we should get the rwlock before RM */
+   test_assert(8 == test_atomic[0]);
+   test_atomic[0] = 9;
+
+   /* pass the rwlock to RM, no context switch since RM has the same prio */
+   os_rwlock_unlock(&test_rwlock);
+   test_assert(9 == test_atomic[0]);
+   test_atomic[0] = 10;
+
+   /* by finishing the task we should switch to RM */
+   return 0;
+}
+
+int test_scen2_workerRM(void *OS_UNUSED(param))
+{
+   int ret;
+
+   ret = os_sem_down(&test_sem[2], OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   test_assert(6 == test_atomic[0]);
+
+   /* W is waiting with the same prio, we cannot pass it */
+   ret = os_rwlock_rdlock(&test_rwlock, OS_TIMEOUT_TRY);
+   test_assert(OS_WOULDBLOCK == ret);
+   test_atomic[0] = 7;
+
+   /* this will block, we should be woken up by W */
+   ret = os_rwlock_rdlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   test_assert(10 == test_atomic[0]);
+   test_atomic[0] = 11;
+   os_rwlock_unlock(&test_rwlock);
+
+   return 0;
+}
+
+int test_scen2_workerRL(void *OS_UNUSED(param))
+{
+   int ret;
+
+   test_assert(0 == test_atomic[0]);
+
+   ret = os_rwlock_rdlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+   test_atomic[0] = 1;
+
+   /* switch context to W */
+   os_sem_up(&test_sem[0]);
+
+   /* we will return here when W will block on rwlock, our prio should be
+    * boosted to p(W) */
+   test_assert(2 == test_atomic[0]);
+   test_assert(3 == task_worker[3].prio_current);
+   test_atomic[0] = 3;
+
+   /* switch context to RH */
+   os_sem_up(&test_sem[1]);
+
+   /* we will return here when RH finishes */
+   test_assert(5 == test_atomic[0]);
+   test_atomic[0] = 6;
+
+   /* wake up RM, no context switch since we have boosted prio equal to RM */
+   os_sem_up(&test_sem[2]);
+   test_assert(6 == test_atomic[0]);
+
+   /* force round robin to RM */
+   test_reqtick();
+
+   /* we will return here when RM will block on rwlock */
+   test_assert(7 == test_atomic[0]);
+   test_atomic[0] = 8;
+
+   /* this should pass rwlock to W, reset our prio and switch to W */
+   os_rwlock_unlock(&test_rwlock);
+
+   /* we will return here when W and RM finish */
+   test_assert(11 == test_atomic[0]);
+   test_assert(1 == task_worker[3].prio_current);
+   test_atomic[0] = 12;
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Writer timeout. RL locks for read and W (prio 3) suspends on write lock with
+ * timeout. Then RM (prio 3) suspends on read lock because of waiting writer.
+ * Once W timeouts, RM should get the rwlock even if RL still owns it.
+ */
+int test_scen3_workerW(void *OS_UNUSED(param))
+{
+   int ret;
+
+   ret = os_sem_down(&test_sem[0], OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   ret = os_rwlock_wrlock(&test_rwlock, 3);
+   test_assert(OS_TIMEOUT == ret);
+   test_atomic[0]++;
+
+   return 0;
+}
+
+int test_scen3_workerRM(void *OS_UNUSED(param))
+{
+   int ret;
+   os_ticks_t ticks_start;
+
+   ret = os_sem_down(&test_sem[1], OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   /* W is waiting, we have to wait until W timeouts */
+   ticks_start = os_ticks_now();
+   ret = os_rwlock_rdlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+   test_assert(os_ticks_diff(ticks_start, os_ticks_now()) >= 2);
+   test_atomic[0]++;
+   os_rwlock_unlock(&test_rwlock);
+
+   return 0;
+}
+
+int test_scen3_workerRL(void *OS_UNUSED(param))
+{
+   int ret;
+
+   ret = os_rwlock_rdlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   /* switch context to W, which will block on rwlock */
+   os_sem_up(&test_sem[0]);
+   test_assert(3 == task_worker[2].prio_current);
+
+   /* wake up RM, it will run on next tick and block on rwlock */
+   os_sem_up(&test_sem[1]);
+
+   /* tick until both W and RM finish */
+   while (2 != test_atomic[0])
+      test_reqtick();
+
+   /* our prio is restored when we unlock */
+   os_rwlock_unlock(&test_rwlock);
+   test_assert(1 == task_worker[2].prio_current);
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Destroying of owned rwlock. L locks for write, H suspends on read lock, L
+ * destroys the rwlock which should wake up H with OS_DESTROYED
+ */
+int test_scen4_workerH(void *OS_UNUSED(param))
+{
+   int ret;
+
+   ret = os_sem_down(&test_sem[0], OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+
+   test_assert(1 == test_atomic[0]);
+   test_atomic[0] = 2;
+
+   ret = os_rwlock_rdlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+   test_assert(OS_DESTROYED == ret);
+   test_assert(3 == test_atomic[0]);
+   test_atomic[0] = 4;
+
+   return 0;
+}
+
+int test_scen4_workerL(void *OS_UNUSED(param))
+{
+   int ret;
+
+   ret = os_rwlock_wrlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+   test_atomic[0] = 1;
+
+   /* switch context to H */
+   os_sem_up(&test_sem[0]);
+
+   test_assert(2 == test_atomic[0]);
+   test_assert(3 == task_worker[1].prio_current);
+   test_atomic[0] = 3;
+
+   /* this will wake up H and switch to it */
+   os_rwlock_destroy(&test_rwlock);
+
+   test_assert(4 == test_atomic[0]);
+   test_assert(1 == task_worker[1].prio_current);
+   test_atomic[0] = 5;
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Throughput benchmark for read-mostly workload. Tasks with the same prio
+ * lock the shared data for read in 15 of 16 iterations and for write
+ * otherwise, while periodic tick preempts them. The same workload is executed
+ * with os_rwlock_t and os_mtx_t, number of completed operations is reported.
+ */
+int test_scen5_worker(void *param)
+{
+   int ret;
+   uintptr_t task_idx = (uintptr_t)param;
+   os_ticks_t ticks_start = os_ticks_now();
+   unsigned long ops = 0;
+   uint_fast8_t i;
+   uint16_t sum;
+   bool write;
+
+   while (os_ticks_diff(ticks_start, os_ticks_now()) < TEST_BENCH_TICKS) {
+      write = (0 == (ops % 16));
+
+      if (test_bench_mtx) {
+         ret = os_mtx_lock(&test_mtx);
+      } else if (write) {
+         ret = os_rwlock_wrlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+      } else {
+         ret = os_rwlock_rdlock(&test_rwlock, OS_TIMEOUT_INFINITE);
+      }
+      test_assert(0 == ret);
+
+      if (write) {
+         for (i = 0; i < TEST_BENCH_DATA; i++)
+            test_bench_data[i]++;
+      } else {
+         /* all entries are always updated together */
+         for (i = 0, sum = 0; i < TEST_BENCH_DATA; i++)
+            sum += test_bench_data[i] - test_bench_data[0];
+         test_assert(0 == sum);
+      }
+
+      if (test_bench_mtx) {
+         os_mtx_unlock(&test_mtx);
+      } else {
+         os_rwlock_unlock(&test_rwlock);
+      }
+      ++ops;
+   }
+   test_bench_ops[task_idx] = ops;
+
+   return 0;
+}
+
+static unsigned long test_scen5_run(bool use_mtx)
+{
+   uint16_t i;
+   unsigned long ops = 0;
+
+   test_bench_mtx = use_mtx;
+   for (i = 0; i < 4; i++) {
+      os_task_create(
+         &task_worker[i], 1,
+         task_stack[i], sizeof(task_stack[i]),
+         test_scen5_worker, (void*)(uintptr_t)i);
+   }
+   for (i = 0; i < 4; i++) {
+      os_task_join(&task_worker[i]);
+      ops += test_bench_ops[i];
+   }
+
+   return ops;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   uint16_t i;
+   unsigned long ops_rwlock;
+   unsigned long ops_mtx;
+
+/* scenario 1 */
+   os_rwlock_create(&test_rwlock);
+   test_atomic[0] = 0;
+   test_atomic[1] = 0;
+   for (i = 0; i < 4; i++) {
+      /* created task will be not scheduled because current task has the highest
+       * available priority */
+      os_task_create(
+         &task_worker[i], 1,
+         task_stack[i], sizeof(task_stack[i]),
+         (0 == i) ? test_scen1_writer : test_scen1_reader, NULL);
+   }
+   /* scheduler will kick in after following call */
+   for (i = 0; i < 4; i++)
+      os_task_join(&task_worker[i]);
+   os_rwlock_destroy(&test_rwlock);
+
+/* scenario 2 */
+   os_taskproc_t scen2_worker_proc[] = {
+      test_scen2_workerRH,
+      test_scen2_workerW,
+      test_scen2_workerRM,
+      test_scen2_workerRL
+   };
+   const uint_fast8_t scen2_worker_prio[] = { 4, 3, 3, 1 };
+   os_rwlock_create(&test_rwlock);
+   test_atomic[0] = 0;
+   for (i = 0; i < 3; i++)
+      os_sem_create(&test_sem[i], 0);
+   for (i = 0; i < 4; i++) {
+      os_task_create(
+         &task_worker[i], scen2_worker_prio[i],
+         task_stack[i], sizeof(task_stack[i]),
+         scen2_worker_proc[i], NULL);
+   }
+   for (i = 0; i < 4; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(12 == test_atomic[0]);
+   os_rwlock_destroy(&test_rwlock);
+
+/* scenario 3 */
+   os_taskproc_t scen3_worker_proc[] = {
+      test_scen3_workerW,
+      test_scen3_workerRM,
+      test_scen3_workerRL
+   };
+   const uint_fast8_t scen3_worker_prio[] = { 3, 3, 1 };
+   os_rwlock_create(&test_rwlock);
+   test_atomic[0] = 0;
+   for (i = 0; i < 2; i++)
+      os_sem_create(&test_sem[i], 0);
+   for (i = 0; i < 3; i++) {
+      os_task_create(
+         &task_worker[i], scen3_worker_prio[i],
+         task_stack[i], sizeof(task_stack[i]),
+         scen3_worker_proc[i], NULL);
+   }
+   for (i = 0; i < 3; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(2 == test_atomic[0]);
+   os_rwlock_destroy(&test_rwlock);
+
+/* scenario 4 */
+   os_rwlock_create(&test_rwlock);
+   os_sem_create(&test_sem[0], 0);
+   test_atomic[0] = 0;
+   os_task_create(
+      &task_worker[0], 3,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen4_workerH, NULL);
+   os_task_create(
+      &task_worker[1], 1,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen4_workerL, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(5 == test_atomic[0]);
+
+/* scenario 5 */
+   os_rwlock_create(&test_rwlock);
+   os_mtx_create(&test_mtx);
+   test_setuptick(NULL, 1000000);
+   ops_rwlock = test_scen5_run(false);
+   ops_mtx = test_scen5_run(true);
+   test_debug("read-mostly ops in %u ticks: rwlock %lu mtx %lu",
+              (unsigned)TEST_BENCH_TICKS, ops_rwlock, ops_mtx);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Rwlock");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
@@ -0,0 +1,240 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os softirq routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+
+#include "os.h"
+#include "os_test.h"
+
+/* last softirq is reserved for deferred ISR posts */
+#define TEST_SOFTIRQCNT ((uint_fast8_t)4)
+
+typedef enum {
+   TEST_MODE_NONE,
+   TEST_MODE_BATCH,
+   TEST_MODE_WAKEUP,
+   TEST_MODE_NESTED,
+} test_mode_t;
+
+static os_task_t task_worker;
+static OS_TASKSTACK task_stack[OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_sem_t test_sem;
+static volatile test_mode_t test_mode;
+static volatile sig_atomic_t test_inhandler;
+static volatile sig_atomic_t test_nested;
+static volatile sig_atomic_t test_woken;
+static unsigned test_cnt[TEST_SOFTIRQCNT];
+static uint_fast8_t test_order[8];
+static uint_fast8_t test_ordercnt;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Tick callback, top half of interrupt handler which raises softirqs
+ */
+static void test_tick(void)
+{
+   uint_fast8_t i;
+
+   switch (test_mode) {
+   case TEST_MODE_BATCH:
+      /* handlers must not run before the top half finishes */
+      for (i = 0; i < 3; i++) {
+         os_softirq_raise(1);
+         os_softirq_raise(0);
+         os_softirq_raise(3);
+      }
+      for (i = 0; i < TEST_SOFTIRQCNT; i++)
+         test_assert(0 == test_cnt[i]);
+      break;
+
+   case TEST_MODE_WAKEUP:
+      os_softirq_raise(2);
+      break;
+
+   case TEST_MODE_NESTED:
+      if (1 == isr_nesting) {
+         os_softirq_raise(1);
+      } else {
+         /* interrupt nested into softirq handler */
+         test_assert(2 == isr_nesting);
+         test_nested = 1;
+         os_softirq_raise(3);
+         os_softirq_raise(1);
+      }
+      break;
+
+   default:
+      break;
+   }
+}
+
+/**
+ * Softirq handler, records the order of calls
+ */
+static void test_softirq(void *param)
+{
+   uint_fast8_t nr = (uint_fast8_t)(uintptr_t)param;
+
+   /* softirqs run in context of most outer ISR with interrupts enabled and
+    * they never nest */
+   test_assert(1 == isr_nesting);
+   test_assert(!arch_is_dint());
+   test_assert(!test_inhandler);
+   test_inhandler = 1;
+
+   test_order[test_ordercnt++ % 8] = nr;
+   ++test_cnt[nr];
+
+   if (2 == nr) {
+      os_sem_up(&test_sem);
+   } else if ((TEST_MODE_NESTED == test_mode) && (1 == nr) && !test_nested) {
+      /* interrupts are enabled so the tick will nest */
+      test_reqtick();
+      test_assert(test_nested);
+   }
+
+   test_inhandler = 0;
+}
+
+/**
+ * Test scenario:
+ * Lower priority task triggers the interrupt which raises the softirq. Softirq
+ * handler wakes up the higher priority task, which must run before the
+ * interrupted task resumes
+ */
+int test_scen2_worker(void *OS_UNUSED(param))
+{
+   test_mode = TEST_MODE_WAKEUP;
+   test_reqtick();
+   test_assert(test_woken);
+   test_assert(1 == test_cnt[2]);
+
+   return 0;
+}
+
+static void test_reset(void)
+{
+   memset(test_cnt, 0, sizeof(test_cnt));
+   test_ordercnt = 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   uint_fast8_t i;
+
+   os_sem_create(&test_sem, 0);
+   for (i = 0; i < TEST_SOFTIRQCNT; i++)
+      os_softirq_register(i, test_softirq, (void*)(uintptr_t)i);
+   test_setuptick(test_tick, 0);
+
+/* scenario 1 */
+   /* multiple raises are batched, handlers run by priority before task
+    * resumes */
+   test_reset();
+   test_mode = TEST_MODE_BATCH;
+   test_reqtick();
+   test_mode = TEST_MODE_NONE;
+   test_assert(3 == test_ordercnt);
+   test_assert((3 == test_order[0]) &&
+               (1 == test_order[1]) &&
+               (0 == test_order[2]));
+   test_assert((1 == test_cnt[0]) && (1 == test_cnt[1]) &&
+               (0 == test_cnt[2]) && (1 == test_cnt[3]));
+
+   /* no pending softirqs, nothing runs */
+   test_reqtick();
+   test_assert(3 == test_ordercnt);
+
+/* scenario 2 */
+   test_reset();
+   os_task_create(
+      &task_worker, 1,
+      task_stack, sizeof(task_stack),
+      test_scen2_worker, NULL);
+   test_assert(OS_OK == os_sem_down(&test_sem, OS_TIMEOUT_INFINITE));
+   test_woken = 1;
+   os_task_join(&task_worker);
+   test_mode = TEST_MODE_NONE;
+
+/* scenario 3 */
+   /* interrupt nested in softirq handler raises more softirqs, those are run
+    * after current handler returns (no nesting of handlers), also the one
+    * which is currently running */
+   test_reset();
+   test_mode = TEST_MODE_NESTED;
+   test_reqtick();
+   test_assert(test_nested);
+   test_mode = TEST_MODE_NONE;
+   test_assert(3 == test_ordercnt);
+   test_assert((1 == test_order[0]) &&
+               (3 == test_order[1]) &&
+               (1 == test_order[2]));
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Softirq");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
@@ -0,0 +1,310 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os stream buffer routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_SIZE ((arch_ridx_t)64)
+#define TEST_BYTES ((uint32_t)100000)
+#define TEST_ISRBYTES ((uint8_t)4)
+
+static os_task_t task_worker[2];
+static OS_TASKSTACK task_stack[2][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_stream_t test_stream;
+static uint8_t test_mem[TEST_SIZE];
+static volatile sig_atomic_t isr_write;
+static uint8_t isr_seq;
+static unsigned test_wakeups;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Tick callback, emulates the UART RX ISR which stores few bytes per tick
+ */
+static void test_tick(void)
+{
+   uint8_t *ptr;
+   arch_ridx_t len;
+   arch_ridx_t i;
+
+   if (isr_write) {
+      len = os_stream_write_acquire(&test_stream, &ptr);
+      if (len > TEST_ISRBYTES)
+         len = TEST_ISRBYTES;
+      for (i = 0; i < len; i++)
+         ptr[i] = isr_seq++;
+      os_stream_write_commit(&test_stream, len);
+   }
+}
+
+/**
+ * Test scenario:
+ * Producer writes the sequence of bytes in random chunks, consumer reads them
+ * in place and checks the sequence. Free running indexes overflow many times
+ * during the test
+ */
+int test_scen2_producer(void *OS_UNUSED(param))
+{
+   unsigned seed = 1;
+   uint32_t cnt = 0;
+   uint8_t *ptr;
+   arch_ridx_t len;
+   arch_ridx_t chunk;
+   arch_ridx_t i;
+
+   while (cnt < TEST_BYTES) {
+      len = os_stream_write_acquire(&test_stream, &ptr);
+      chunk = (arch_ridx_t)(rand_r(&seed) % 17);
+      if (chunk > len)
+         chunk = len;
+      if (chunk > TEST_BYTES - cnt)
+         chunk = (arch_ridx_t)(TEST_BYTES - cnt);
+      for (i = 0; i < chunk; i++)
+         ptr[i] = (uint8_t)(cnt + i);
+      os_stream_write_commit(&test_stream, chunk);
+      cnt += chunk;
+
+      /* flush the tail below trigger level */
+      if (TEST_BYTES - cnt < 8)
+         os_stream_set_trigger(&test_stream, 1);
+
+      if ((0 == chunk) || (0 == (rand_r(&seed) % 4))) test_reqtick();
+   }
+
+   return 0;
+}
+
+int test_scen2_consumer(void *OS_UNUSED(param))
+{
+   unsigned seed = 2;
+   uint32_t cnt = 0;
+   const uint8_t *ptr;
+   arch_ridx_t len;
+   arch_ridx_t i;
+
+   while (cnt < TEST_BYTES) {
+      len = os_stream_read_acquire(&test_stream, &ptr, OS_TIMEOUT_INFINITE);
+      test_assert(len > 0);
+      for (i = 0; i < len; i++)
+         test_assert((uint8_t)(cnt + i) == ptr[i]);
+      os_stream_read_release(&test_stream, len);
+      cnt += len;
+
+      if (0 == (rand_r(&seed) % 4)) test_reqtick();
+   }
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Destroy of stream releases the suspended consumer. Destroyer is created
+ * after the consumer with the same prio, so consumer is already suspended
+ */
+int test_scen4_waiter(void *OS_UNUSED(param))
+{
+   const uint8_t *ptr;
+
+   test_assert(0 == os_stream_read_acquire(
+      &test_stream, &ptr, OS_TIMEOUT_INFINITE));
+
+   return 0;
+}
+
+int test_scen4_destroyer(void *OS_UNUSED(param))
+{
+   os_stream_destroy(&test_stream);
+
+   return 0;
+}
+
+static void test_scen2_run(uint_fast8_t prod_prio, uint_fast8_t cons_prio)
+{
+   uint16_t i;
+   const uint8_t *ptr;
+
+   os_stream_set_trigger(&test_stream, 8);
+   os_task_create(
+      &task_worker[0], prod_prio,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen2_producer, NULL);
+   os_task_create(
+      &task_worker[1], cons_prio,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen2_consumer, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(0 == os_stream_read_acquire(&test_stream, &ptr, OS_TIMEOUT_TRY));
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   const uint8_t *rptr;
+   uint8_t *wptr;
+   os_ticks_t ticks_start;
+   arch_ridx_t len;
+   arch_ridx_t i;
+   uint8_t seq;
+
+   os_stream_create(&test_stream, test_mem, TEST_SIZE, 8);
+
+/* scenario 1 */
+   /* regions are contiguous and stop at the end of ring memory */
+   len = os_stream_write_acquire(&test_stream, &wptr);
+   test_assert(TEST_SIZE == len);
+   test_assert(test_mem == wptr);
+   os_stream_write_commit(&test_stream, 40);
+   test_assert(40 == os_stream_count(&test_stream));
+   len = os_stream_write_acquire(&test_stream, &wptr);
+   test_assert(TEST_SIZE - 40 == len);
+   test_assert(test_mem + 40 == wptr);
+   len = os_stream_read_acquire(&test_stream, &rptr, OS_TIMEOUT_TRY);
+   test_assert(40 == len);
+   test_assert(test_mem == rptr);
+   os_stream_read_release(&test_stream, 30);
+   /* free space wraps around, first region ends at the end of memory */
+   len = os_stream_write_acquire(&test_stream, &wptr);
+   test_assert(TEST_SIZE - 40 == len);
+   os_stream_write_commit(&test_stream, len);
+   len = os_stream_write_acquire(&test_stream, &wptr);
+   test_assert(30 == len);
+   test_assert(test_mem == wptr);
+   os_stream_write_commit(&test_stream, 30);
+   test_assert(TEST_SIZE == os_stream_count(&test_stream));
+   test_assert(0 == os_stream_write_acquire(&test_stream, &wptr));
+   /* data wraps around, second acquire returns the rest */
+   len = os_stream_read_acquire(&test_stream, &rptr, OS_TIMEOUT_INFINITE);
+   test_assert(TEST_SIZE - 30 == len);
+   test_assert(test_mem + 30 == rptr);
+   os_stream_read_release(&test_stream, len);
+   len = os_stream_read_acquire(&test_stream, &rptr, OS_TIMEOUT_TRY);
+   test_assert(30 == len);
+   test_assert(test_mem == rptr);
+   os_stream_read_release(&test_stream, len);
+   test_assert(0 == os_stream_count(&test_stream));
+
+/* scenario 2 */
+   /* producer never blocks, so it cannot have higher prio than consumer,
+    * otherwise it would spin on full ring */
+   test_scen2_run(1, 2);
+   test_scen2_run(1, 1);
+
+/* scenario 3 */
+   /* timeout below trigger level returns what is available */
+   test_setuptick(test_tick, 1000000);
+   os_stream_set_trigger(&test_stream, 8);
+   len = os_stream_write_acquire(&test_stream, &wptr);
+   wptr[0] = 0xAA;
+   wptr[1] = 0x55;
+   os_stream_write_commit(&test_stream, 2);
+   ticks_start = os_ticks_now();
+   len = os_stream_read_acquire(&test_stream, &rptr, 5);
+   test_assert(os_ticks_diff(ticks_start, os_ticks_now()) >= 4);
+   test_assert(2 == len);
+   test_assert((0xAA == rptr[0]) && (0x55 == rptr[1]));
+   os_stream_read_release(&test_stream, len);
+
+   /* ISR producer, consumer is woken only when trigger level is reached */
+   os_stream_set_trigger(&test_stream, 32);
+   isr_seq = 0;
+   seq = 0;
+   test_wakeups = 0;
+   isr_write = 1;
+   while (seq < 128) {
+      len = os_stream_read_acquire(&test_stream, &rptr, OS_TIMEOUT_INFINITE);
+      test_assert(len > 0);
+      ++test_wakeups;
+      /* collect the wrapped part without waiting */
+      do {
+         for (i = 0; i < len; i++)
+            test_assert(seq++ == rptr[i]);
+         os_stream_read_release(&test_stream, len);
+         len = os_stream_read_acquire(&test_stream, &rptr, OS_TIMEOUT_TRY);
+      } while (len > 0);
+   }
+   isr_write = 0;
+   test_debug("%u wakeups for %u bytes", test_wakeups, (unsigned)seq);
+   test_assert(test_wakeups <= 128 / 32);
+
+/* scenario 4 */
+   os_stream_set_trigger(&test_stream, 1);
+   os_task_create(
+      &task_worker[0], 1,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen4_waiter, NULL);
+   os_task_create(
+      &task_worker[1], 1,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen4_destroyer, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Stream");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
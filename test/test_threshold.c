@@ -0,0 +1,183 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test of preemption thresholds
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_PRIO_LOW ((uint_fast8_t)1)
+#define TEST_PRIO_MID ((uint_fast8_t)3)
+#define TEST_PRIO_HIGH ((uint_fast8_t)4)
+
+static os_task_t task_coordinator;
+static os_task_t task_low;
+static os_task_t task_mid;
+static os_task_t task_high;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK low_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK mid_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK high_stack[OS_STACK_MINSIZE];
+
+static os_sem_t sem_mid;
+static os_sem_t sem_high;
+static char test_order[8];
+static unsigned test_order_idx;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+static void test_record(char id)
+{
+   test_assert(test_order_idx < sizeof(test_order));
+   test_order[test_order_idx++] = id;
+}
+
+static int mid_proc(void *OS_UNUSED(param))
+{
+   test_assert(OS_OK == os_sem_down(&sem_mid, OS_TIMEOUT_INFINITE));
+   test_record('M');
+   return 0;
+}
+
+static int high_proc(void *OS_UNUSED(param))
+{
+   test_assert(OS_OK == os_sem_down(&sem_high, OS_TIMEOUT_INFINITE));
+   test_record('H');
+   return 0;
+}
+
+/**
+ * Task with threshold equal to priority of mid task, so mid task cannot
+ * preempt it, while high task can
+ */
+static int low_proc(void *OS_UNUSED(param))
+{
+   test_record('L');
+   os_sem_up(&sem_mid);
+   /* neither the tick cause the switch to mid task */
+   test_reqtick();
+   test_record('L');
+   os_sem_up(&sem_high);
+   /* after high task finishes we resume before mid task */
+   test_assert(TEST_PRIO_LOW == task_current->prio_current);
+   test_record('L');
+   return 0;
+}
+
+/**
+ * Task which removes its threshold while mid task is READY
+ */
+static int low_unset_proc(void *OS_UNUSED(param))
+{
+   test_record('L');
+   os_sem_up(&sem_mid);
+   test_record('L');
+   os_task_threshold_set(task_current, 0);
+   test_record('L');
+   return 0;
+}
+
+static void test_start(os_taskproc_t proc)
+{
+   test_order_idx = 0;
+   memset(test_order, 0, sizeof(test_order));
+   /* mid and high tasks preempt the coordinator and wait on semaphores */
+   os_task_create(
+      &task_mid, TEST_PRIO_MID, mid_stack, sizeof(mid_stack), mid_proc, NULL);
+   os_task_create(
+      &task_high, TEST_PRIO_HIGH, high_stack, sizeof(high_stack),
+      high_proc, NULL);
+   /* low task has the same priority as coordinator so it will not run until
+    * coordinator blocks in join */
+   os_task_create(
+      &task_low, TEST_PRIO_LOW, low_stack, sizeof(low_stack), proc, NULL);
+   os_task_threshold_set(&task_low, TEST_PRIO_MID);
+   os_task_join(&task_low);
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   os_sem_create(&sem_mid, 0);
+   os_sem_create(&sem_high, 0);
+
+/* scenario 1 */
+   /* task below threshold does not preempt, task above does and preempted
+    * task resumes before task below threshold */
+   test_start(low_proc);
+   os_task_join(&task_mid);
+   os_task_join(&task_high);
+   test_assert(0 == strcmp(test_order, "LLHLM"));
+
+/* scenario 2 */
+   /* removing the threshold allows for preemption */
+   test_start(low_unset_proc);
+   os_task_join(&task_mid);
+   os_sem_up(&sem_high);
+   os_task_join(&task_high);
+   test_assert(0 == strcmp(test_order, "LLMLH"));
+
+   os_sem_destroy(&sem_mid);
+   os_sem_destroy(&sem_high);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, TEST_PRIO_LOW,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Threshold");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
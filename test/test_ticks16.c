@@ -0,0 +1,219 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test of tick counter wrap around and cascaded timeouts, kernel is
+ *       build with OS_CONFIG_TICKS_WIDTH 16 so both happen in reasonable time
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_TIMEOUT_SHORT ((os_ticks_t)100)
+#define TEST_TIMEOUT_LONG ((os_ticks_t)(OS_TICKS_MAX - 1))
+#define TEST_DEADLINE ((os_ticks_t)20)
+#define TEST_SLACK ((os_ticks_t)10)
+
+static os_task_t task_coordinator;
+static os_task_t task_worker;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK worker_stack[OS_STACK_MINSIZE];
+
+static os_timer_t timer_short;
+static os_timer_t timer_long;
+static volatile uint64_t timer_short_fired;
+static volatile uint64_t timer_long_fired;
+static volatile unsigned timer_long_cnt;
+static volatile bool test_done;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+static void timer_short_proc(void *OS_UNUSED(param))
+{
+   timer_short_fired = os_ticks_now64();
+}
+
+static void timer_long_proc(void *OS_UNUSED(param))
+{
+   timer_long_fired = os_ticks_now64();
+   ++timer_long_cnt;
+}
+
+/**
+ * Generates ticks until tick counter reaches given value
+ */
+static void test_advance(os_ticks_t ticks)
+{
+   while (os_ticks_now() != ticks)
+      test_reqtick();
+}
+
+/**
+ * Generates ticks until long timer fires, checks the consistency of tick
+ * counter and its 64 bit extension at each tick
+ */
+static void test_wait_long(uint64_t start64)
+{
+   os_ticks_t start = (os_ticks_t)start64;
+   uint64_t n = 0;
+   unsigned cnt = timer_long_cnt;
+
+   while (cnt == timer_long_cnt) {
+      test_reqtick();
+      ++n;
+      test_assert(os_ticks_now64() == start64 + n);
+      test_assert(os_ticks_diff(start, os_ticks_now()) == (os_ticks_t)n);
+      test_assert(n <= (uint64_t)OS_TICKS_MAX);
+   }
+}
+
+/**
+ * Worker for scenario 3, deadline and relative timeouts across the wrap around
+ */
+static int worker_wrap(void *OS_UNUSED(param))
+{
+   os_ticks_t deadline;
+   os_ticks_t start;
+
+   deadline = os_ticks_now() + TEST_DEADLINE;
+   test_assert(deadline < os_ticks_now());
+   os_task_sleep_until(deadline);
+   test_assert(deadline == os_ticks_now());
+
+   test_advance(OS_TICKS_MAX - (TEST_DEADLINE / 2));
+   start = os_ticks_now();
+   os_task_sleep(TEST_DEADLINE);
+   test_assert(os_ticks_diff(start, os_ticks_now()) == TEST_DEADLINE);
+   test_assert(os_ticks_now() < start);
+
+   test_done = true;
+   return 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   uint64_t start64;
+
+   test_assert(UINT16_MAX == OS_TICKS_MAX);
+
+/* scenario 1 */
+   /* timeout longer than remaining ticks field can hold is cascaded, it burns
+    * off at exact tick while tick counter wraps around in the meantime.
+    * Shorter timer created later is not delayed by the cascaded one */
+   test_advance(1000);
+   start64 = os_ticks_now64();
+   test_assert(0 == (start64 >> 16));
+   os_timer_create(&timer_long, timer_long_proc, NULL, TEST_TIMEOUT_LONG, 0);
+   test_assert(timer_long.ticks_ext > 0);
+   os_timer_create(&timer_short, timer_short_proc, NULL, TEST_TIMEOUT_SHORT, 0);
+   test_wait_long(start64);
+   test_assert(start64 + TEST_TIMEOUT_SHORT == timer_short_fired);
+   test_assert(start64 + TEST_TIMEOUT_LONG == timer_long_fired);
+   test_assert(1 == (timer_long_fired >> 16));
+   test_assert(os_ticks_now() < (os_ticks_t)start64);
+   os_timer_destroy(&timer_short);
+   os_timer_destroy(&timer_long);
+
+/* scenario 2 */
+   /* reload period of auto reload timer is cascaded as well */
+   timer_long_cnt = 0;
+   start64 = os_ticks_now64();
+   os_timer_create(
+      &timer_long, timer_long_proc, NULL,
+      TEST_TIMEOUT_SHORT, TEST_TIMEOUT_LONG);
+   test_wait_long(start64);
+   test_assert(start64 + TEST_TIMEOUT_SHORT == timer_long_fired);
+   test_wait_long(start64 + TEST_TIMEOUT_SHORT);
+   test_assert(
+      start64 + TEST_TIMEOUT_SHORT + TEST_TIMEOUT_LONG == timer_long_fired);
+   test_assert(2 == timer_long_cnt);
+   test_assert(2 == (timer_long_fired >> 16));
+   os_timer_destroy(&timer_long);
+
+/* scenario 3 */
+   /* blocking timeouts which span across the wrap around */
+   test_advance(OS_TICKS_MAX - (TEST_DEADLINE / 2));
+   test_done = false;
+   os_task_create(
+      &task_worker, OS_CONFIG_PRIOCNT - 1,
+      worker_stack, sizeof(worker_stack),
+      worker_wrap, NULL);
+   while (!test_done)
+      test_reqtick();
+   os_task_join(&task_worker);
+
+#ifdef OS_CONFIG_TIMERSLACK
+/* scenario 4 */
+   /* slack of cascaded timeout is applied only once, timer without other
+    * timers burns off at the end of its slack window */
+   timer_long_cnt = 0;
+   start64 = os_ticks_now64();
+   os_timer_create_slack(
+      &timer_long, timer_long_proc, NULL,
+      TEST_TIMEOUT_LONG - TEST_SLACK, 0, TEST_SLACK);
+   test_assert(timer_long.ticks_ext > 0);
+   test_wait_long(start64);
+   test_assert(start64 + TEST_TIMEOUT_LONG == timer_long_fired);
+   os_timer_destroy(&timer_long);
+#endif
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 2,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Ticks16");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
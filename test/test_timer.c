@@ -40,6 +40,7 @@
 #include "os_test.h"
 
 #define TEST_TIMER_NBR ((size_t)256)
+#define TEST_TIMER_LONG ((uint32_t)UINT16_MAX + 4464)
 
 static os_task_t task_main;
 static OS_TASKSTACK task_main_stack[OS_STACK_MINSIZE];
@@ -198,6 +199,37 @@ int task_test1c_proc(void *OS_UNUSED(param))
    return 0;
 }
 
+/**
+ * Test1 task procedure
+ * Check timeouts which exceed the 16 bit range
+ */
+int task_test1d_proc(void *OS_UNUSED(param))
+{
+   uint32_t i;
+
+   /* clean the clbck mark table */
+   memset(timer_clbck, 0, sizeof(timer_clbck));
+
+   /* create timer with timeout above UINT16_MAX */
+   os_timer_create(&timers[0], timer_proc, (void*)0, TEST_TIMER_LONG, 0);
+
+   for (i = 0; i < TEST_TIMER_LONG - 1; i++)
+      test_reqtick();
+
+   /* check that this timer did not expired */
+   test_assert(false == timer_clbck[0]);
+
+   /* generate 1 additional tick, timer[0] should expire */
+   test_reqtick();
+   test_assert(true == timer_clbck[0]);
+
+   /* clean up */
+   os_timer_destroy(&timers[0]);
+
+   test_debug("subtest 1d OK");
+   return 0;
+}
+
 /**
  * Test2 task procedure
  * Check if timers are properly reloaded in defined periods
@@ -235,13 +267,116 @@ int task_test2_proc(void *OS_UNUSED(param))
    return 0;
 }
 
+/**
+ * Test3 task procedure
+ * Check the tick counter and interval calculation
+ */
+int task_test3_proc(void *OS_UNUSED(param))
+{
+   os_ticks_t ticks;
+   uint64_t ticks64;
+   size_t i;
+
+   /* interval calculation must handle counter overflow */
+   test_assert(0 == os_ticks_diff(5, 5));
+   test_assert(3 == os_ticks_diff(2, 5));
+   test_assert(4 == os_ticks_diff(OS_TICKS_MAX - 1, 2));
+   test_assert(1 == os_ticks_diff(OS_TICKS_MAX, 0));
+
+   /* both counters must advance in lockstep */
+   ticks = os_ticks_now();
+   ticks64 = os_ticks_now64();
+   test_assert((os_ticks_t)ticks64 == ticks);
+   for (i = 0; i < 100; i++) {
+      test_reqtick();
+      test_assert(os_ticks_diff(ticks, os_ticks_now()) == (os_ticks_t)(i + 1));
+      test_assert(os_ticks_now64() - ticks64 == (uint64_t)(i + 1));
+   }
+   test_assert((os_ticks_t)os_ticks_now64() == os_ticks_now());
+
+   test_debug("subtest 3 OK");
+   return 0;
+}
+
+/**
+ * Test4 task procedure
+ * Check batching of timers with slack
+ */
+int task_test4_proc(void *OS_UNUSED(param))
+{
+   size_t i;
+
+   memset(timer_clbck, 0, sizeof(timer_clbck));
+
+   /* timer[0] without slack burns off at 10, timer[1] window is 8..13,
+    * timer[2] window is 12..13 and timer[3] window is 20..23 */
+   os_timer_create(&timers[0], timer_proc, (void*)0, 10, 0);
+   os_timer_create_slack(&timers[1], timer_proc, (void*)1, 8, 0, 5);
+   os_timer_create_slack(&timers[2], timer_proc, (void*)2, 12, 0, 1);
+   os_timer_create_slack(&timers[3], timer_proc, (void*)3, 20, 0, 3);
+
+   /* nothing burns off before timer[0] even if timer[1] window started */
+   for (i = 0; i < 9; i++)
+      test_reqtick();
+   test_assert(false == timer_clbck[0]);
+   test_assert(false == timer_clbck[1]);
+
+   /* timer[1] is batched with timer[0], timer[2] window did not start yet */
+   test_reqtick();
+   test_assert(true == timer_clbck[0]);
+   test_assert(true == timer_clbck[1]);
+   test_assert(false == timer_clbck[2]);
+
+   /* timer[2] burns off at the end of its window since there is no other timer
+    * to batch with */
+   test_reqtick();
+   test_reqtick();
+   test_assert(false == timer_clbck[2]);
+   test_reqtick();
+   test_assert(true == timer_clbck[2]);
+
+   /* same for timer[3] */
+   for (i = 13; i < 22; i++)
+      test_reqtick();
+   test_assert(false == timer_clbck[3]);
+   test_reqtick();
+   test_assert(true == timer_clbck[3]);
+
+   for (i = 0; i < 4; i++)
+      os_timer_destroy(&timers[i]);
+
+   /* auto reload timers with slack are batched on each period, timer[1] has
+    * window 3..5 in each period and it is batched with timer[0] */
+   memset(timer_clbck, 0, sizeof(timer_clbck));
+   os_timer_create(&timers[0], timer_proc, (void*)0, 4, 4);
+   os_timer_create_slack(&timers[1], timer_proc, (void*)1, 3, 3, 2);
+   for (i = 0; i < 5; i++) {
+      test_reqtick();
+      test_reqtick();
+      test_reqtick();
+      test_assert(false == timer_clbck[1]);
+      test_reqtick();
+      test_assert(true == timer_clbck[0]);
+      test_assert(true == timer_clbck[1]);
+      memset(timer_clbck, 0, sizeof(timer_clbck));
+   }
+   os_timer_destroy(&timers[0]);
+   os_timer_destroy(&timers[1]);
+
+   test_debug("subtest 4 OK");
+   return 0;
+}
+
 int task_main_proc(void *OS_UNUSED(param))
 {
    task_test1_proc(NULL);
    task_test1a_proc(NULL);
    task_test1b_proc(NULL);
    task_test1c_proc(NULL);
+   task_test1d_proc(NULL);
    task_test2_proc(NULL);
+   task_test3_proc(NULL);
+   task_test4_proc(NULL);
 
    test_result(0);
    return 0;
@@ -0,0 +1,226 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os timer daemon
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_TIMER_NBR ((size_t)32)
+#define TEST_TIMEOUT ((os_ticks_t)5)
+
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+#ifdef OS_CONFIG_PARTITION
+static os_task_t task_hog;
+static OS_TASKSTACK hog_stack[OS_STACK_MINSIZE];
+static os_partition_t partition;
+static const os_partition_window_t partition_table[] = {
+   { &partition, 1000 },
+};
+#endif
+
+static os_timer_t timers[TEST_TIMER_NBR];
+static os_sem_t test_sem;
+static os_sem_t test_sem_timeout;
+static volatile unsigned test_clbck_cnt;
+static volatile unsigned test_tick_clbck_cnt;
+static volatile sig_atomic_t test_block;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Tick callback, called in the same ISR right after os_tick()
+ */
+static void test_tick(void)
+{
+   /* timer callbacks were not called from os_tick() */
+   test_tick_clbck_cnt = test_clbck_cnt;
+}
+
+static void timer_proc(void *OS_UNUSED(param))
+{
+   /* callbacks are called from daemon task */
+   test_assert(0 == isr_nesting);
+   test_assert(OS_CONFIG_TIMERDAEMON_PRIO == task_current->prio_current);
+
+   ++test_clbck_cnt;
+
+   if (test_block) {
+      /* callbacks are allowed to block */
+      test_block = 0;
+      test_assert(OS_OK == os_sem_down(&test_sem, OS_TIMEOUT_INFINITE));
+   }
+}
+
+#ifdef OS_CONFIG_PARTITION
+/**
+ * Task of partition which owns the whole schedule table, it keeps the CPU
+ * busy so background tasks are starved
+ */
+static int task_hog_proc(void *OS_UNUSED(param))
+{
+   os_ticks_t start;
+
+   test_clbck_cnt = 0;
+   start = os_ticks_now();
+   os_timer_create(&timers[0], timer_proc, NULL, TEST_TIMEOUT, 0);
+   while ((0 == test_clbck_cnt) &&
+          (os_ticks_diff(start, os_ticks_now()) < (10 * TEST_TIMEOUT)))
+      test_reqtick();
+   /* daemon was not starved by the window of partition */
+   test_assert(1 == test_clbck_cnt);
+   test_assert(TEST_TIMEOUT == os_ticks_diff(start, os_ticks_now()));
+   os_timer_destroy(&timers[0]);
+
+   /* let the coordinator run */
+   os_partition_assign(NULL, task_current);
+   return 0;
+}
+#endif
+
+/**
+ * Test coordinator, runs all test in unit. It has lower priority than daemon,
+ * so daemon calls the callbacks right after they were queued
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   size_t i;
+
+   os_sem_create(&test_sem, 0);
+   os_sem_create(&test_sem_timeout, 0);
+   test_setuptick(test_tick, 0);
+
+/* scenario 1 */
+   /* many timers expire at the same tick, none of callbacks is called from
+    * os_tick(), all are called by daemon before coordinator resumes */
+   for (i = 0; i < TEST_TIMER_NBR; i++)
+      os_timer_create(&timers[i], timer_proc, NULL, 1, 0);
+   test_reqtick();
+   test_assert(0 == test_tick_clbck_cnt);
+   test_assert(TEST_TIMER_NBR == test_clbck_cnt);
+   for (i = 0; i < TEST_TIMER_NBR; i++)
+      os_timer_destroy(&timers[i]);
+
+/* scenario 2 */
+   /* callback blocks, block timers of other tasks are still handled by
+    * os_tick() and queued callbacks wait for the daemon */
+   test_clbck_cnt = 0;
+   test_block = 1;
+   os_timer_create(&timers[0], timer_proc, NULL, 1, 0);
+   os_timer_create(&timers[1], timer_proc, NULL, 1, 0);
+   test_reqtick();
+   test_assert(1 == test_clbck_cnt);
+   test_setuptick(NULL, 1000000);
+   test_assert(OS_TIMEOUT == os_sem_down(&test_sem_timeout, 2));
+   test_setuptick(test_tick, 0);
+   test_assert(1 == test_clbck_cnt);
+   os_sem_up(&test_sem);
+   test_assert(2 == test_clbck_cnt);
+   os_timer_destroy(&timers[0]);
+   os_timer_destroy(&timers[1]);
+
+/* scenario 3 */
+   /* destroy of timer which expired but which callback was not called yet */
+   test_clbck_cnt = 0;
+   test_block = 1;
+   os_timer_create(&timers[0], timer_proc, NULL, 1, 0);
+   os_timer_create(&timers[1], timer_proc, NULL, 1, 0);
+   test_reqtick();
+   test_assert(1 == test_clbck_cnt);
+   os_timer_destroy(&timers[1]);
+   os_sem_up(&test_sem);
+   test_assert(1 == test_clbck_cnt);
+   os_timer_destroy(&timers[0]);
+
+/* scenario 4 */
+   /* auto reload timer which expires while its callback is still pending is
+    * called only once */
+   test_clbck_cnt = 0;
+   test_block = 1;
+   os_timer_create(&timers[0], timer_proc, NULL, 1, 0);
+   os_timer_create(&timers[1], timer_proc, NULL, 1, 1);
+   test_reqtick();
+   test_reqtick();
+   test_reqtick();
+   test_assert(1 == test_clbck_cnt);
+   os_sem_up(&test_sem);
+   test_assert(2 == test_clbck_cnt);
+   test_reqtick();
+   test_assert(3 == test_clbck_cnt);
+   os_timer_destroy(&timers[0]);
+   os_timer_destroy(&timers[1]);
+
+#ifdef OS_CONFIG_PARTITION
+/* scenario 5 */
+   /* daemon is not assigned to any partition, but it calls the callbacks also
+    * while the active partition has READY tasks */
+   os_partition_create(&partition);
+   os_task_create(
+      &task_hog, 1, hog_stack, sizeof(hog_stack), task_hog_proc, NULL);
+   os_partition_assign(&partition, &task_hog);
+   os_partition_schedule(partition_table, 1);
+   /* coordinator is in background, it resumes after hog leaves partition */
+   os_partition_schedule(NULL, 0);
+   os_task_join(&task_hog);
+#endif
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 2,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Timerdaemon");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
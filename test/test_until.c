@@ -0,0 +1,342 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test of task sleep, periodic tasks and absolute deadline variants of
+ *       blocking functions
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+#define TEST_PERIOD ((os_ticks_t)7)
+#define TEST_LOOPS ((size_t)10)
+
+static os_task_t task_coordinator;
+static os_task_t task_worker;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+static OS_TASKSTACK worker_stack[OS_STACK_MINSIZE];
+
+static os_sem_t test_sem;
+static os_waitqueue_t test_wq;
+static volatile bool test_done;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Worker for scenario 1, periodic loop with os_task_sleep_until()
+ */
+static int worker_sleep(void *OS_UNUSED(param))
+{
+   os_ticks_t deadline;
+   size_t i;
+
+   /* deadline which was already reached does not suspend the task */
+   deadline = os_ticks_now();
+   os_task_sleep_until(deadline);
+   os_task_sleep_until(deadline - 1);
+   test_assert(deadline == os_ticks_now());
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      deadline += TEST_PERIOD;
+      os_task_sleep_until(deadline);
+      /* task is released exactly at deadline tick */
+      test_assert(deadline == os_ticks_now());
+   }
+
+   test_done = true;
+   return 0;
+}
+
+/**
+ * Worker for scenario 2, os_sem_down_until()
+ */
+static int worker_sem(void *OS_UNUSED(param))
+{
+   os_ticks_t deadline;
+   size_t i;
+
+   /* deadline already reached, semaphore empty */
+   deadline = os_ticks_now();
+   test_assert(OS_TIMEOUT == os_sem_down_until(&test_sem, deadline));
+   test_assert(deadline == os_ticks_now());
+
+   /* deadline already reached, but semaphore has a signal */
+   os_sem_up(&test_sem);
+   test_assert(OS_OK == os_sem_down_until(&test_sem, deadline));
+
+   /* periodic timeouts at exact ticks */
+   for (i = 0; i < TEST_LOOPS; i++) {
+      deadline += TEST_PERIOD;
+      test_assert(OS_TIMEOUT == os_sem_down_until(&test_sem, deadline));
+      test_assert(deadline == os_ticks_now());
+   }
+
+   /* signal before deadline, coordinator will signal the semaphore */
+   deadline += TEST_PERIOD;
+   test_done = true;
+   test_assert(OS_OK == os_sem_down_until(&test_sem, deadline));
+   test_assert(os_ticks_diff(os_ticks_now(), deadline) > 0);
+
+   return 0;
+}
+
+/**
+ * Worker for scenario 3, os_waitqueue_wait_until()
+ */
+static int worker_waitqueue(void *OS_UNUSED(param))
+{
+   os_ticks_t deadline;
+   size_t i;
+
+   /* deadline already reached, task does not suspend and it is not 'prepared'
+    * anymore */
+   deadline = os_ticks_now();
+   os_waitqueue_prepare(&test_wq);
+   test_assert(OS_TIMEOUT == os_waitqueue_wait_until(deadline));
+   test_assert(deadline == os_ticks_now());
+   os_yield(); /* would assert if task would still be 'prepared' */
+
+   /* retry loop which does not need to recalculate the timeout */
+   for (i = 0; i < TEST_LOOPS; i++) {
+      deadline += TEST_PERIOD;
+      os_waitqueue_prepare(&test_wq);
+      test_assert(OS_TIMEOUT == os_waitqueue_wait_until(deadline));
+      test_assert(deadline == os_ticks_now());
+   }
+
+   /* wakeup before deadline */
+   deadline += TEST_PERIOD;
+   test_done = true;
+   os_waitqueue_prepare(&test_wq);
+   test_assert(OS_OK == os_waitqueue_wait_until(deadline));
+   test_assert(os_ticks_diff(os_ticks_now(), deadline) > 0);
+
+   return 0;
+}
+
+/**
+ * Worker for scenario 4, os_task_sleep()
+ */
+static int worker_relsleep(void *OS_UNUSED(param))
+{
+   os_ticks_t start;
+   size_t i;
+
+   for (i = 1; i < TEST_LOOPS; i++) {
+      start = os_ticks_now();
+      os_task_sleep(i);
+      test_assert(os_ticks_diff(start, os_ticks_now()) == (os_ticks_t)i);
+   }
+
+   test_done = true;
+   return 0;
+}
+
+/**
+ * Worker for scenario 5, periodic task with overruns
+ */
+static int worker_periodic(void *OS_UNUSED(param))
+{
+   os_ticks_t release;
+   size_t i;
+
+   release = os_ticks_now();
+   os_task_periodic_init(TEST_PERIOD);
+
+   for (i = 0; i < TEST_LOOPS; i++) {
+      test_assert(0 == os_task_wait_next_period());
+      release += TEST_PERIOD;
+      test_assert(release == os_ticks_now());
+   }
+
+   /* job finished exactly at the next release is not an overrun */
+   for (i = 0; i < TEST_PERIOD; i++)
+      test_reqtick();
+   test_assert(0 == os_task_wait_next_period());
+   release += TEST_PERIOD;
+   test_assert(release == os_ticks_now());
+
+   /* job took longer than two periods, two releases are skipped and the task
+    * keeps its phase */
+   for (i = 0; i < (2 * TEST_PERIOD) + 1; i++)
+      test_reqtick();
+   test_assert(2 == os_task_wait_next_period());
+   release += 3 * TEST_PERIOD;
+   test_assert(release == os_ticks_now());
+   test_assert(2 == task_current->period_overruns);
+
+   /* back on time */
+   test_assert(0 == os_task_wait_next_period());
+   release += TEST_PERIOD;
+   test_assert(release == os_ticks_now());
+   test_assert(2 == task_current->period_overruns);
+
+   /* job took exactly two periods, only the release in between is skipped
+    * while the release at current tick is valid */
+   for (i = 0; i < (2 * TEST_PERIOD); i++)
+      test_reqtick();
+   test_assert(1 == os_task_wait_next_period());
+   release += 2 * TEST_PERIOD;
+   test_assert(release == os_ticks_now());
+   test_assert(3 == task_current->period_overruns);
+
+   /* and the task keeps its phase */
+   test_assert(0 == os_task_wait_next_period());
+   release += TEST_PERIOD;
+   test_assert(release == os_ticks_now());
+
+   test_done = true;
+   return 0;
+}
+
+static void timer_dummy(void *OS_UNUSED(param))
+{
+   /* nothing to do */
+}
+
+/**
+ * Worker for scenario 6, timeouts with slack
+ */
+static int worker_slack(void *OS_UNUSED(param))
+{
+   os_timer_t timer;
+   os_ticks_t start;
+
+   os_task_timerslack_set(3);
+
+   /* without other timers timeout burns off at the end of slack window */
+   start = os_ticks_now();
+   test_assert(OS_TIMEOUT == os_sem_down(&test_sem, 2));
+   test_assert(os_ticks_diff(start, os_ticks_now()) == 5);
+
+   /* timeout is batched with other timer which burns off in the window */
+   start = os_ticks_now();
+   os_timer_create(&timer, timer_dummy, NULL, 3, 0);
+   test_assert(OS_TIMEOUT == os_sem_down(&test_sem, 2));
+   test_assert(os_ticks_diff(start, os_ticks_now()) == 3);
+   os_timer_destroy(&timer);
+
+   /* but never earlier than requested */
+   start = os_ticks_now();
+   os_timer_create(&timer, timer_dummy, NULL, 1, 0);
+   os_task_sleep(2);
+   test_assert(os_ticks_diff(start, os_ticks_now()) == 5);
+   os_timer_destroy(&timer);
+
+   os_task_timerslack_set(0);
+   test_done = true;
+   return 0;
+}
+
+/**
+ * Generates ticks until worker will finish its periodic part
+ */
+static void test_run(os_taskproc_t proc)
+{
+   test_done = false;
+   os_task_create(
+      &task_worker, OS_CONFIG_PRIOCNT - 1,
+      worker_stack, sizeof(worker_stack),
+      proc, NULL);
+   while (!test_done)
+      test_reqtick();
+}
+
+/**
+ * Test coordinator, runs all test in unit. It has lower priority than worker,
+ * so worker checks the tick counter right after it was released
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   os_sem_create(&test_sem, 0);
+   os_waitqueue_create(&test_wq);
+
+/* scenario 1 */
+   test_run(worker_sleep);
+   os_task_join(&task_worker);
+
+/* scenario 2 */
+   test_run(worker_sem);
+   test_reqtick();
+   os_sem_up(&test_sem);
+   os_task_join(&task_worker);
+
+/* scenario 3 */
+   test_run(worker_waitqueue);
+   test_reqtick();
+   os_waitqueue_wakeup(&test_wq, 1);
+   os_task_join(&task_worker);
+
+/* scenario 4 */
+   test_run(worker_relsleep);
+   os_task_join(&task_worker);
+
+/* scenario 5 */
+   test_run(worker_periodic);
+   os_task_join(&task_worker);
+
+/* scenario 6 */
+   test_run(worker_slack);
+   os_task_join(&task_worker);
+
+   os_waitqueue_destroy(&test_wq);
+   os_sem_destroy(&test_sem);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 2,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Until");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
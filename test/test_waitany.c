@@ -0,0 +1,332 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test os_wait_any() routines
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include "os.h"
+#include "os_test.h"
+
+static os_task_t task_worker[3];
+static OS_TASKSTACK task_stack[3][OS_STACK_MINSIZE];
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+static os_sem_t test_sem[2];
+static os_waitqueue_t test_wq;
+
+static volatile sig_atomic_t test_atomic;
+static volatile bool test_isr_wakeup;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Tick callback which signalizes the wait_queue from ISR on request
+ */
+static void test_wakeup_clbck(void)
+{
+   if (test_isr_wakeup) {
+      os_waitqueue_wakeup(&test_wq, 1);
+      test_isr_wakeup = false;
+   }
+}
+
+/**
+ * Test scenario:
+ * Task H suspends on two semaphores and wait_queue at once. Task L signalizes
+ * them one by one, H checks which one fired. L also checks that H does not
+ * remain linked to objects which did not fire.
+ */
+int test_scen1_workerH(void *OS_UNUSED(param))
+{
+   int ret;
+   uint_fast8_t idx;
+   os_waitnode_t nodes[3];
+
+   os_waitnode_sem(&nodes[0], &test_sem[0]);
+   os_waitnode_sem(&nodes[1], &test_sem[1]);
+   os_waitnode_waitqueue(&nodes[2], &test_wq);
+
+   /* nothing was signalized yet */
+   ret = os_wait_any(nodes, 3, OS_TIMEOUT_TRY, &idx);
+   test_assert(OS_WOULDBLOCK == ret);
+
+   /* suspend, L will signalize second semaphore */
+   ret = os_wait_any(nodes, 3, OS_TIMEOUT_INFINITE, &idx);
+   test_assert(0 == ret);
+   test_assert(1 == idx);
+   test_assert(1 == test_atomic);
+   test_atomic = 2;
+
+   /* suspend, L will signalize wait_queue */
+   ret = os_wait_any(nodes, 3, OS_TIMEOUT_INFINITE, &idx);
+   test_assert(0 == ret);
+   test_assert(2 == idx);
+   test_assert(3 == test_atomic);
+   test_atomic = 4;
+
+   /* suspend only on second semaphore, L will signalize first semaphore in
+    * the meantime */
+   ret = os_sem_down(&test_sem[1], OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+   test_assert(5 == test_atomic);
+
+   /* signal was accumulated in first semaphore and it should be consumed
+    * without suspend */
+   ret = os_wait_any(nodes, 3, OS_TIMEOUT_INFINITE, &idx);
+   test_assert(0 == ret);
+   test_assert(0 == idx);
+   test_atomic = 6;
+
+   /* use os_waitqueue_prepare(), wait_queue must be one of the nodes */
+   os_waitqueue_prepare(&test_wq);
+   ret = os_wait_any(nodes, 3, OS_TIMEOUT_INFINITE, &idx);
+   test_assert(0 == ret);
+   test_assert(2 == idx);
+   test_assert(7 == test_atomic);
+   test_atomic = 8;
+
+   /* L will destroy the first semaphore */
+   ret = os_wait_any(nodes, 3, OS_TIMEOUT_INFINITE, &idx);
+   test_assert(OS_DESTROYED == ret);
+   test_assert(0 == idx);
+   test_assert(9 == test_atomic);
+   test_atomic = 10;
+
+   return 0;
+}
+
+int test_scen1_workerL(void *OS_UNUSED(param))
+{
+   test_assert(0 == test_atomic);
+   test_atomic = 1;
+
+   /* wake up H, by second semaphore */
+   os_sem_up(&test_sem[1]);
+   test_assert(2 == test_atomic);
+   test_atomic = 3;
+   /* signal was consumed by H */
+   test_assert(0 == test_sem[1].value);
+
+   /* wake up H by wait_queue */
+   os_waitqueue_wakeup(&test_wq, OS_WAITQUEUE_ALL);
+   test_assert(4 == test_atomic);
+
+   /* H is not suspended on first semaphore, so this signal will be
+    * accumulated */
+   os_sem_up(&test_sem[0]);
+   test_assert(1 == test_sem[0].value);
+   test_atomic = 5;
+   os_sem_up(&test_sem[1]);
+   test_assert(6 == test_atomic);
+   test_assert(0 == test_sem[0].value);
+   test_assert(0 == test_sem[1].value);
+
+   /* H suspended after os_waitqueue_prepare() */
+   test_atomic = 7;
+   os_waitqueue_wakeup(&test_wq, 1);
+   test_assert(8 == test_atomic);
+
+   /* H suspended again */
+   test_atomic = 9;
+   os_sem_destroy(&test_sem[0]);
+   test_assert(10 == test_atomic);
+
+   return 0;
+}
+
+/**
+ * Test scenario:
+ * Task H suspended by os_wait_any() and task M suspended by os_sem_down()
+ * compete for the same semaphore. Signals should be delivered in priority
+ * order regardless of the API used for suspend.
+ */
+int test_scen2_workerH(void *OS_UNUSED(param))
+{
+   int ret;
+   uint_fast8_t idx;
+   os_waitnode_t nodes[2];
+
+   os_waitnode_waitqueue(&nodes[0], &test_wq);
+   os_waitnode_sem(&nodes[1], &test_sem[0]);
+
+   ret = os_wait_any(nodes, 2, OS_TIMEOUT_INFINITE, &idx);
+   test_assert(0 == ret);
+   test_assert(1 == idx);
+   test_assert(0 == test_atomic);
+   test_atomic = 1;
+
+   return 0;
+}
+
+int test_scen2_workerM(void *OS_UNUSED(param))
+{
+   int ret;
+
+   ret = os_sem_down(&test_sem[0], OS_TIMEOUT_INFINITE);
+   test_assert(0 == ret);
+   test_assert(1 == test_atomic);
+   test_atomic = 2;
+
+   return 0;
+}
+
+int test_scen2_workerL(void *OS_UNUSED(param))
+{
+   /* first signal should go to H */
+   os_sem_up(&test_sem[0]);
+   test_assert(1 == test_atomic);
+
+   /* second one to M */
+   os_sem_up(&test_sem[0]);
+   test_assert(2 == test_atomic);
+
+   /* H should not be linked with wait_queue any more */
+   os_waitqueue_wakeup(&test_wq, OS_WAITQUEUE_ALL);
+   test_atomic = 3;
+
+   return 0;
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   int ret;
+   uint16_t i;
+   uint_fast8_t idx;
+   os_waitnode_t nodes[2];
+   os_ticks_t ticks_start;
+
+/* scenario 1 */
+   os_sem_create(&test_sem[0], 0);
+   os_sem_create(&test_sem[1], 0);
+   os_waitqueue_create(&test_wq);
+   test_atomic = 0;
+   os_task_create(
+      &task_worker[0], 3,
+      task_stack[0], sizeof(task_stack[0]),
+      test_scen1_workerH, NULL);
+   os_task_create(
+      &task_worker[1], 1,
+      task_stack[1], sizeof(task_stack[1]),
+      test_scen1_workerL, NULL);
+   for (i = 0; i < 2; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(10 == test_atomic);
+
+/* scenario 2 */
+   os_taskproc_t scen2_worker_proc[] = {
+      test_scen2_workerH,
+      test_scen2_workerM,
+      test_scen2_workerL
+   };
+   os_sem_create(&test_sem[0], 0);
+   test_atomic = 0;
+   for (i = 0; i < 3; i++) {
+      os_task_create(
+         &task_worker[i], 3 - i,
+         task_stack[i], sizeof(task_stack[i]),
+         scen2_worker_proc[i], NULL);
+   }
+   for (i = 0; i < 3; i++)
+      os_task_join(&task_worker[i]);
+   test_assert(3 == test_atomic);
+   test_assert(0 == test_sem[0].value);
+
+/* scenario 3 */
+   /* timeout, nobody will signalize objects */
+   os_waitnode_sem(&nodes[0], &test_sem[0]);
+   os_waitnode_waitqueue(&nodes[1], &test_wq);
+   test_setuptick(NULL, 1000000);
+   ticks_start = os_ticks_now();
+   ret = os_wait_any(nodes, 2, 5, &idx);
+   test_assert(OS_TIMEOUT == ret);
+   test_assert(os_ticks_diff(ticks_start, os_ticks_now()) >= 4);
+   /* idx is not valid in case of timeout */
+   test_assert(idx >= 2);
+   /* nodes are not linked any more */
+   os_sem_up(&test_sem[0]);
+   test_assert(1 == test_sem[0].value);
+
+/* scenario 4 */
+   /* scheduler locked by caller is not confused with os_waitqueue_prepare(),
+    * signal is consumed from semaphore and the lock is kept */
+   os_scheduler_lock();
+   ret = os_wait_any(nodes, 2, OS_TIMEOUT_TRY, &idx);
+   test_assert(OS_OK == ret);
+   test_assert(0 == idx);
+   test_assert(0 == test_sem[0].value);
+   ret = os_wait_any(nodes, 2, OS_TIMEOUT_TRY, &idx);
+   test_assert(OS_WOULDBLOCK == ret);
+   os_scheduler_unlock(false);
+
+   /* prepared wait_queue does not need to be the first node. ISR wakes it up
+    * before os_wait_any() is called */
+   test_setuptick(test_wakeup_clbck, 0);
+   os_waitqueue_prepare(&test_wq);
+   test_isr_wakeup = true;
+   test_reqtick();
+   test_assert(!test_isr_wakeup);
+   ret = os_wait_any(nodes, 2, OS_TIMEOUT_INFINITE, &idx);
+   test_assert(OS_OK == ret);
+   test_assert(1 == idx);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Waitany");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
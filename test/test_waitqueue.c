@@ -41,6 +41,7 @@
 
 static volatile uint8_t global_tick_cnt = 0;
 static volatile uint8_t irq_trigger_tick = 0;
+static volatile uint8_t irq_trigger_nbr = 2;
 static os_waitqueue_t *irq_trigger_waitqueue = NULL;
 static bool sleeper_wokenup = false;
 
@@ -483,6 +484,82 @@ int testcase_wakeup_hiprio(void)
    return 0;
 }
 
+/* this test checks if wakeup from ISR which interrupts the task in 'prepared'
+ * state is fair in scope of priorities. ISR wakes up single task while main task
+ * is prepared to suspend but there is already suspended task with higher
+ * priority. The suspended task should be woken up while main task should
+ * suspend (and timeout) */
+int testcase_isr_wakeup_fair(void)
+{
+   int ret;
+   os_waitqueue_t waitqueue;
+   victim_task_param_t param;
+
+   os_waitqueue_create(&waitqueue);
+
+   test_verbose_debug("creating hiprio task");
+   param.waitqueue = &waitqueue;
+   param.idx = 0;
+   param.wokenup = false;
+   param.repeat = false;
+   os_task_create(
+      &task_victim[0], OS_CONFIG_PRIOCNT - 2,
+      task_victim_stack[0], sizeof(task_victim_stack[0]),
+      hiprio_task_proc, &param);
+
+   /* hiprio task is already suspended, ISR will wake up single task in tick 1
+    * while main is spinning in 'prepared' state */
+   global_tick_cnt = 0; /* reset tickcnt's */
+   irq_trigger_waitqueue = &waitqueue;
+   irq_trigger_tick = 1;
+   irq_trigger_nbr = 1;
+   testcase_isr_wakeup_impl(true, &waitqueue, true, true);
+   test_assert(true == param.wokenup);
+
+   irq_trigger_waitqueue = NULL;
+   irq_trigger_tick = 0;
+   irq_trigger_nbr = 2;
+
+   ret = os_task_join(&task_victim[0]);
+   test_assert(0 == ret);
+
+   os_waitqueue_destroy(&waitqueue);
+
+   return 0;
+}
+
+/* regression test, wakeup from ISR while task is 'prepared' has to report
+ * OS_OK even if previous os_waitqueue_wait() left OS_TIMEOUT in block_code */
+int testcase_isr_wakeup_after_timeout(void)
+{
+   os_waitqueue_t waitqueue;
+   os_retcode_t ret;
+
+   os_waitqueue_create(&waitqueue);
+
+   irq_trigger_waitqueue = NULL;
+   os_waitqueue_prepare(&waitqueue);
+   ret = os_waitqueue_wait(2);
+   test_assert(OS_TIMEOUT == ret);
+
+   global_tick_cnt = 0; /* reset tickcnt's */
+   irq_trigger_waitqueue = &waitqueue;
+   irq_trigger_tick = 1;
+   irq_trigger_nbr = 1;
+   os_waitqueue_prepare(&waitqueue);
+   while (global_tick_cnt < irq_trigger_tick); /* spin until ISR wakeup */
+   ret = os_waitqueue_wait(OS_TIMEOUT_INFINITE);
+   test_assert(OS_OK == ret);
+
+   irq_trigger_waitqueue = NULL;
+   irq_trigger_tick = 0;
+   irq_trigger_nbr = 2;
+
+   os_waitqueue_destroy(&waitqueue);
+
+   return 0;
+}
+
 /* \TODO write bit banging on two threads and waitqueue as test5
  * this will be the stress proff of concept */
 
@@ -501,6 +578,10 @@ int mastertask_proc(void *OS_UNUSED(param))
    test_debug("wakeup from destroy() OK");
    retv |= testcase_wakeup_hiprio();
    test_debug("wakeup hiprio OK");
+   retv |= testcase_isr_wakeup_fair();
+   test_debug("wakeup from ISR fair OK");
+   retv |= testcase_isr_wakeup_after_timeout();
+   test_debug("wakeup from ISR after timeout OK");
 
    test_result(retv);
    return 0;
@@ -513,9 +594,10 @@ void test_tick(void)
    global_tick_cnt++;
 
    if (irq_trigger_waitqueue && (irq_trigger_tick == global_tick_cnt)) {
-      /* passing 2 as nbr will wake up main and helper task, but not the sleeper */
+      /* by default passing 2 as nbr will wake up main and helper task, but not
+       * the sleeper */
       test_verbose_debug("wakeup from ISR!!!");
-      os_waitqueue_wakeup(irq_trigger_waitqueue, 2);
+      os_waitqueue_wakeup(irq_trigger_waitqueue, irq_trigger_nbr);
    }
 }
 
@@ -0,0 +1,177 @@
+/*
+ * This file is a part of RadOs project
+ * Copyright (c) 2013, Radoslaw Biernacki <radoslaw.biernacki@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1) Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2) Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3) No personal names or organizations' names associated with the 'RadOs'
+ *    project may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE RADOS PROJECT AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * /file Test zero-latency interrupts (linux port only)
+ * /ingroup tests
+ *
+ * /{
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "os.h"
+#include "os_test.h"
+
+static os_task_t task_coordinator;
+static OS_TASKSTACK coordinator_stack[OS_STACK_MINSIZE];
+
+static os_sem_t test_sem;
+static volatile sig_atomic_t test_ticks;
+static volatile sig_atomic_t test_zerolat;
+static volatile sig_atomic_t test_zerolat_isrnesting;
+static volatile sig_atomic_t test_zerolat_call;
+static volatile sig_atomic_t test_tick_raise;
+
+void test_idle(void)
+{
+   /* nothing to do */
+}
+
+/**
+ * Zero-latency interrupt handler, it never calls the OS functions unless test
+ * checks the rule
+ */
+static void sig_zerolat(
+   int OS_UNUSED(signum),
+   siginfo_t *OS_UNUSED(siginfo),
+   void *OS_UNUSED(ucontext))
+{
+   arch_zerolat_enter();
+   ++test_zerolat;
+   test_zerolat_isrnesting = isr_nesting;
+   if (test_zerolat_call)
+      os_sem_up(&test_sem); /* forbidden, has to halt the system */
+   arch_zerolat_exit();
+}
+
+/**
+ * Tick callback, kernel-aware interrupt
+ */
+static void test_tick(void)
+{
+   sig_atomic_t zerolat;
+
+   ++test_ticks;
+   if (test_tick_raise) {
+      /* zero-latency interrupt preempts the kernel-aware one */
+      zerolat = test_zerolat;
+      raise(ARCH_ZEROLAT_SIGNAL);
+      test_assert(zerolat + 1 == test_zerolat);
+      test_assert(1 == test_zerolat_isrnesting);
+   }
+}
+
+/**
+ * Test coordinator, runs all test in unit
+ */
+int test_coordinator(void *OS_UNUSED(param))
+{
+   arch_criticalstate_t cristate;
+   pid_t pid;
+   int status;
+   int ret;
+   struct sigaction zerolat_sigaction = {
+      .sa_sigaction  = sig_zerolat,
+      .sa_mask       = arch_crit_signals, /* kernel-aware interrupts cannot
+                                           * preempt zero-latency one */
+      .sa_flags      = SA_SIGINFO,
+   };
+
+   os_sem_create(&test_sem, 0);
+   ret = sigaction(ARCH_ZEROLAT_SIGNAL, &zerolat_sigaction, NULL);
+   test_assert(0 == ret);
+   test_setuptick(test_tick, 0);
+
+/* scenario 1 */
+   /* kernel-aware interrupt is postponed by critical section while
+    * zero-latency one is not */
+   arch_critical_enter(cristate);
+   raise(SIGALRM);
+   raise(ARCH_ZEROLAT_SIGNAL);
+   test_assert(0 == test_ticks);
+   test_assert(1 == test_zerolat);
+   test_assert(0 == test_zerolat_isrnesting);
+   arch_critical_exit(cristate);
+   test_assert(1 == test_ticks);
+
+/* scenario 2 */
+   /* zero-latency interrupt preempts the kernel-aware ISR, and it does not
+    * take part in ISR nesting */
+   test_tick_raise = 1;
+   test_reqtick();
+   test_tick_raise = 0;
+   test_assert(2 == test_ticks);
+   test_assert(2 == test_zerolat);
+
+/* scenario 3 */
+   /* call of OS function from zero-latency handler halts the system, check it
+    * in child process */
+   pid = fork();
+   test_assert(pid >= 0);
+   if (0 == pid) {
+      test_zerolat_call = 1;
+      raise(ARCH_ZEROLAT_SIGNAL);
+      _exit(0); /* should not get here */
+   }
+   while ((ret = waitpid(pid, &status, 0)) < 0)
+      test_assert(EINTR == errno);
+   test_assert(ret == pid);
+   test_assert(WIFSIGNALED(status));
+   test_assert(SIGABRT == WTERMSIG(status));
+   test_assert(0 == test_sem.value);
+
+   test_result(0);
+   return 0;
+}
+
+void test_init(void)
+{
+   os_task_create(
+      &task_coordinator, OS_CONFIG_PRIOCNT - 1,
+      coordinator_stack, sizeof(coordinator_stack),
+      test_coordinator, NULL);
+}
+
+int main(void)
+{
+   os_init();
+   test_setupmain("Test_Zerolat");
+   test_init();
+   os_start(test_idle);
+
+   return 0;
+}
+
+/** /} */
@@ -34,4 +34,5 @@ STYLE = uncrustify --no-backup -lC
 CP    = cp -p
 RM    = rm -f
 MV    = mv
+MKDIR = mkdir -p
 